@@ -0,0 +1,67 @@
+#ifndef BM_COUNTERS_H_
+#define BM_COUNTERS_H_
+
+#include "utils/alloc_tracker.hpp"
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Counters shared by the benchmarks of the NMPC pipeline
+ */
+namespace bm
+{
+    /**
+     * Heap allocations of the process so far
+     *
+     * Every benchmark links the allocation hooks, see utils/alloc_tracker.hpp
+     */
+    inline uint64_t allocations()
+    {
+        return alloc::total().allocations;
+    }
+
+    /**
+     * Counter reported per iteration of the benchmark loop
+     *
+     * @param total: Total over all iterations
+     */
+    inline benchmark::Counter perIteration(double total)
+    {
+        return benchmark::Counter(total, benchmark::Counter::kAvgIterations);
+    }
+
+    /**
+     * Hardware performance counters over a measured region, reported per iteration
+     *
+     * Opt in with GNT_PERF_EVENTS=1, reads cycles, instructions, cache misses and branch misses of the
+     * calling thread with perf_event_open. Events the kernel or the container refuses are left out of
+     * the report, so are all of them without perf_event_open or without the opt in. Declare it right
+     * before the benchmark loop to count the whole loop, or bracket a region with stop and start.
+     */
+    class PerfScope
+    {
+    public:
+        explicit PerfScope(benchmark::State &bmState);
+
+        /// Stops counting and adds the counters to the benchmark
+        ~PerfScope();
+
+        PerfScope(const PerfScope &) = delete;
+
+        void start();
+        void stop();
+
+    private:
+        static const size_t N_EVENTS = 4;
+
+        benchmark::State &m_bmState;
+        bool m_running;
+        /// Counts at the last start, and accumulated over the stopped intervals
+        double m_start[N_EVENTS];
+        double m_total[N_EVENTS];
+    };
+} // namespace bm
+
+#endif
@@ -0,0 +1,291 @@
+#include "bm_counters.h"
+#include "genetic_algorithm/core.h"
+#include "genetic_algorithm/nsga2.h"
+#include "genetic_algorithm/operators.h"
+#include "genetic_algorithm/population.h"
+#include "utils/config_handler.hpp"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/**
+ * The GA engine without the NMPC, run it from the repository root for config/config-ga.yaml
+ *
+ * Operators are timed on plain genomes and evaluations for populations up to 1e5. Convergence is
+ * measured by running the whole Population with analytic test functions over the 7 weights in place
+ * of the control loop, so a change to the engine can be judged in seconds instead of hours.
+ */
+
+namespace
+{
+    typedef std::array<double, 7> Point;
+
+    /// Analytic test function, minimized over [lower, upper]^7
+    struct TestFunction
+    {
+        double lower, upper;
+        /// Value at which the run counts as converged
+        double target;
+        double (*f)(const Point &);
+    };
+
+    double sphere(const Point &x)
+    {
+        double sum = 0.0;
+        for (const double xi : x)
+            sum += xi * xi;
+
+        return sum;
+    }
+
+    double rastrigin(const Point &x)
+    {
+        double sum = 10.0 * x.size();
+        for (const double xi : x)
+            sum += xi * xi - 10.0 * cos(2 * M_PI * xi);
+
+        return sum;
+    }
+
+    double rosenbrock(const Point &x)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i + 1 < x.size(); i++)
+            sum += 100.0 * pow(x[i + 1] - x[i] * x[i], 2) + pow(1.0 - x[i], 2);
+
+        return sum;
+    }
+
+    const TestFunction FUNCTIONS[] = {
+        {-5.12, 5.12, 1e-2, sphere},
+        {-5.12, 5.12, 1.0, rastrigin},
+        {-2.048, 2.048, 1e-1, rosenbrock}};
+
+    const size_t MAX_GENERATIONS = 300;
+
+    /**
+     * Map the weights linearly from their bounds onto the domain of the function
+     */
+    Point toDomain(const mpc::Params::Weights &w, const TestFunction &function)
+    {
+        const auto &bounds = config::ConfigHandler<config::GA>::getMpcConfig().weight_bounds;
+
+        const std::pair<double, double> ranges[] = {bounds.w_vel, bounds.w_cte, bounds.w_etheta, bounds.w_omega,
+                                                    bounds.w_acc, bounds.w_omega_d, bounds.w_acc_d};
+        const double weights[] = {w.vel, w.cte, w.etheta, w.omega, w.acc, w.omega_d, w.acc_d};
+
+        Point x;
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            const double t = (weights[i] - ranges[i].first) / (ranges[i].second - ranges[i].first);
+            x[i] = function.lower + t * (function.upper - function.lower);
+        }
+
+        return x;
+    }
+
+    ga::core::Genome makeGenome()
+    {
+        ga::core::Genome genome;
+
+        for (size_t i = 0; i < 7; i++)
+            genome.addChoromosome(0.01, 100.0);
+
+        const double w = 100.0 * ga::random::uniform();
+        genome.encode({w, w / 2, w / 3, w / 4, w / 5, w / 6, w / 7});
+
+        return genome;
+    }
+
+    std::vector<ga::Evaluation> makeEvaluations(size_t n)
+    {
+        std::vector<ga::Evaluation> evaluations;
+        evaluations.reserve(n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            ga::fitness::metrics_t metrics{};
+            for (size_t m = 0; m < ga::fitness::N_TRACKING_METRICS; m++)
+                metrics[m] = ga::random::uniform();
+
+            evaluations.push_back({makeGenome(), metrics, ga::random::uniform(), 1});
+        }
+
+        return evaluations;
+    }
+} // namespace
+
+static void BM_BitFlip(benchmark::State &bmState)
+{
+    std::vector<ga::core::Genome> genomes(bmState.range(0));
+    std::generate(genomes.begin(), genomes.end(), makeGenome);
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+        for (const auto &genome : genomes)
+            benchmark::DoNotOptimize(ga::operators::mutation::bitFlip(genome, 0.01));
+
+    bmState.SetItemsProcessed(bmState.iterations() * genomes.size());
+}
+
+static void BM_UniformCrossover(benchmark::State &bmState)
+{
+    std::vector<ga::core::Genome> genomes(bmState.range(0));
+    std::generate(genomes.begin(), genomes.end(), makeGenome);
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+        for (size_t k = 0; k < genomes.size(); k++)
+            benchmark::DoNotOptimize(ga::operators::crossover::uniform(genomes[k], genomes[(k + 1) % genomes.size()]));
+
+    bmState.SetItemsProcessed(bmState.iterations() * genomes.size());
+}
+
+static void BM_Selection(benchmark::State &bmState)
+{
+    const std::vector<ga::Evaluation> generation = makeEvaluations(bmState.range(0));
+    const size_t poolSize = std::max<size_t>(1, generation.size() / 4);
+
+    bm::PerfScope perf(bmState);
+
+    // As Population::_matingPool does it: rescore a copy, rank it and take the fittest
+    for (auto _ : bmState)
+    {
+        std::vector<ga::Evaluation> ranked = generation;
+
+        for (auto &evaluation : ranked)
+            evaluation.fitness = ga::fitness::ObjFunction::score(evaluation.metrics);
+
+        std::stable_sort(ranked.begin(), ranked.end(),
+                         [](const ga::Evaluation &a, const ga::Evaluation &b) { return a.fitness > b.fitness; });
+
+        std::vector<ga::core::Genome> pool;
+        pool.reserve(poolSize);
+
+        for (size_t k = 0; k < poolSize; k++)
+            pool.push_back(ranked[k].genome);
+
+        benchmark::DoNotOptimize(pool.data());
+    }
+
+    bmState.SetItemsProcessed(bmState.iterations() * generation.size());
+}
+
+static void BM_SortHistory(benchmark::State &bmState)
+{
+    const std::vector<ga::Evaluation> history = makeEvaluations(bmState.range(0));
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        bmState.PauseTiming();
+        perf.stop();
+        std::vector<ga::Evaluation> sorted = history;
+        perf.start();
+        bmState.ResumeTiming();
+
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const ga::Evaluation &a, const ga::Evaluation &b) { return a.fitness > b.fitness; });
+
+        benchmark::DoNotOptimize(sorted.data());
+    }
+
+    bmState.SetItemsProcessed(bmState.iterations() * history.size());
+}
+
+static void BM_Nsga2Rank(benchmark::State &bmState)
+{
+    std::vector<ga::fitness::metrics_t> objectives;
+    for (const auto &evaluation : makeEvaluations(bmState.range(0)))
+        objectives.push_back(evaluation.metrics);
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+        benchmark::DoNotOptimize(ga::nsga2::rank(objectives));
+
+    bmState.SetItemsProcessed(bmState.iterations() * objectives.size());
+}
+
+static void BM_Convergence(benchmark::State &bmState)
+{
+    const TestFunction &function = FUNCTIONS[bmState.range(0)];
+    const size_t popSize = bmState.range(1);
+
+    double evaluations = 0.0, evaluationsToTarget = 0.0, generations = 0.0, reached = 0.0, best = 0.0;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        size_t count = 0, countAtTarget = 0;
+        double runBest = std::numeric_limits<double>::infinity();
+
+        const auto evaluator = [&](const mpc::Params::Weights &w) {
+            const double f = function.f(toDomain(w, function));
+
+            count++;
+            runBest = std::min(runBest, f);
+
+            if (f <= function.target && countAtTarget == 0)
+                countAtTarget = count;
+
+            // Any objective weighting ranks by f, the solver cost metrics stay 0
+            ga::fitness::metrics_t metrics{};
+            for (size_t m = 0; m < ga::fitness::N_TRACKING_METRICS; m++)
+                metrics[m] = f + 1.0;
+
+            return metrics;
+        };
+
+        ga::Population population(popSize, std::max<size_t>(2, popSize / 4), evaluator);
+        population.randDistInit();
+
+        size_t gen = 1;
+        for (; gen <= MAX_GENERATIONS; gen++)
+        {
+            population.mainLoop();
+
+            if (countAtTarget > 0 || gen == MAX_GENERATIONS)
+                break;
+
+            population.refresh(gen);
+        }
+
+        evaluations += count;
+        generations += gen;
+        best += runBest;
+
+        if (countAtTarget > 0)
+        {
+            evaluationsToTarget += countAtTarget;
+            reached++;
+        }
+    }
+
+    bmState.counters["evaluations_per_second"] = benchmark::Counter(evaluations, benchmark::Counter::kIsRate);
+    bmState.counters["evaluations_to_target"] = reached > 0 ? evaluationsToTarget / reached : 0.0;
+    bmState.counters["reached"] = bm::perIteration(reached);
+    bmState.counters["generations"] = bm::perIteration(generations);
+    bmState.counters["best"] = bm::perIteration(best);
+}
+
+static void convergenceArgs(benchmark::internal::Benchmark *bm)
+{
+    bm->ArgNames({"function", "population"});
+
+    for (int function = 0; function < 3; function++)
+        for (const int popSize : {20, 100, 1000})
+            bm->Args({function, popSize});
+}
+
+BENCHMARK(BM_BitFlip)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK(BM_UniformCrossover)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK(BM_Selection)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK(BM_SortHistory)->RangeMultiplier(10)->Range(100, 100000);
+BENCHMARK(BM_Nsga2Rank)->RangeMultiplier(10)->Range(100, 10000);
+BENCHMARK(BM_Convergence)->Apply(convergenceArgs)->Unit(benchmark::kMillisecond)->Iterations(5);
+
+BENCHMARK_MAIN();
@@ -1,7 +1,9 @@
+#include "bm_counters.h"
 #include "genetic_algorithm/core.h"
 #include "genetic_algorithm/operators.h"
 #include "model/differential_drive.h"
 #include "model/base_organism.h"
+#include "model/reference_path.h"
 #include "utils/config_handler.hpp"
 
 #include <benchmark/benchmark.h>
@@ -33,39 +35,16 @@ static void BM_NMPCloop(benchmark::State& bmState)
     dModel.setSampleTime(params.forward.dt);
     dModel.setInitState(model::State({-8.0, 1.5, -0.6, 0.0, 0.0, 0.0}));
 
-    std::array<double, 40> ptsx;
-    std::array<double, 40> ptsy;
-
     const model::State state = dModel.getState();
 
-    for (size_t i = 0; i < 40; i++)
-    {
-        ptsx[i] = state.x + i * 0.1;
-        ptsy[i] = 0.0;
-    }
-
-    const double px = state.x;
-    const double py = state.y;
-    const double theta = state.theta;
     const double v = state.linVel;
     double omega = state.angVel;
     double throttle = state.throttle;
 
-    for (size_t i = 0; i < ptsx.size(); i++)
-    {
-        const double shift_x = ptsx[i] - px;
-        const double shift_y = ptsy[i] - py;
-        ptsx[i] = shift_x * cos(-theta) - shift_y * sin(-theta);
-        ptsy[i] = shift_x * sin(-theta) + shift_y * cos(-theta);
-    }
-
-    double *ptrx = &ptsx[0];
-    Eigen::Map<Eigen::VectorXd> ptsx_transform(ptrx, 6);
-
-    double *ptry = &ptsy[0];
-    Eigen::Map<Eigen::VectorXd> ptsy_transform(ptry, 6);
-
-    const Eigen::VectorXd &coeffs = mpc::utils::polyfit(ptsx_transform, ptsy_transform, 3);
+    // Reference cubic in the robot frame, as BaseOrganism::followSetpoints takes it
+    model::ReferencePath::Tracker tracker(model::ReferencePath::xAxis().get());
+    const std::array<double, 4> cubic = tracker.localCubic(state.x, state.y, state.theta, model::ReferencePath::LOOKAHEAD);
+    const Eigen::VectorXd coeffs = Eigen::Map<const Eigen::Vector4d>(cubic.data());
 
     const double cte = mpc::utils::polyeval(coeffs, 0);
     const double etheta = -atan(coeffs[1]);
@@ -83,6 +62,7 @@ static void BM_NMPCloop(benchmark::State& bmState)
 
     mpc::MPC _mpc(params, coeffs);
 
+    bm::PerfScope perf(bmState);
     for (auto _ : bmState)
     {
         // This code gets timed
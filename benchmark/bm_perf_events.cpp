@@ -0,0 +1,184 @@
+#include "bm_counters.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct EventInfo
+    {
+        const char *name;
+        uint64_t config;
+    };
+
+#ifdef __linux__
+    const EventInfo EVENTS[] = {
+        {"cycles", PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_COUNT_HW_INSTRUCTIONS},
+        {"cache_misses", PERF_COUNT_HW_CACHE_MISSES},
+        {"branch_misses", PERF_COUNT_HW_BRANCH_MISSES}};
+#else
+    const EventInfo EVENTS[] = {{"cycles", 0}, {"instructions", 0}, {"cache_misses", 0}, {"branch_misses", 0}};
+#endif
+
+    const size_t N_EVENTS = sizeof(EVENTS) / sizeof(EVENTS[0]);
+
+    /// Counters of the process, opened on first use and counting from then on
+    class Events
+    {
+    public:
+        static Events &get()
+        {
+            static Events instance;
+            return instance;
+        }
+
+        bool open(size_t event) const
+        {
+            return m_fds[event] >= 0;
+        }
+
+        /**
+         * Read a counter, scaled up for the time the kernel multiplexed it out
+         *
+         * @return Count since the counter was opened, 0 if it is not
+         */
+        double read(size_t event) const
+        {
+#ifdef __linux__
+            // value, time enabled, time running
+            uint64_t values[3];
+
+            if (m_fds[event] < 0 || ::read(m_fds[event], values, sizeof(values)) != sizeof(values))
+                return 0.0;
+
+            return values[2] > 0 ? values[0] * (static_cast<double>(values[1]) / values[2]) : 0.0;
+#else
+            return 0.0;
+#endif
+        }
+
+    private:
+        Events()
+        {
+            for (size_t i = 0; i < N_EVENTS; i++)
+                m_fds[i] = -1;
+
+            const char *enabled = std::getenv("GNT_PERF_EVENTS");
+
+            if (!enabled || enabled[0] == '\0' || enabled[0] == '0')
+                return;
+
+#ifdef __linux__
+            int error = 0;
+
+            for (size_t i = 0; i < N_EVENTS; i++)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = EVENTS[i].config;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                // Calling thread on any CPU, counting right away
+                m_fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+                if (m_fds[i] < 0)
+                {
+                    error = errno;
+                    std::cerr << "[ Benchmark-WARN ]: No " << EVENTS[i].name << " counter: " << std::strerror(error) << "\n";
+                }
+            }
+
+            if (error == EACCES || error == EPERM)
+                std::cerr << "[ Benchmark-WARN ]: Lower /proc/sys/kernel/perf_event_paranoid or allow perf_event_open in the container\n";
+#else
+            std::cerr << "[ Benchmark-WARN ]: Hardware counters need perf_event_open, reporting wall time only\n";
+#endif
+        }
+
+        ~Events()
+        {
+#ifdef __linux__
+            for (size_t i = 0; i < N_EVENTS; i++)
+            {
+                if (m_fds[i] >= 0)
+                    close(m_fds[i]);
+            }
+#endif
+        }
+
+        int m_fds[N_EVENTS];
+    };
+} // namespace
+
+namespace bm
+{
+    PerfScope::PerfScope(benchmark::State &bmState) : m_bmState(bmState), m_running(false)
+    {
+        static_assert(PerfScope::N_EVENTS == ::N_EVENTS, "One slot per event");
+
+        for (size_t i = 0; i < N_EVENTS; i++)
+        {
+            m_start[i] = 0.0;
+            m_total[i] = 0.0;
+        }
+
+        start();
+    }
+
+    PerfScope::~PerfScope()
+    {
+        stop();
+
+        const Events &events = Events::get();
+
+        for (size_t i = 0; i < N_EVENTS; i++)
+        {
+            if (events.open(i))
+                m_bmState.counters[EVENTS[i].name] = perIteration(m_total[i]);
+        }
+
+        // Instructions per cycle
+        if (events.open(0) && events.open(1) && m_total[0] > 0)
+            m_bmState.counters["ipc"] = m_total[1] / m_total[0];
+    }
+
+    void PerfScope::start()
+    {
+        if (m_running)
+            return;
+
+        const Events &events = Events::get();
+
+        for (size_t i = 0; i < N_EVENTS; i++)
+            m_start[i] = events.read(i);
+
+        m_running = true;
+    }
+
+    void PerfScope::stop()
+    {
+        if (!m_running)
+            return;
+
+        const Events &events = Events::get();
+
+        for (size_t i = 0; i < N_EVENTS; i++)
+            m_total[i] += events.read(i) - m_start[i];
+
+        m_running = false;
+    }
+} // namespace bm
@@ -0,0 +1,460 @@
+#include "bm_counters.h"
+#include "model/base_organism.h"
+#include "model/differential_drive.h"
+#include "model/reference_path.h"
+#include "mpc_lib/event_trigger.h"
+#include "mpc_lib/horizon_scheduler.h"
+#include "mpc_lib/mpc.h"
+#include "mpc_lib/warm_start_cache.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Every stage of one NMPC control step, and the whole rollout of a genome
+ *
+ * Results go to data/bm_pipeline.json unless --benchmark_out is given, compare runs over time with
+ * scripts/python/bm_scaling.py
+ */
+
+namespace
+{
+    enum Regime
+    {
+        /// Weights the GA converged to for the default route
+        TUNED,
+        /// Errors dominate, loose on the controls
+        TRACKING,
+        /// Smooth controls dominate, loose on the errors
+        SMOOTH
+    };
+
+    const model::State INITIAL_STATE = {-8.0, 1.5, -0.6, 0.0, 0.0, 0.0};
+
+    mpc::Params makeParams(size_t timesteps, int regime)
+    {
+        mpc::Params params;
+
+        params.forward.timesteps = timesteps;
+        params.forward.dt = 0.1;
+
+        params.desired.vel = 0.5;
+        params.desired.cte = 0.0;
+        params.desired.etheta = 0.0;
+
+        params.limits.omega = {-2.0, 2.0};
+        params.limits.throttle = {-1.0, 1.0};
+
+        switch (regime)
+        {
+        case TRACKING:
+            params.weights = {10.0, 100.0, 100.0, 0.01, 0.01, 0.01, 0.01};
+            break;
+
+        case SMOOTH:
+            params.weights = {10.0, 1.0, 1.0, 100.0, 100.0, 100.0, 100.0};
+            break;
+
+        default:
+            params.weights.cte = 87.859183;
+            params.weights.etheta = 99.532785;
+            params.weights.vel = 54.116644;
+            params.weights.omega = 47.430096;
+            params.weights.acc = 2.185306;
+            params.weights.omega_d = 4.611500;
+            params.weights.acc_d = 66.870729;
+            break;
+        }
+
+        return params;
+    }
+
+    /// Points of the x axis ahead of the initial state, 0.1 apart, in the world frame
+    void makeWindow(std::vector<double> &xs, std::vector<double> &ys)
+    {
+        for (size_t i = 0; i < xs.size(); i++)
+        {
+            xs[i] = INITIAL_STATE.x + i * 0.1;
+            ys[i] = 0.0;
+        }
+    }
+} // namespace
+
+static void BM_FrameTransform(benchmark::State &bmState)
+{
+    const size_t points = bmState.range(0);
+
+    std::vector<double> xs(points), ys(points), robotX(points), robotY(points);
+    makeWindow(xs, ys);
+
+    const double theta = INITIAL_STATE.theta;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        for (size_t i = 0; i < points; i++)
+        {
+            const double shift_x = xs[i] - INITIAL_STATE.x;
+            const double shift_y = ys[i] - INITIAL_STATE.y;
+
+            robotX[i] = shift_x * cos(-theta) - shift_y * sin(-theta);
+            robotY[i] = shift_x * sin(-theta) + shift_y * cos(-theta);
+        }
+
+        benchmark::DoNotOptimize(robotX.data());
+        benchmark::DoNotOptimize(robotY.data());
+        benchmark::ClobberMemory();
+    }
+
+    bmState.SetItemsProcessed(bmState.iterations() * points);
+}
+
+static void BM_LocalCubic(benchmark::State &bmState)
+{
+    const auto path = model::ReferencePath::xAxis();
+    model::ReferencePath::Tracker tracker(path.get());
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+        benchmark::DoNotOptimize(tracker.localCubic(INITIAL_STATE.x, INITIAL_STATE.y, INITIAL_STATE.theta,
+                                                    model::ReferencePath::LOOKAHEAD));
+}
+
+static void BM_Polyfit(benchmark::State &bmState)
+{
+    const size_t points = bmState.range(0);
+    const int order = bmState.range(1);
+
+    std::vector<double> xs(points), ys(points);
+    makeWindow(xs, ys);
+
+    // Curved enough that every order has something to fit
+    for (size_t i = 0; i < points; i++)
+        ys[i] += 0.1 * sin(xs[i]);
+
+    const Eigen::VectorXd x = Eigen::Map<Eigen::VectorXd>(xs.data(), points);
+    const Eigen::VectorXd y = Eigen::Map<Eigen::VectorXd>(ys.data(), points);
+
+    const uint64_t allocations = bm::allocations();
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+        benchmark::DoNotOptimize(mpc::utils::polyfit(x, y, order));
+
+    bmState.counters["allocations"] = bm::perIteration(bm::allocations() - allocations);
+}
+
+static void BM_Polyeval(benchmark::State &bmState)
+{
+    Eigen::VectorXd coeffs(bmState.range(0) + 1);
+    for (int i = 0; i < coeffs.size(); i++)
+        coeffs[i] = 0.3 / (i + 1);
+
+    double x = 0.1;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        benchmark::DoNotOptimize(mpc::utils::polyeval(coeffs, x));
+        benchmark::DoNotOptimize(x);
+    }
+}
+
+static void BM_Solve(benchmark::State &bmState)
+{
+    const mpc::Params params = makeParams(bmState.range(0), bmState.range(1));
+
+    model::ReferencePath::Tracker tracker(model::ReferencePath::xAxis().get());
+    const std::array<double, 4> cubic = tracker.localCubic(INITIAL_STATE.x, INITIAL_STATE.y, INITIAL_STATE.theta,
+                                                           model::ReferencePath::LOOKAHEAD);
+    const Eigen::VectorXd coeffs = Eigen::Map<const Eigen::Vector4d>(cubic.data());
+
+    // First step of the control loop from rest, see BaseOrganism::followSetpoints
+    const double cte = mpc::utils::polyeval(coeffs, 0);
+    const double etheta = -atan(coeffs[1]);
+
+    Eigen::VectorXd state(6);
+    state << 0.0, 0.0, 0.0, 0.0, cte, etheta;
+
+    uint64_t iterations = 0, failures = 0;
+    const uint64_t allocations = bm::allocations();
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        // Constructed every step like the control loop does, the taping is part of the cost
+        mpc::MPC _mpc(params, coeffs);
+        Eigen::VectorXd x0 = state;
+
+        benchmark::DoNotOptimize(_mpc.solve(x0));
+
+        iterations += _mpc.stats().iterations;
+        failures += !_mpc.stats().success();
+    }
+
+    bmState.counters["ipopt_iterations"] = bm::perIteration(iterations);
+    bmState.counters["allocations"] = bm::perIteration(bm::allocations() - allocations);
+    bmState.counters["failures"] = failures;
+}
+
+static void BM_Rollout(benchmark::State &bmState)
+{
+    const mpc::Params params = makeParams(bmState.range(0), TUNED);
+    const model::TerminateOn<config::GA> term = {300};
+
+    model::BaseOrganism<config::GA> organism;
+    organism.setModelInitState(INITIAL_STATE);
+    organism.setRecording(false);
+
+    mpc::SolverProfile profile;
+    const uint64_t allocations = bm::allocations();
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        organism.refresh();
+        benchmark::DoNotOptimize(organism.followSetpoints(params, term));
+
+        profile.merge(organism.getSolverProfile());
+    }
+
+    const double steps = static_cast<double>(profile.solves());
+
+    bmState.counters["steps_per_second"] = benchmark::Counter(steps, benchmark::Counter::kIsRate);
+    bmState.counters["ipopt_iterations_per_step"] = profile.iterations().mean();
+    bmState.counters["solve_p99_us"] = profile.latency().percentile(99.0) * 1e-3;
+    bmState.counters["allocations_per_step"] = steps > 0 ? (bm::allocations() - allocations) / steps : 0.0;
+    bmState.counters["failures"] = profile.failures();
+}
+
+static void BM_EventTriggered(benchmark::State &bmState)
+{
+    const mpc::Params params = makeParams(12, TUNED);
+    const model::TerminateOn<config::GA> term = {300};
+
+    // Same tolerance on position (m), heading (rad) and velocity (m/s), in thousandths. 0 solves every step
+    const double tolerance = bmState.range(0) * 1e-3;
+
+    model::BaseOrganism<config::GA> organism;
+    organism.setModelInitState(INITIAL_STATE);
+    organism.setRecording(false);
+
+    if (tolerance > 0.0)
+        organism.setEventTrigger(mpc::EventTrigger({tolerance, tolerance, tolerance}));
+
+    mpc::SolverProfile profile;
+    double itae = 0.0;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        organism.refresh();
+        benchmark::DoNotOptimize(organism.followSetpoints(params, term));
+
+        profile.merge(organism.getSolverProfile());
+
+        // Raw ITAE of the cross track error, the fitness normalizes it per rollout
+        const model::Performance performance = organism.getPerformance();
+        for (size_t i = 0; i < performance.cteData.size(); i++)
+            itae += (i + 1) * params.forward.dt * abs(performance.cteData[i]) * params.forward.dt;
+    }
+
+    const double steps = static_cast<double>(profile.solves() + profile.skipped());
+
+    bmState.counters["steps_per_second"] = benchmark::Counter(steps, benchmark::Counter::kIsRate);
+    bmState.counters["skipped_fraction"] = steps > 0 ? profile.skipped() / steps : 0.0;
+    bmState.counters["itae_cte"] = bm::perIteration(itae);
+    bmState.counters["failures"] = profile.failures();
+}
+
+static void BM_AdaptiveHorizon(benchmark::State &bmState)
+{
+    const mpc::Params params = makeParams(12, TUNED);
+    const model::TerminateOn<config::GA> term = {300};
+
+    // 0 is the fixed 12 step horizon, the baseline of the others
+    const bool adaptive = bmState.range(0) > 0;
+    const size_t blocking = std::max<int64_t>(bmState.range(1), 1);
+
+    model::BaseOrganism<config::GA> organism;
+    organism.setModelInitState(INITIAL_STATE);
+    organism.setRecording(false);
+
+    if (adaptive || blocking > 1)
+        organism.setHorizonScheduler(mpc::HorizonScheduler({adaptive ? 6 : params.forward.timesteps, params.forward.timesteps, 2, 0.1, 0.02,
+                                                            50.0, blocking}));
+
+    mpc::SolverProfile profile;
+    double itae = 0.0;
+    const mpc::SolverTotals start = mpc::solverTotals();
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        organism.refresh();
+        benchmark::DoNotOptimize(organism.followSetpoints(params, term));
+
+        profile.merge(organism.getSolverProfile());
+
+        const model::Performance performance = organism.getPerformance();
+        for (size_t i = 0; i < performance.cteData.size(); i++)
+            itae += (i + 1) * params.forward.dt * abs(performance.cteData[i]) * params.forward.dt;
+    }
+
+    bmState.counters["mean_timesteps"] = profile.meanTimesteps();
+    bmState.counters["solve_mean_us"] = profile.latency().mean() * 1e-3;
+    bmState.counters["ipopt_iterations_per_step"] = profile.iterations().mean();
+    bmState.counters["itae_cte"] = bm::perIteration(itae);
+    bmState.counters["setups"] = mpc::solverTotals().setups - start.setups;
+    bmState.counters["failures"] = profile.failures();
+}
+
+static void BM_WarmStart(benchmark::State &bmState)
+{
+    const model::TerminateOn<config::GA> term = {300};
+    const bool cached = bmState.range(0) > 0;
+
+    // Weights around the tuned ones, as the organisms of a converging GA run
+    std::vector<mpc::Params> regimes;
+    for (const double factor : {1.0, 1.1, 0.9, 1.25})
+    {
+        mpc::Params params = makeParams(12, TUNED);
+        params.weights.cte *= factor;
+        params.weights.etheta /= factor;
+        params.weights.acc_d *= factor;
+        regimes.push_back(params);
+    }
+
+    model::BaseOrganism<config::GA> organism;
+    organism.setModelInitState(INITIAL_STATE);
+    organism.setRecording(false);
+
+    // Cold starts set the reference the warm started rollouts have to agree with
+    std::vector<std::vector<double>> reference;
+    for (const mpc::Params &params : regimes)
+    {
+        organism.refresh();
+        benchmark::DoNotOptimize(organism.followSetpoints(params, term));
+        reference.push_back(organism.getPerformance().cteData);
+    }
+
+    const auto cache = std::make_shared<mpc::WarmStartCache>(4096, 0.5);
+
+    if (cached)
+        organism.setWarmStartCache(cache);
+
+    mpc::SolverProfile profile;
+    double deviation = 0.0;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        for (size_t r = 0; r < regimes.size(); r++)
+        {
+            organism.refresh();
+            benchmark::DoNotOptimize(organism.followSetpoints(regimes[r], term));
+
+            profile.merge(organism.getSolverProfile());
+
+            const std::vector<double> cte = organism.getPerformance().cteData;
+            for (size_t i = 0; i < std::min(cte.size(), reference[r].size()); i++)
+                deviation = std::max(deviation, fabs(cte[i] - reference[r][i]));
+        }
+    }
+
+    const mpc::WarmStartCache::Stats stats = cache->stats();
+
+    bmState.counters["hit_rate"] = stats.hitRate();
+    bmState.counters["ipopt_iterations_per_step"] = profile.iterations().mean();
+    bmState.counters["iterations_saved"] = bm::perIteration(stats.iterationsSaved());
+    bmState.counters["fallbacks"] = stats.fallbacks;
+    bmState.counters["max_cte_deviation"] = deviation;
+    bmState.counters["failures"] = profile.failures();
+}
+
+static void BM_ModelStep(benchmark::State &bmState)
+{
+    model::DifferentialDrive dModel;
+    dModel.setSampleTime(0.1);
+    dModel.setInitState(INITIAL_STATE);
+
+    double omega = 0.3;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        dModel.step(0.5, omega);
+        benchmark::DoNotOptimize(dModel.getState());
+        benchmark::DoNotOptimize(omega);
+    }
+}
+
+static void polyfitArgs(benchmark::internal::Benchmark *bm)
+{
+    for (const int points : {6, 24})
+        for (const int order : {1, 3, 5})
+            bm->Args({points, order});
+}
+
+static void solveArgs(benchmark::internal::Benchmark *bm)
+{
+    bm->ArgNames({"N", "regime"});
+
+    for (const int timesteps : {5, 10, 20, 30, 40, 50})
+        for (const int regime : {TUNED, TRACKING, SMOOTH})
+            bm->Args({timesteps, regime});
+}
+
+BENCHMARK(BM_FrameTransform)->Arg(6)->Arg(24)->Arg(96);
+BENCHMARK(BM_LocalCubic);
+BENCHMARK(BM_Polyfit)->Apply(polyfitArgs);
+BENCHMARK(BM_Polyeval)->DenseRange(1, 5, 2);
+BENCHMARK(BM_Solve)->Apply(solveArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Rollout)->Arg(12)->ArgName("N")->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK(BM_EventTriggered)->Arg(0)->Arg(5)->Arg(20)->Arg(50)->ArgName("tol_milli")->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK(BM_AdaptiveHorizon)
+    ->ArgNames({"adaptive", "blocking"})
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({0, 2})
+    ->Args({1, 2})
+    ->Unit(benchmark::kMillisecond)
+    ->Iterations(3);
+BENCHMARK(BM_WarmStart)->Arg(0)->Arg(1)->ArgName("cached")->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK(BM_ModelStep);
+
+int main(int argc, char **argv)
+{
+    std::vector<char *> args(argv, argv + argc);
+
+    bool hasOut = false;
+    for (const char *arg : args)
+        hasOut |= std::strncmp(arg, "--benchmark_out=", 16) == 0;
+
+    // Machine readable results by default, so that scaling curves can be tracked across commits
+    std::string out = "--benchmark_out=data/bm_pipeline.json";
+    std::string format = "--benchmark_out_format=json";
+
+    if (!hasOut)
+    {
+        args.push_back(&out[0]);
+        args.push_back(&format[0]);
+    }
+
+    int count = static_cast<int>(args.size());
+    args.push_back(nullptr);
+
+    benchmark::Initialize(&count, args.data());
+
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+
+    return 0;
+}
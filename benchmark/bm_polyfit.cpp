@@ -0,0 +1,84 @@
+#include "bm_counters.h"
+#include "mpc_lib/mpc.h"
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+
+/**
+ * A rotated reference window like the control loops fit
+ */
+static void makeWindow(Eigen::Matrix<double, 6, 1> &xs, Eigen::Matrix<double, 6, 1> &ys)
+{
+    const double theta = -0.6;
+
+    for (int k = 0; k < 6; k++)
+    {
+        const double shift_x = 0.1 * k;
+        const double shift_y = -0.5;
+
+        xs[k] = shift_x * cos(theta) + shift_y * sin(theta);
+        ys[k] = -shift_x * sin(theta) + shift_y * cos(theta);
+    }
+}
+
+static void BM_PolyfitDynamic(benchmark::State &bmState)
+{
+    Eigen::Matrix<double, 6, 1> x, y;
+    makeWindow(x, y);
+
+    const Eigen::VectorXd xs = x, ys = y;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+        benchmark::DoNotOptimize(mpc::utils::polyfit(xs, ys, 3));
+}
+
+static void BM_PolyfitFixed(benchmark::State &bmState)
+{
+    Eigen::Matrix<double, 6, 1> xs, ys;
+    makeWindow(xs, ys);
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+        benchmark::DoNotOptimize(mpc::utils::polyfit<3, 6>(xs, ys));
+}
+
+static void BM_PolyevalPow(benchmark::State &bmState)
+{
+    Eigen::VectorXd coeffs(4);
+    coeffs << 0.3, -0.2, 0.05, 0.01;
+    double x = 0.1;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        double result = 0.0;
+
+        for (int i = 0; i < coeffs.size(); i++)
+            result += coeffs[i] * pow(x, i);
+
+        benchmark::DoNotOptimize(result);
+        benchmark::DoNotOptimize(x);
+    }
+}
+
+static void BM_PolyevalHorner(benchmark::State &bmState)
+{
+    Eigen::VectorXd coeffs(4);
+    coeffs << 0.3, -0.2, 0.05, 0.01;
+    double x = 0.1;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        benchmark::DoNotOptimize(mpc::utils::polyeval(coeffs, x));
+        benchmark::DoNotOptimize(x);
+    }
+}
+
+BENCHMARK(BM_PolyfitDynamic);
+BENCHMARK(BM_PolyfitFixed);
+BENCHMARK(BM_PolyevalPow);
+BENCHMARK(BM_PolyevalHorner);
+
+BENCHMARK_MAIN();
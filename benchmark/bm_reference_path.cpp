@@ -0,0 +1,60 @@
+#include "bm_counters.h"
+#include "model/reference_path.h"
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+
+/**
+ * Winding route of the given number of waypoints, 0.1 apart
+ */
+static std::shared_ptr<const model::ReferencePath> makeRoute(size_t waypoints)
+{
+    std::vector<double> xs(waypoints), ys(waypoints);
+
+    for (size_t i = 0; i < waypoints; i++)
+    {
+        xs[i] = i * 0.1;
+        ys[i] = 5.0 * sin(i * 0.002);
+    }
+
+    return std::make_shared<const model::ReferencePath>(xs, ys);
+}
+
+static void BM_TrackerUpdate(benchmark::State &bmState)
+{
+    const auto path = makeRoute(bmState.range(0));
+    model::ReferencePath::Tracker tracker(path.get());
+    size_t i = 0;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        // A robot moving half a waypoint per step, slightly off the route
+        const double x = (i % (2 * bmState.range(0))) * 0.05;
+        const double y = 5.0 * sin(x * 0.02) + 0.3;
+
+        benchmark::DoNotOptimize(tracker.update(x, y));
+
+        i++;
+    }
+}
+
+static void BM_NearestSegment(benchmark::State &bmState)
+{
+    const auto path = makeRoute(bmState.range(0));
+    size_t i = 0;
+
+    bm::PerfScope perf(bmState);
+    for (auto _ : bmState)
+    {
+        const double x = (i % (2 * bmState.range(0))) * 0.05;
+        benchmark::DoNotOptimize(path->nearest(x, 5.0 * sin(x * 0.02) + 0.3));
+
+        i++;
+    }
+}
+
+BENCHMARK(BM_TrackerUpdate)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_NearestSegment)->Arg(1000)->Arg(100000);
+
+BENCHMARK_MAIN();
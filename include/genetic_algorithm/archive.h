@@ -0,0 +1,158 @@
+#ifndef GA_ARCHIVE_H_
+#define GA_ARCHIVE_H_
+
+#include "primary.h"
+#include "genetic_algorithm/core.h"
+#include "genetic_algorithm/fitness.h"
+#include "utils/config_handler.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ga
+{
+    /**
+     * Append-only on-disk archive of evaluated genomes, shared across GA runs
+     * 
+     * The file is a flat sequence of fixed size binary records. Existing records are memory-mapped at
+     * startup and indexed in place, new records are appended with a single write each, so parallel
+     * workers and other processes can append concurrently. A partially written tail left by a crash
+     * is truncated on open and records failing their checksum are skipped.
+     * 
+     * Only records with the same configuration hash are used, the metrics of a genome are only
+     * comparable for an identical MPC setup.
+     */
+    class EvalArchive
+    {
+    public:
+        /// Number of chromosomes stored per record
+        static const size_t N_CHROMOSOMES = 7;
+
+        /// On-disk layout of a single evaluation
+        struct Record
+        {
+            uint32_t magic;
+            uint32_t checksum;
+            uint64_t configHash;
+            uint32_t genes[N_CHROMOSOMES];
+            uint32_t reserved;
+            double metrics[ga::fitness::N_METRICS];
+            double fitness;
+            double rolloutSeconds;
+        };
+
+        /**
+         * Constructor
+         * 
+         * @param filepath: Path of the archive file, created if it does not exist
+         * @param configHash: Hash of the configuration the evaluations are valid for
+         */
+        EvalArchive(const std::string &filepath, uint64_t configHash);
+
+        /// Destructor
+        ~EvalArchive();
+
+        /// Delete copy constructor
+        EvalArchive(const EvalArchive &) = delete;
+
+        /**
+         * Check if the archive file could be opened
+         * 
+         * @return True if usable, false otherwise
+         */
+        bool isOpen() const;
+
+        /**
+         * Look up the metrics of a previously evaluated genome
+         * 
+         * @param genome: Genome to look up
+         * @param metrics: Filled with the stored metrics on a hit
+         * 
+         * @return True on a hit, false otherwise
+         */
+        bool lookup(const ga::core::Genome &genome, ga::fitness::metrics_t &metrics) const;
+
+        /**
+         * Append an evaluation to the archive
+         * 
+         * @param genome: Evaluated genome
+         * @param metrics: Raw metrics of the rollout
+         * @param fitness: Fitness under the objective weights at the time of evaluation
+         * @param rolloutSeconds: Wall time of the rollout
+         */
+        void append(const ga::core::Genome &genome, const ga::fitness::metrics_t &metrics, double fitness, double rolloutSeconds);
+
+        /**
+         * Get the fittest archived genomes under the current objective weights
+         * 
+         * @param count: Maximum number of genomes
+         * @param prototype: Genome providing the chromosome bounds
+         * 
+         * @return Distinct genomes, fittest first
+         */
+        std::vector<ga::core::Genome> seeds(size_t count, const ga::core::Genome &prototype) const;
+
+        /// Number of usable records
+        size_t size() const;
+
+        /// Number of lookups so far
+        size_t lookups() const;
+
+        /// Number of lookups that hit
+        size_t hits() const;
+
+        /**
+         * Hash the parts of the configuration that affect the metrics of a genome
+         * 
+         * @param mpcConfig: MPC configuration
+         * @param iterations: Number of control loops per genome
+         * @param solverCost: Measure of the solver cost metrics
+         * 
+         * @return 64 bit FNV-1a hash
+         */
+        static uint64_t configHash(const config::MPC_Controller_GA &mpcConfig, size_t iterations,
+                                   ga::fitness::SolverCost solverCost);
+
+    private:
+        typedef std::array<uint32_t, N_CHROMOSOMES> Key;
+
+        struct KeyHash
+        {
+            size_t operator()(const Key &key) const;
+        };
+
+        /// Pack the genes of a genome
+        static Key _key(const ga::core::Genome &genome);
+
+        /// Checksum over everything after the checksum field
+        static uint32_t _checksum(const Record &record);
+
+        /**
+         * Map the existing records and index them
+         * 
+         * @return False if the file holds records of another layout
+         */
+        bool _load();
+
+        const uint64_t m_configHash;
+
+        int m_fd;
+        void *m_mapping;
+        size_t m_mappingSize;
+
+        /// Records of this configuration, pointing into the mapping or into m_appended
+        std::unordered_map<Key, const Record *, KeyHash> m_index;
+        std::deque<Record> m_appended;
+
+        mutable std::mutex m_mutex;
+        mutable std::atomic<size_t> m_lookups, m_hits;
+    };
+} // namespace ga
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef GA_CHECKPOINT_H_
+#define GA_CHECKPOINT_H_
+
+#include "primary.h"
+#include "genetic_algorithm/organism.h"
+#include "genetic_algorithm/fitness.h"
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace ga
+{
+    /**
+     * Full state of a GA run at the end of a generation
+     * 
+     * The evaluation history grows with every generation, it is kept in an append-only file next to
+     * the checkpoint and only the evaluations since the previous checkpoint are written
+     */
+    struct Checkpoint
+    {
+        /// Last completed generation
+        uint64_t generation;
+        /// Hash of the configuration the run was started with
+        uint64_t configHash;
+        /// Objective weights and decision tree progress
+        ga::fitness::ObjFunction::State objective;
+        /// Serialised state of the random engine
+        std::string rngState;
+        /// Ranked population of the generation
+        std::vector<ga::Evaluation> organisms;
+        /// Number of evaluations of the run so far
+        uint64_t historySize;
+        /// The last evaluations of the run, up to historySize. Writing only needs the ones since the
+        /// previous checkpoint, load() returns all of them
+        std::vector<ga::Evaluation> history;
+    };
+
+    /**
+     * Reading and writing of binary checkpoints
+     */
+    namespace checkpoint
+    {
+        /**
+         * Encode a checkpoint, without the evaluation history
+         * 
+         * @param cp: Checkpoint to encode
+         * 
+         * @return Binary representation, terminated by a checksum
+         */
+        std::string serialize(const Checkpoint &cp);
+
+        /**
+         * Decode a checkpoint, without the evaluation history
+         * 
+         * @param bytes: Binary representation as produced by serialize
+         * @param prototype: Genome providing the chromosome bounds
+         * @param cp: Filled with the decoded checkpoint, history is left empty
+         * 
+         * @return True on success, false if the data is truncated or corrupt
+         */
+        bool deserialize(const std::string &bytes, const ga::core::Genome &prototype, Checkpoint &cp);
+
+        /**
+         * Read a checkpoint and its evaluation history from file
+         * 
+         * @param filepath: Path of the checkpoint
+         * @param prototype: Genome providing the chromosome bounds
+         * @param cp: Filled with the decoded checkpoint and every evaluation of the run
+         * 
+         * @return True on success, false otherwise
+         */
+        bool load(const std::string &filepath, const ga::core::Genome &prototype, Checkpoint &cp);
+
+        /**
+         * Get the path of the evaluation history of a checkpoint
+         * 
+         * @param filepath: Path of the checkpoint
+         * 
+         * @return Path of the history file
+         */
+        std::string historyPath(const std::string &filepath);
+
+        /**
+         * Write checkpoints in the background
+         * 
+         * The checkpoint is encoded on the calling thread, which only takes a copy of the GA state. The
+         * new evaluations are appended to the history file and synced first, then the checkpoint is
+         * written to a temporary path, synced and renamed over the previous one, so a crash at any
+         * point leaves a complete checkpoint behind. Evaluations appended after it are cut off by the
+         * next write.
+         */
+        class Writer
+        {
+        public:
+            /// Waits for a pending write
+            ~Writer();
+
+            /**
+             * Start writing a checkpoint
+             * 
+             * Waits for the previous write if it is still in progress
+             * 
+             * @param filepath: Path of the checkpoint
+             * @param cp: Checkpoint to write, with at least the evaluations since the previous checkpoint
+             */
+            void write(const std::string &filepath, const Checkpoint &cp);
+
+            /**
+             * Wait for a pending write
+             * 
+             * @return True if the last write succeeded
+             */
+            bool wait();
+
+        private:
+            std::future<bool> m_pending;
+        };
+    } // namespace checkpoint
+} // namespace ga
+
+#endif
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <bitset>
+#include <random>
 #include <vector>
 
 /**
@@ -52,6 +53,9 @@ namespace ga::core
         /// Prettify output on console
         operator std::string() const;
 
+        /// Genomes are equal when all of their genes are
+        bool operator==(const Genome &other) const;
+
         /**
          * Encode weights into the genome
          * 
@@ -78,4 +82,26 @@ namespace ga::core
         std::vector<Chromosome> chromosomes;
     };
 } // namespace ga::core
+
+/**
+ * Random number generation for the genetic algorithm
+ * 
+ * All randomness of a run comes from a single engine, so that its state can be saved and restored
+ */
+namespace ga::random
+{
+    /**
+     * Get the engine shared by the operators and the initialisation
+     * 
+     * @return Reference to the engine
+     */
+    std::mt19937_64 &engine();
+
+    /**
+     * Draw a number from the uniform distribution
+     * 
+     * @return Value in [0, 1)
+     */
+    double uniform();
+} // namespace ga::random
 #endif
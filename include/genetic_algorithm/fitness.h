@@ -4,19 +4,108 @@
 #include "primary.h"
 #include "model/differential_drive.h"
 #include <array>
+#include <string>
+#include <vector>
 /**
  * Fitness function
  */
 namespace ga::fitness
 {
-    typedef std::array<double, 5> darr5_t;
+    /// ITAE of cte, etheta and velocity error, IAE of translational and rotational energy loss, median and p99 solver cost per step
+    static const size_t N_METRICS = 7;
+
+    /// Metrics that only depend on the tracking performance, the solver cost metrics follow them
+    static const size_t N_TRACKING_METRICS = 5;
+
+    typedef std::array<double, N_METRICS> metrics_t;
+
+    /// Measure of the solver cost of a control step
+    enum class SolverCost
+    {
+        /// Not part of the objective, the solver cost metrics stay 0
+        NONE,
+        /// Ipopt iterations, reproducible across machines
+        ITERATIONS,
+        /// Wall time of the solve in milliseconds
+        LATENCY
+    };
 
     class ObjFunction
     {
     public:
+        /// Objective weights and decision tree progress, everything needed to resume a run
+        struct State
+        {
+            metrics_t weights, prevMetrics;
+            bool started, terminated;
+        };
+
         /// Delete copy constructor
         ObjFunction(const ObjFunction &) = delete;
 
+        /**
+         * Get the state of the objective
+         * 
+         * Not to be called while a decision tree prompt is open
+         * 
+         * @return Current state
+         */
+        static State getState()
+        {
+            const ObjFunction &obj = get();
+            return {obj.m_Weights, obj.m_prevMetrics, obj.m_started, obj.m_terminated};
+        }
+
+        /**
+         * Restore a previously saved state of the objective
+         * 
+         * @param state: State as returned by getState
+         */
+        static void setState(const State &state)
+        {
+            ObjFunction &obj = get();
+
+            obj.m_Weights = state.weights;
+            obj.m_prevMetrics = state.prevMetrics;
+            obj.m_started = state.started;
+            obj.m_terminated = state.terminated;
+        }
+
+        /**
+         * Include the solver cost in the objective
+         * 
+         * Call before any metric is computed, metrics computed under another measure are not comparable
+         * 
+         * @param cost: Measure of the solver cost of a step
+         * @param weight: Objective weight of both the median and the p99 cost, ignored for SolverCost::NONE
+         */
+        static void setSolverCost(SolverCost cost, double weight)
+        {
+            ObjFunction &obj = get();
+
+            obj.m_solverCost = cost;
+            obj.m_Weights[5] = obj.m_Weights[6] = (cost == SolverCost::NONE) ? 0.0 : weight;
+        }
+
+        /**
+         * Parse the name of a solver cost measure
+         * 
+         * @param name: "none", "iterations" or "latency"
+         * 
+         * @return Measure, SolverCost::NONE for an unknown name
+         */
+        static SolverCost parseSolverCost(const std::string &name);
+
+        /**
+         * Get the number of metrics in use
+         * 
+         * @return N_METRICS if the solver cost is part of the objective, N_TRACKING_METRICS otherwise
+         */
+        static size_t metricCount()
+        {
+            return get().m_solverCost == SolverCost::NONE ? N_TRACKING_METRICS : N_METRICS;
+        }
+
         /**
          * Evaluate the fitness of an individual
          * 
@@ -26,12 +115,99 @@ namespace ga::fitness
          */
         static double evaluate(const model::Performance performance)
         {
-            return get()._evaluateImpl(performance);
+            return _scoreImpl(get()._getMetrics(performance), get().m_Weights);
         }
 
-        static void interactiveDCT(const model::Performance &performance)
+        /**
+         * Compute the raw performance metrics of an individual
+         * 
+         * The metrics do not depend on the objective weights, store them to re-score an individual later
+         * 
+         * @param performance: Performance/response of the individual in the MPC control loop
+         * 
+         * @return ITAE of cte, etheta and velocity error, IAE of translational and rotational energy loss, median and
+         *         p99 solver cost per step
+         */
+        static metrics_t getMetrics(const model::Performance &performance)
         {
-            return get()._interactiveDctImpl(performance);
+            return get()._getMetrics(performance);
+        }
+
+        /**
+         * Compute fitness from previously stored metrics under the current objective weights
+         * 
+         * @param metrics: Metrics as returned by getMetrics
+         * 
+         * @return Fitness value
+         */
+        static double score(const metrics_t &metrics)
+        {
+            return _scoreImpl(metrics, get().m_Weights);
+        }
+
+        /**
+         * Compute fitness from stored metrics under a given set of objective weights
+         * 
+         * @param metrics: Metrics as returned by getMetrics
+         * @param weights: Objective weights to score with
+         * 
+         * @return Fitness value
+         */
+        static double score(const metrics_t &metrics, const metrics_t &weights)
+        {
+            return _scoreImpl(metrics, weights);
+        }
+
+        /**
+         * Get the objective weights as they would be after an IDT step
+         * 
+         * @param bumps: Indices of the metrics to be bumped
+         * 
+         * @return Bumped weights, the objective itself is left untouched
+         */
+        static metrics_t bumpedWeights(const std::vector<size_t> &bumps)
+        {
+            return get()._bumpedWeightsImpl(bumps);
+        }
+
+        /**
+         * Run one step of the interactive decision tree
+         * 
+         * @param metrics: Metrics of the best individual of the generation
+         * 
+         * @return True if the objective weights were changed, false otherwise
+         */
+        static bool interactiveDCT(const metrics_t &metrics)
+        {
+            return applyIDT(promptIDT(metrics));
+        }
+
+        /**
+         * Prompt the operator for the weakly improved metrics
+         * 
+         * Only touches the state of the decision tree, never the objective weights, so it can run on
+         * a separate thread while the objective is being evaluated
+         * 
+         * @param metrics: Metrics of the best individual of the generation
+         * 
+         * @return Indices of the metrics to be bumped, empty if nothing changes
+         */
+        static std::vector<size_t> promptIDT(const metrics_t &metrics)
+        {
+            return get()._promptIdtImpl(metrics);
+        }
+
+        /**
+         * Bump the objective weights as answered in the decision tree prompt
+         * 
+         * @param bumps: Indices of the metrics to be bumped
+         * 
+         * @return True if the objective weights were changed, false otherwise
+         */
+        static bool applyIDT(const std::vector<size_t> &bumps)
+        {
+            get().m_Weights = get()._bumpedWeightsImpl(bumps);
+            return !bumps.empty();
         }
 
     private:
@@ -43,14 +219,18 @@ namespace ga::fitness
             return s_Instance;
         }
 
-        double _evaluateImpl(const model::Performance &performance);
+        static double _scoreImpl(const metrics_t &metrics, const metrics_t &weights);
+
+        metrics_t _bumpedWeightsImpl(const std::vector<size_t> &bumps) const;
+
+        std::vector<size_t> _promptIdtImpl(const metrics_t &currMetrics);
 
-        void _interactiveDctImpl(const model::Performance &performance);
+        metrics_t _getMetrics(model::Performance performance);
 
-        darr5_t _getMetrics(model::Performance performance);
+        metrics_t m_Weights;
+        metrics_t m_prevMetrics;
 
-        darr5_t m_Weights;
-        darr5_t m_prevMetrics;
+        SolverCost m_solverCost;
 
         bool m_started, m_terminated;
         const double m_deltaN;
@@ -0,0 +1,57 @@
+#ifndef GA_NSGA2_H_
+#define GA_NSGA2_H_
+
+#include "primary.h"
+#include "genetic_algorithm/fitness.h"
+#include <vector>
+
+/**
+ * Multi-objective ranking as in NSGA-II. All objectives are minimised.
+ */
+namespace ga::nsga2
+{
+    /**
+     * Check if a point Pareto-dominates another
+     * 
+     * @param a: First point
+     * @param b: Second point
+     * 
+     * @return True if a is no worse than b in every objective and better in at least one
+     */
+    bool dominates(const ga::fitness::metrics_t &a, const ga::fitness::metrics_t &b);
+
+    /**
+     * Fast non-dominated sort
+     * 
+     * Uses the efficient non-dominated sort with binary search (ENS-BS). Points are visited in
+     * lexicographic order, so a point can only be dominated by points already assigned to a front
+     * and each front needs to be checked once. This brings the cost from O(MN^2) down to
+     * O(MN log N) in the best case, which matters for populations in the thousands.
+     * 
+     * @param objectives: Objective vectors of the population
+     * 
+     * @return Front index of each point, 0 being the non-dominated front
+     */
+    std::vector<size_t> nonDominatedSort(const std::vector<ga::fitness::metrics_t> &objectives);
+
+    /**
+     * Crowding distance of each point within its front
+     * 
+     * @param objectives: Objective vectors of the population
+     * @param fronts: Front index of each point, as returned by nonDominatedSort
+     * 
+     * @return Crowding distance, infinite for the boundary points of a front
+     */
+    std::vector<double> crowdingDistance(const std::vector<ga::fitness::metrics_t> &objectives, const std::vector<size_t> &fronts);
+
+    /**
+     * Order the population by front and then by decreasing crowding distance
+     * 
+     * @param objectives: Objective vectors of the population
+     * 
+     * @return Indices of the points, best first
+     */
+    std::vector<size_t> rank(const std::vector<ga::fitness::metrics_t> &objectives);
+} // namespace ga::nsga2
+
+#endif
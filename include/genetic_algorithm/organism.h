@@ -5,7 +5,11 @@
 #include "model/differential_drive.h"
 #include "model/base_organism.h"
 #include "genetic_algorithm/core.h"
+#include "genetic_algorithm/fitness.h"
 #include "utils/json_logger.hpp"
+#include "utils/run_writer.hpp"
+#include "utils/async_output.hpp"
+#include <memory>
 
 namespace ga
 {
@@ -39,6 +43,13 @@ namespace ga
          */
         ga::core::Genome getGenome() const;
 
+        /**
+         * Get the raw performance metrics of the last evaluation
+         * 
+         * @return Metrics
+         */
+        const ga::fitness::metrics_t &getMetrics() const;
+
         /**
          * Set the fitness value of the orgaism
          * 
@@ -60,17 +71,48 @@ namespace ga
          */
         void setGenome(const ga::core::Genome &genome);
 
+        /**
+         * Store the raw performance metrics of the organism
+         * 
+         * @param metrics: Metrics as returned by the objective function
+         */
+        void setMetrics(const ga::fitness::metrics_t &metrics);
+
         /**
          * Save the organism as the best in a population
+         * 
+         * The file is written on the output thread from a copy of the trajectory
          */
         void saveAsBest(size_t genCount);
 
+        /**
+         * Append the organism to the run output as the best in a population
+         * 
+         * @param genCount: Generation number
+         * @param writer: Run output, only used on the output thread
+         */
+        void saveAsBest(size_t genCount, std::shared_ptr<RunWriter> writer) const;
+
     private:
         /// Genome of individual
         ga::core::Genome m_genome;
 
         /// Fitness of this individual
         double m_fitness;
+
+        /// Raw metrics the fitness was computed from
+        ga::fitness::metrics_t m_metrics;
+    };
+
+    /**
+     * Record of an evaluated genome, kept so it can be re-scored without another rollout
+     */
+    struct Evaluation
+    {
+        ga::core::Genome genome;
+        ga::fitness::metrics_t metrics;
+        double fitness;
+        size_t generation;
     };
 
 } // namespace ga
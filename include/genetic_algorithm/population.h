@@ -3,8 +3,16 @@
 
 #include "primary.h"
 #include "genetic_algorithm/organism.h"
+#include "genetic_algorithm/archive.h"
+#include "genetic_algorithm/checkpoint.h"
+#include "genetic_algorithm/telemetry.h"
+#include "model/lockstep_rollout.h"
 #include "utils/progress_bar.hpp"
 #include "utils/config_handler.hpp"
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
 
 namespace ga
 {
@@ -14,23 +22,30 @@ namespace ga
     class Population
     {
     public:
+        /// Metrics of a weight set, in place of the control loop
+        typedef std::function<ga::fitness::metrics_t(const mpc::Params::Weights &)> Evaluator;
+
         /**
          * Constructor
          * 
          * @param size: Size of the population
          * @param matingPoolSize: Size of the mating pool
+         * @param evaluator: Replaces the control loop if given, e.g. by an analytic test function to measure
+         *                   the GA itself. Such evaluations are neither archived nor saved
          */
-        Population(size_t size, size_t matingPoolSize);
+        Population(size_t size, size_t matingPoolSize, Evaluator evaluator = nullptr);
 
         /**
          * Assign weights to all organisms in the population using uniform random distribution
+         * 
+         * A fraction of the population is seeded with the fittest genomes of the evaluation archive, if any
          */
         void randDistInit();
 
         /**
          * The main loop
          * 
-         * Processes such as selection, crossover and mutation happen here
+         * Evaluates every organism and ranks the population by fitness
          */
         void mainLoop();
 
@@ -44,6 +59,8 @@ namespace ga
         /**
          * Refresh/reset the population for the next evolutionary cycle
          * 
+         * Saves the best organism, then performs selection, crossover and mutation on the ranked population
+         * 
          * @param genCount: The count of generation
          */ 
         void refresh(size_t genCount);
@@ -55,29 +72,303 @@ namespace ga
          */
         std::string getBestWeights() const;
 
-        void runIDT() const;
+        /**
+         * Start the interactive decision tree on the best organism
+         * 
+         * Returns immediately, the prompt is handled on a separate thread while the next generation is
+         * evaluated speculatively. The answer is applied in the next call to mainLoop, re-ranking the
+         * current and archived populations from their stored metrics.
+         */
+        void runIDT();
+
+        /**
+         * Check if the decision tree prompt is open
+         * 
+         * @return True from runIDT until the answer is applied in mainLoop. The prompt owns the console meanwhile
+         */
+        bool prompting() const;
+
+        /**
+         * Switch evaluation of the generations other IDT answers would breed on or off
+         * 
+         * Only changes how the prompt time is used, never the outcome of a run. Set by idt_speculation
+         * 
+         * @param enabled: False to only evaluate the generation of the actual answer
+         */
+        void setSpeculation(bool enabled);
+
+        /**
+         * Get every evaluation made so far, in order. Re-scored whenever the objective weights change
+         * 
+         * @return Archived evaluations
+         */
+        const std::vector<ga::Evaluation> &getHistory() const;
+
+        /**
+         * Save the Pareto front over every evaluation of the run
+         * 
+         * @param filepath: Path of the JSON file to write
+         * 
+         * @return True on success, false otherwise
+         */
+        bool savePareto(const std::string &filepath) const;
+
+        /**
+         * Save the state of the run in the background
+         * 
+         * To be called right after mainLoop, before the decision tree prompt is started
+         * 
+         * @param filepath: Path of the checkpoint
+         */
+        void checkpoint(const std::string &filepath);
+
+        /**
+         * Restore the state of the run from a checkpoint
+         * 
+         * Continuing with refresh is bit-identical to continuing the run that wrote the checkpoint, unless
+         * warm starts are enabled. The warm start cache is not part of the checkpoint and starts empty,
+         * the solutions then only agree within the Ipopt tolerance.
+         * 
+         * @param filepath: Path of the checkpoint
+         * @param genCount: Set to the last completed generation
+         * 
+         * @return True on success, false otherwise
+         */
+        bool resume(const std::string &filepath, size_t &genCount);
 
     private:
+        /**
+         * An evaluation not in the history yet
+         * 
+         * Held back while the IDT answer is pending, only the generation the answer keeps is recorded
+         */
+        struct Result
+        {
+            ga::Evaluation evaluation;
+            /// Wall time of the rollout
+            double rolloutSeconds;
+            /// Taken from the evaluation archive, neither simulated nor archived again
+            bool archived;
+        };
+
+        /**
+         * A candidate next generation, bred from the mating pool a different IDT answer would select
+         */
+        struct Branch
+        {
+            std::vector<ga::core::Genome> pool;
+            std::vector<ga::Organism> organisms;
+            /// State of the random engine after breeding the branch
+            std::mt19937_64 engine;
+            /// Evaluations of the organisms, recorded only if the branch is kept
+            std::vector<Result> results;
+        };
+
         /**
          * Update the fitness values of the population
+         * 
+         * @param results: Receives the evaluations
          */
-        void _updateFitnessVals();
+        void _updateFitnessVals(std::vector<Result> &results);
 
         /**
-         * Perform selection and crossover
+         * Run the control loop for an organism and set its metrics and fitness
+         * 
+         * Genomes found in the evaluation archive are not simulated again
+         * 
+         * @param organism: Organism to evaluate
+         * @param results: Receives the evaluation
          */
-        void _crossover();
+        void _evaluate(ga::Organism &organism, std::vector<Result> &results);
 
         /**
-         * Mutate the progenies
+         * Evaluate organisms together, archive misses are simulated in lockstep
+         * 
+         * @param organisms: Organisms to evaluate, refreshed since their last rollout
+         * @param results: Receives the evaluations
          */
-        void _mutation();
+        void _evaluateLockstep(std::vector<ga::Organism> &organisms, std::vector<Result> &results);
+
+        /**
+         * Take metrics and fitness of an organism from the evaluation archive
+         * 
+         * @param organism: Organism to look up
+         * @param results: Receives the evaluation on a hit
+         * 
+         * @return True if the genome was archived
+         */
+        bool _lookup(ga::Organism &organism, std::vector<Result> &results);
+
+        /**
+         * Compute fitness of an evaluated organism and keep the evaluation
+         * 
+         * @param organism: Evaluated organism
+         * @param metrics: Metrics of its rollout
+         * @param rolloutSeconds: Time taken by the rollout
+         * @param results: Receives the evaluation
+         */
+        void _store(ga::Organism &organism, const ga::fitness::metrics_t &metrics, double rolloutSeconds, std::vector<Result> &results);
+
+        /**
+         * Record evaluations of the population in the history and the evaluation archive
+         * 
+         * Scored under the current objective weights
+         * 
+         * @param results: Evaluations of organisms kept in the population
+         */
+        void _commit(const std::vector<Result> &results);
+
+        /**
+         * Save an organism as the best of a generation, to the run output if enabled
+         * 
+         * @param organism: Best organism
+         * @param genCount: Generation number
+         */
+        void _saveBest(ga::Organism &organism, size_t genCount);
+
+        /**
+         * Queue opening the run output and the telemetry stream, before the first generation is saved
+         * 
+         * @param append: Continue the files of the run being resumed
+         */
+        void _openOutputs(bool append);
+
+        /**
+         * Complete the statistics of the generation and queue its telemetry record
+         */
+        void _emitTelemetry();
+
+        /**
+         * Run the control loop for an organism
+         * 
+         * @param organism: Organism to simulate
+         */
+        void _rollout(ga::Organism &organism) const;
+
+        /**
+         * Select the mating pool from the previous generation under the given objective weights
+         * 
+         * @param weights: Objective weights used for ranking
+         * 
+         * @return Genomes of the fittest organisms, fittest first
+         */
+        std::vector<ga::core::Genome> _matingPool(const ga::fitness::metrics_t &weights) const;
+
+        /**
+         * Evaluate the generations that single weight bumps would breed until the IDT prompt is answered
+         */
+        void _speculate();
+
+        /**
+         * Wait for the IDT answer, keep the matching branch and re-rank
+         * 
+         * @param results: Evaluations of the current generation, replaced by those of the generation kept
+         */
+        void _resolveIDT(std::vector<Result> &results);
+
+        /**
+         * Order the organisms, fittest first
+         * 
+         * By fitness, or by Pareto front and crowding distance in multi-objective mode
+         */
+        void _rank();
+
+        /**
+         * Order a population, fittest first, as _rank() does
+         * 
+         * @param metrics: Metrics of each organism
+         * @param fitness: Fitness of each organism, unused in multi-objective mode
+         * 
+         * @return Indices of the organisms, fittest first
+         */
+        std::vector<size_t> _rank(const std::vector<ga::fitness::metrics_t> &metrics, const std::vector<double> &fitness) const;
+
+        /**
+         * Recompute fitness of the current and archived populations from stored metrics and re-rank them
+         */
+        void _rescore();
+
+        /**
+         * Perform crossover and mutation
+         * 
+         * @param organisms: Organisms to hold the new generation, parents first
+         * @param pool: Mating pool
+         */
+        void _breed(std::vector<ga::Organism> &organisms, const std::vector<ga::core::Genome> &pool) const;
 
         const size_t m_popSize;
         const size_t m_matingPoolSize;
 
+        /// Evaluation in place of the control loop, null to simulate
+        const Evaluator m_evaluator;
+
         std::vector<ga::Organism> m_organisms;
 
+        /// Every evaluation of the run in order, re-scored when the objective changes
+        std::vector<ga::Evaluation> m_history;
+
+        /// Evaluations of the history already in the checkpoint history file
+        size_t m_historySaved = 0;
+
+        /// Generations evaluated so far
+        size_t m_genCount;
+
+        /// Parameters of the control loop, weights are filled in per organism
+        mpc::Params m_params;
+        model::TerminateOn<config::GA> m_condn;
+
+        /// Path every organism follows
+        std::shared_ptr<const model::ReferencePath> m_path;
+
+        /// Solver threads of the lockstep rollouts, null to solve on the GA thread
+        std::unique_ptr<mpc::SolverPool> m_solverPool;
+
+        /// Simulates the population one control step at a time
+        model::LockstepRollout m_lockstep;
+
+        /// Solutions shared by every rollout, null if disabled
+        std::shared_ptr<mpc::WarmStartCache> m_warmStart;
+
+        /// Evaluations of the generation the current mating pool was selected from
+        std::vector<ga::Evaluation> m_lastGeneration;
+
+        /// Mating pool the current generation was bred from
+        std::vector<ga::core::Genome> m_breedPool;
+
+        /// Speculatively evaluated generations for other IDT answers
+        std::vector<Branch> m_branches;
+        bool m_speculation;
+
+        /// Best organism of the last generation, saved once the prompt no longer owns the console
+        std::unique_ptr<ga::Organism> m_heldBest;
+        size_t m_heldGeneration = 0;
+
+        /// Hash of the configuration, evaluations and checkpoints are only valid for the same one
+        uint64_t m_configHash;
+
+        /// Writes checkpoints without blocking the evaluation
+        ga::checkpoint::Writer m_checkpointWriter;
+
+        /// Evaluations shared across runs, null if disabled
+        std::unique_ptr<ga::EvalArchive> m_archive;
+
+        /// Binary run output, null if disabled. Opened by _openOutputs, only used on the output thread
+        std::shared_ptr<RunWriter> m_runOutput;
+
+        /// Telemetry stream, null if disabled. Only used on the output thread
+        std::shared_ptr<ga::telemetry::Stream> m_telemetry;
+        bool m_outputsOpened;
+
+        /// Statistics of the generation in progress
+        ga::GenerationStats m_stats;
+        mpc::SolverTotals m_solverStart;
+        alloc::Counts m_allocStart;
+        mpc::WarmStartCache::Stats m_warmStartStart;
+        std::chrono::steady_clock::time_point m_generationStart;
+
+        /// Answer of the decision tree prompt, valid while the prompt is open
+        std::future<std::vector<size_t>> m_pendingIDT;
+
         /// Progress bar for some nice console output
         ProgressBar m_pBar;
     };
@@ -0,0 +1,114 @@
+#ifndef GA_TELEMETRY_H_
+#define GA_TELEMETRY_H_
+
+#include "primary.h"
+#include "genetic_algorithm/core.h"
+#include "mpc_lib/mpc.h"
+#include "mpc_lib/warm_start_cache.h"
+#include "utils/alloc_tracker.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ga
+{
+    /// Statistics of one generation, a record of the telemetry stream
+    struct GenerationStats
+    {
+        size_t generation;
+        size_t population;
+
+        double fitnessMin, fitnessMedian, fitnessMax;
+
+        /// Mean pairwise Hamming distance of the genomes, as a fraction of the genome length
+        double diversity;
+
+        /// Evaluation archive lookups and hits, both 0 without an archive
+        size_t lookups, hits;
+
+        /// Control loops simulated, including speculative branches and the re-simulated best organism
+        size_t rollouts;
+
+        /// Wall time in seconds
+        struct Phases
+        {
+            double evaluation, speculation, decision, ranking, checkpoint, saving, breeding, total;
+        } seconds;
+
+        /// Solves of the generation
+        mpc::SolverTotals solver;
+
+        /// Heap allocations of the generation over every thread, 0 unless the allocation hooks are linked
+        alloc::Counts allocations;
+
+        /// Warm start lookups and their savings, all 0 without the cache
+        mpc::WarmStartCache::Stats warmStart;
+
+        /// Threads solving during evaluation
+        size_t workerThreads;
+
+        GenerationStats();
+    };
+
+    namespace telemetry
+    {
+        /**
+         * Compute the diversity of a population
+         * 
+         * @param genomes: Genomes of the population
+         * 
+         * @return Mean pairwise Hamming distance over the number of genes, 0 for fewer than 2 genomes
+         */
+        double diversity(const std::vector<ga::core::Genome> &genomes);
+
+        /**
+         * Ipopt time over the wall time of the simulating phases times the worker threads
+         * 
+         * @param stats: Statistics of a generation
+         * 
+         * @return Utilization in [0, 1], 0 if nothing was simulated
+         */
+        double utilization(const GenerationStats &stats);
+
+        /**
+         * Format a generation as one line of JSON, without the line break
+         * 
+         * @param stats: Statistics of a generation
+         * 
+         * @return The record
+         */
+        std::string format(const GenerationStats &stats);
+
+        /**
+         * Newline delimited JSON stream, one record per generation
+         */
+        class Stream
+        {
+        public:
+            /**
+             * Open the stream
+             * 
+             * @param filepath: Path of the telemetry file
+             * @param append: Continue an existing file, e.g. when resuming, instead of starting a new one
+             * 
+             * @return True on success, false otherwise
+             */
+            bool open(const std::string &filepath, bool append);
+
+            /**
+             * Append a record and flush it, so that it can be followed while the run goes on
+             * 
+             * @param stats: Statistics of a generation
+             * 
+             * @return True on success, false otherwise
+             */
+            bool write(const GenerationStats &stats);
+
+        private:
+            std::ofstream m_file;
+        };
+    } // namespace telemetry
+} // namespace ga
+
+#endif
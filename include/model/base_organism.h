@@ -3,9 +3,15 @@
 
 #include "primary.h"
 #include "model/differential_drive.h"
+#include "model/reference_path.h"
+#include "mpc_lib/event_trigger.h"
+#include "mpc_lib/horizon_scheduler.h"
 #include "mpc_lib/mpc.h"
+#include "mpc_lib/solver_profile.h"
+#include "mpc_lib/warm_start_cache.h"
 #include "utils/config_handler.hpp"
 #include "utils/json_logger.hpp"
+#include "utils/trace.hpp"
 
 /**
  * Models used
@@ -36,6 +42,25 @@ namespace model
         size_t iterations;
     };
 
+    /**
+     * Data recorded for every step of the control loop
+     */
+    struct StepRecord
+    {
+        /// Position of the robot before the step
+        double px, py;
+        /// Predicted errors the MPC was solved for
+        double velError, cte, etheta;
+        /// Optimal cost of the MPC
+        double cost;
+        /// Controls applied to the robot
+        double speed, omega;
+        /// Statistics of the solve
+        mpc::SolveStats solve;
+        /// Heap allocations of the whole step, the solve included. 0 unless the allocation hooks are linked
+        uint64_t allocations;
+    };
+
     template <config::ConfigType __type>
     class BaseOrganism
     {
@@ -50,6 +75,47 @@ namespace model
             m_dModel.setInitState(s);
         }
 
+        /**
+         * Set the path the control loop follows, the x axis by default
+         * 
+         * @param path: Reference path, shared between organisms
+         */
+        void setPath(const std::shared_ptr<const ReferencePath> &path)
+        {
+            m_path = path;
+            m_tracker = ReferencePath::Tracker(m_path.get());
+        }
+
+        /**
+         * Skip the solves of steps that follow the last plan, disabled by default
+         * 
+         * @param trigger: Tolerances of the plan, see mpc::EventTrigger
+         */
+        void setEventTrigger(const mpc::EventTrigger &trigger)
+        {
+            m_trigger = trigger;
+        }
+
+        /**
+         * Adapt the prediction horizon from step to step, disabled by default
+         * 
+         * @param scheduler: Bounds of the horizon, see mpc::HorizonScheduler
+         */
+        void setHorizonScheduler(const mpc::HorizonScheduler &scheduler)
+        {
+            m_horizon = scheduler;
+        }
+
+        /**
+         * Warm start the solves from earlier solutions, cold starts by default
+         * 
+         * @param cache: Cache shared between organisms, nullptr for cold starts
+         */
+        void setWarmStartCache(const std::shared_ptr<mpc::WarmStartCache> &cache)
+        {
+            m_warmStart = cache;
+        }
+
         /**
          * Get performance/response data of the organism in the control loop
          * 
@@ -60,18 +126,119 @@ namespace model
             return m_performance;
         }
 
+        /**
+         * Get the current state of the internal model
+         * 
+         * @return Model state, the initial state right after a refresh
+         */
+        model::State getModelState() const
+        {
+            return m_dModel.getState();
+        }
+
+        /**
+         * Record one step of the control loop into the performance data and the logger
+         * 
+         * Used by followSetpoints and by rollouts that simulate the model elsewhere
+         * 
+         * @param step: Data of the step
+         */
+        void record(const StepRecord &step)
+        {
+            TRACE_SCOPE("record");
+
+            m_jsonLogger.logStep(step.px, step.py, step.velError, step.cte, step.etheta, step.cost);
+
+            m_performance.cteData.push_back(step.cte);
+            m_performance.ethetaData.push_back(step.etheta);
+            m_performance.velErrData.push_back(step.velError);
+
+            m_performance.translationalEL.push_back(pow(step.speed, 2) - pow(m_prevSpeed, 2));
+            m_performance.rotationalEL.push_back(pow(step.omega, 2) - pow(m_prevOmega, 2));
+
+            m_performance.solveIterations.push_back(step.solve.iterations);
+            m_performance.solveSeconds.push_back(step.solve.seconds);
+
+            m_prevSpeed = step.speed;
+            m_prevOmega = step.omega;
+
+            m_solverProfile.add(step.solve);
+            m_stepAllocations += step.allocations;
+        }
+
+        /**
+         * Get the solver cost of the rollout since the last refresh
+         * 
+         * @return Latency and iteration histograms, failures
+         */
+        const mpc::SolverProfile &getSolverProfile() const
+        {
+            return m_solverProfile;
+        }
+
+        /**
+         * Get the warm start cache of the solves
+         * 
+         * @return The cache, nullptr for cold starts
+         */
+        const std::shared_ptr<mpc::WarmStartCache> &getWarmStartCache() const
+        {
+            return m_warmStart;
+        }
+
+        /**
+         * Get the heap allocations of the rollout since the last refresh
+         * 
+         * @return Allocations summed over the steps, divide by the steps for the count per step
+         */
+        uint64_t getStepAllocations() const
+        {
+            return m_stepAllocations;
+        }
+
+        /**
+         * Switch recording of the trajectory on or off, performance data is always collected
+         * 
+         * @param recording: False for evaluations whose trajectory is never saved
+         */
+        void setRecording(bool recording)
+        {
+            m_jsonLogger.setRecording(recording);
+        }
+
+        /**
+         * Check if a recorded trajectory is available
+         * 
+         * @return True if followSetpoints ran with recording on since the last refresh
+         */
+        bool hasTrajectory() const
+        {
+            return m_jsonLogger.getTrajectory().size() > 0;
+        }
+
         /**
          * Refresh/reset the organism
          * 
          * (i)   Bring the internal differential drive model back to the initial state
          * (ii)  Clear pervious performance data
-         * (iii) Reset the logger
+         * (iii) Clear the recorded trajectory
+         * (iv)  Start tracking the path from scratch
+         * (v)   Clear the solver profile and the allocation count
+         * (vi)  Drop the plan of the event trigger
+         * (vii) Start over from the largest horizon
          */
         void refresh()
         {
             m_dModel.reset();
             m_performance.reset();
-            m_jsonLogger = JsonLogger();
+            m_jsonLogger.clear();
+            m_prevSpeed = 0.0;
+            m_prevOmega = 0.0;
+            m_tracker.reset();
+            m_solverProfile.reset();
+            m_stepAllocations = 0;
+            m_trigger.reset();
+            m_horizon.reset();
         }
 
         /**
@@ -90,6 +257,39 @@ namespace model
         /// Performance data
         model::Performance m_performance;
 
+        /// Path to follow and the position of the model along it
+        std::shared_ptr<const ReferencePath> m_path = ReferencePath::xAxis();
+        ReferencePath::Tracker m_tracker{m_path.get()};
+
+        /// Controls of the previous step, for the energy losses
+        double m_prevSpeed = 0.0, m_prevOmega = 0.0;
+
+        /// Solver cost of the rollout
+        mpc::SolverProfile m_solverProfile;
+
+        /// Heap allocations of the steps of the rollout
+        uint64_t m_stepAllocations = 0;
+
+        /// Last plan and when to solve again
+        mpc::EventTrigger m_trigger;
+
+        /// Horizon of the next solve
+        mpc::HorizonScheduler m_horizon;
+
+        /// Solutions to start from, shared between organisms
+        std::shared_ptr<mpc::WarmStartCache> m_warmStart;
+
+        /**
+         * Run one step of the control loop, shared by both modes
+         * 
+         * Solves the MPC unless the event trigger keeps the last plan, then steps the model
+         * 
+         * @param params: Parameters of the MPC
+         * 
+         * @return Data of the step, not recorded yet
+         */
+        StepRecord _step(const mpc::Params &params);
+
     protected:
         JsonLogger m_jsonLogger;
     };
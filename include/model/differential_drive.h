@@ -23,6 +23,8 @@ namespace model
         std::vector<double> velErrData, cteData, ethetaData;
         std::vector<double> translationalEL, rotationalEL;
         std::vector<double> costs;
+        /// Ipopt iterations and wall time of the solve of each step
+        std::vector<double> solveIterations, solveSeconds;
 
         /**
          * Clear all values
@@ -0,0 +1,89 @@
+#ifndef MODEL_DIFF_DRIVE_BATCH_H_
+#define MODEL_DIFF_DRIVE_BATCH_H_
+
+#include "primary.h"
+#include "model/differential_drive.h"
+#include <vector>
+
+namespace model
+{
+    /**
+     * Many differential drive robots simulated together
+     * 
+     * States are stored as a structure of arrays, one contiguous array per state variable, so that the
+     * kernels below run the same arithmetic over all robots in plain loops the compiler can vectorise.
+     */
+    class DifferentialDriveBatch
+    {
+    public:
+        /**
+         * Constructor
+         * 
+         * @param size: Number of robots
+         */
+        explicit DifferentialDriveBatch(size_t size = 0);
+
+        /**
+         * Change the number of robots, new robots start in the zero state
+         * 
+         * @param size: Number of robots
+         */
+        void resize(size_t size);
+
+        /// Number of robots
+        size_t size() const;
+
+        /**
+         * Set the sample time for each step of the models
+         * 
+         * @param sampletime: The sampletime
+         */
+        void setSampleTime(double sampletime);
+
+        /**
+         * Set the state of a robot
+         * 
+         * @param i: Index of the robot
+         * @param state: New state
+         */
+        void setState(size_t i, const State &state);
+
+        /**
+         * Get the state of a robot
+         * 
+         * @param i: Index of the robot
+         * 
+         * @return Current state
+         */
+        State getState(size_t i) const;
+
+        /**
+         * Update all robots by one timestep, same model as DifferentialDrive::step
+         * 
+         * @param speed: Speed of each robot
+         * @param omega: Angular velocity of each robot
+         */
+        void step(const double *speed, const double *omega);
+
+        /// Positions and heading of the robots
+        const double *x() const { return m_x.data(); }
+        const double *y() const { return m_y.data(); }
+        const double *theta() const { return m_theta.data(); }
+
+        /// Velocities and throttle of the robots
+        const double *linVel() const { return m_linVel.data(); }
+        const double *angVel() const { return m_angVel.data(); }
+        const double *throttle() const { return m_throttle.data(); }
+
+    private:
+        std::vector<double> m_x, m_y, m_theta;
+        std::vector<double> m_linVel, m_angVel, m_throttle;
+
+        /// Cached sin and cos of the headings, updated in step
+        std::vector<double> m_sinTheta, m_cosTheta;
+
+        double m_sampleTime;
+    };
+} // namespace model
+
+#endif
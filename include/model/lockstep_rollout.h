@@ -0,0 +1,96 @@
+#ifndef MODEL_LOCKSTEP_ROLLOUT_H_
+#define MODEL_LOCKSTEP_ROLLOUT_H_
+
+#include "primary.h"
+#include "model/base_organism.h"
+#include "model/differential_drive_batch.h"
+#include "model/reference_path.h"
+#include "mpc_lib/event_trigger.h"
+#include "mpc_lib/horizon_scheduler.h"
+#include "mpc_lib/mpc.h"
+#include "mpc_lib/warm_start_cache.h"
+#include <functional>
+#include <vector>
+
+namespace model
+{
+    /**
+     * Runs the control loops of many robots together, one control step at a time
+     * 
+     * Preprocessing of a step (reference cubic, state prediction) runs over the whole batch, the NLPs
+     * of a step are then handed to mpc::solveBatch together. Each robot
+     * follows the same control loop as BaseOrganism<config::GA>::followSetpoints.
+     */
+    class LockstepRollout
+    {
+    public:
+        /// Called with the index of the robot and the data of each step
+        typedef std::function<void(size_t, const StepRecord &)> Recorder;
+
+        /**
+         * Constructor
+         * 
+         * @param pool: Solver threads shared by the steps, nullptr to solve on the calling thread. Must
+         *              outlive the rollout.
+         */
+        explicit LockstepRollout(mpc::SolverPool *pool = nullptr);
+
+        /**
+         * Skip the solves of robots that follow their last plan, disabled by default
+         * 
+         * @param trigger: Copied for every robot at the start of each run
+         */
+        void setEventTrigger(const mpc::EventTrigger &trigger);
+
+        /**
+         * Adapt the prediction horizon of every robot on its own, disabled by default
+         * 
+         * @param scheduler: Copied for every robot at the start of each run
+         */
+        void setHorizonScheduler(const mpc::HorizonScheduler &scheduler);
+
+        /**
+         * Warm start the solves from earlier solutions, cold starts by default
+         * 
+         * @param cache: Cache shared by every robot, nullptr for cold starts
+         */
+        void setWarmStartCache(const std::shared_ptr<mpc::WarmStartCache> &cache);
+
+        /**
+         * Run the control loops
+         * 
+         * @param path: Path all robots follow
+         * @param params: Parameters of each robot, all with the same sample time
+         * @param initStates: Initial state of each robot
+         * @param iterations: Number of control steps
+         * @param record: Receives every step of every robot
+         * 
+         * @return For each robot, false if one of its solves failed. It is not simulated further.
+         */
+        std::vector<bool> run(const ReferencePath &path, const std::vector<mpc::Params> &params, const std::vector<State> &initStates,
+                              size_t iterations, const Recorder &record);
+
+    private:
+        mpc::SolverPool *const m_pool;
+
+        /// Position of each robot along the path
+        std::vector<ReferencePath::Tracker> m_trackers;
+
+        DifferentialDriveBatch m_batch;
+
+        /// Reference cubics of the robots, coefficient-major
+        std::vector<double> m_coeffs;
+
+        mpc::EventTrigger m_trigger;
+        /// Plan of each robot
+        std::vector<mpc::EventTrigger> m_triggers;
+
+        mpc::HorizonScheduler m_horizon;
+        /// Horizon of each robot
+        std::vector<mpc::HorizonScheduler> m_horizons;
+
+        std::shared_ptr<mpc::WarmStartCache> m_warmStart;
+    };
+} // namespace model
+
+#endif
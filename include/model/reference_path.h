@@ -0,0 +1,257 @@
+#ifndef MODEL_REFERENCE_PATH_H_
+#define MODEL_REFERENCE_PATH_H_
+
+#include "primary.h"
+#include "model/route_file.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace model
+{
+    /**
+     * Polyline reference path with a spatial index over its segments
+     * 
+     * Segments are bucketed into a sparse uniform grid, so the nearest segment to any point is found
+     * by looking at the cells around it. While following the path a Tracker only looks at the
+     * neighbours of the previous segment, which is constant time per control step.
+     * 
+     * The first and last segments extend beyond the end points, a robot before the start or past
+     * the end still gets a straight reference.
+     * 
+     * On top of the polyline the path is a cubic Hermite spline through the waypoints, parameterised
+     * by the chord length and matching the waypoint headings. Control loops take the reference from
+     * the spline, see Tracker::localCubic.
+     */
+    class ReferencePath
+    {
+    public:
+        /**
+         * Position of a point relative to the path
+         */
+        struct Projection
+        {
+            /// Index of the segment
+            size_t segment;
+            /// Arc length of the closest point on the path
+            double s;
+            /// Distance of the point from the path
+            double distance;
+        };
+
+        /**
+         * Spline piece of one segment, X(u) and Y(u) for u in [0, length]
+         */
+        struct Piece
+        {
+            size_t segment;
+            /// Arc length at the start of the segment and its length
+            double s0, length;
+            /// Coefficients of X(u) and Y(u), constant term first
+            std::array<double, 4> cx, cy;
+        };
+
+        /**
+         * Follows the closest segment of a path for a moving robot
+         */
+        class Tracker
+        {
+        public:
+            /**
+             * Constructor
+             * 
+             * @param path: Path to track, must outlive the tracker
+             */
+            explicit Tracker(const ReferencePath *path = nullptr);
+
+            /// Forget the previous position, the next update searches the whole path
+            void reset();
+
+            /**
+             * Find the projection of a new position
+             * 
+             * @param px: X coordinate
+             * @param py: Y coordinate
+             * 
+             * @return Projection onto the path
+             */
+            const Projection &update(double px, double py);
+
+            /// Projection found by the last update
+            const Projection &projection() const;
+
+            /**
+             * Reference ahead of a robot as a cubic y = f(x) in the frame of the robot
+             * 
+             * Updates the projection, then joins the spline points at the projection and a lookahead
+             * further with a cubic that matches their positions and headings. Replaces a least squares
+             * fit of sampled points, and stays exact for the headings on curves a single fitted cubic
+             * follows poorly. Pieces of the spline are cached while the robot stays on their segments.
+             * 
+             * @param px: X coordinate of the robot
+             * @param py: Y coordinate of the robot
+             * @param theta: Heading of the robot
+             * @param lookahead: Arc length covered by the cubic
+             * 
+             * @return Coefficients of the cubic, constant term first
+             */
+            std::array<double, 4> localCubic(double px, double py, double theta, double lookahead);
+
+        private:
+            /**
+             * Point and heading of the spline
+             * 
+             * @param s: Arc length, the end segments extend in straight lines
+             * @param x, y, heading: Filled with the point
+             */
+            void _splineAt(double s, double &x, double &y, double &heading);
+
+            /**
+             * Piece of a segment, from the cache if possible
+             */
+            const Piece &_piece(size_t segment);
+
+            const ReferencePath *m_path;
+            Projection m_projection;
+            bool m_started;
+
+            /// Recently used pieces, the start and end of the lookahead are mostly on two segments
+            std::array<Piece, 2> m_pieces;
+            size_t m_nextPiece;
+        };
+
+        /**
+         * Constructor
+         * 
+         * Consecutive duplicate waypoints are dropped
+         * 
+         * @param xs: X coordinates of the waypoints
+         * @param ys: Y coordinates of the waypoints
+         * @param cellSize: Edge length of the grid cells, 0 to derive it from the segment lengths
+         * 
+         * @throw std::invalid_argument if there are less than two distinct waypoints
+         */
+        ReferencePath(const std::vector<double> &xs, const std::vector<double> &ys, double cellSize = 0.0);
+
+        /**
+         * Constructor, follows a route file in place
+         * 
+         * Only the grid index is held in memory, waypoints are read from the mapping on demand
+         * 
+         * @param route: Open route file, kept alive by the path
+         * @param cellSize: Edge length of the grid cells, 0 to derive it from the segment lengths
+         * 
+         * @throw std::invalid_argument if the route is not open or has less than two waypoints
+         */
+        explicit ReferencePath(const std::shared_ptr<const RouteFile> &route, double cellSize = 0.0);
+
+        /// Delete copy constructor, the waypoint pointers may refer to owned storage
+        ReferencePath(const ReferencePath &) = delete;
+
+        /**
+         * Path for the route file named in a configuration
+         * 
+         * @param routeFile: Path of a route file, empty for the x axis
+         * 
+         * @return Shared path
+         * 
+         * @throw std::runtime_error if the route cannot be loaded
+         */
+        static std::shared_ptr<const ReferencePath> load(const std::string &routeFile);
+
+        /**
+         * The reference used before paths were configurable, the x axis in the positive direction
+         * 
+         * @return Shared instance of the path
+         */
+        static std::shared_ptr<const ReferencePath> xAxis();
+
+        /// Arc length covered by the reference cubic
+        static constexpr double LOOKAHEAD = 0.5;
+
+        /// Number of segments
+        size_t segments() const;
+
+        /// Arc length from the first to the last waypoint
+        double length() const;
+
+        /**
+         * Project a point onto one segment
+         * 
+         * @param segment: Index of the segment
+         * @param px: X coordinate
+         * @param py: Y coordinate
+         * 
+         * @return Projection onto the segment
+         */
+        Projection project(size_t segment, double px, double py) const;
+
+        /**
+         * Find the closest segment using the grid
+         * 
+         * @param px: X coordinate
+         * @param py: Y coordinate
+         * 
+         * @return Projection onto the closest segment
+         */
+        Projection nearest(double px, double py) const;
+
+        /**
+         * Compute the spline piece of a segment
+         * 
+         * @param segment: Index of the segment
+         * 
+         * @return The piece
+         */
+        Piece piece(size_t segment) const;
+
+    private:
+        /**
+         * Headings of the waypoints from the directions to their neighbours
+         */
+        void _computeHeadings();
+
+        /**
+         * Build the segment grid
+         * 
+         * @param cellSize: Requested cell size, 0 to derive it
+         * @param minX, minY, maxX, maxY: Bounding box of the waypoints
+         */
+        void _buildIndex(double cellSize, double minX, double minY, double maxX, double maxY);
+
+        /**
+         * Key of a grid cell in the sorted cell list
+         */
+        uint64_t _cellKey(int64_t cx, int64_t cy) const;
+
+        /**
+         * Project a point onto the segments of a cell
+         * 
+         * @param cx, cy: Cell coordinates
+         * @param px, py: Point
+         * @param best: Closest projection so far, updated
+         */
+        void _searchCell(int64_t cx, int64_t cy, double px, double py, Projection &best) const;
+
+        /// Waypoints, arc length and heading at each of them, owned or inside the route mapping
+        const double *m_x, *m_y, *m_s, *m_heading;
+        size_t m_count;
+
+        std::vector<double> m_ownX, m_ownY, m_ownS, m_ownHeading;
+        std::shared_ptr<const RouteFile> m_route;
+
+        double m_cellSize;
+        double m_minX, m_minY;
+        int64_t m_cellsX, m_cellsY;
+
+        /// Sorted keys of the occupied cells, segments of cell m_cellKeys[i] are
+        /// m_cellSegments[m_cellStart[i] .. m_cellStart[i + 1])
+        std::vector<uint64_t> m_cellKeys;
+        std::vector<size_t> m_cellStart;
+        std::vector<uint32_t> m_cellSegments;
+    };
+} // namespace model
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef MODEL_ROUTE_FILE_H_
+#define MODEL_ROUTE_FILE_H_
+
+#include "primary.h"
+#include <cstdint>
+#include <string>
+
+namespace model
+{
+    /**
+     * Read-only memory-mapped binary route
+     * 
+     * A route file is a 64 byte header followed by packed float64 arrays of the waypoints, one array
+     * per field: x, y, heading, speed and, if the header flags it, the arc length at each waypoint.
+     * Pages are only read in when touched, so routes larger than memory can be followed, and any
+     * number of threads can read the same mapping.
+     * 
+     * Route files are written by RouteFile::convertCsv, see the route_convert target.
+     */
+    class RouteFile
+    {
+    public:
+        /// Header flag set when the arc length array is present
+        static const uint32_t HAS_ARC_LENGTH = 1;
+
+        /// On-disk header
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t count;
+            uint32_t flags;
+            uint32_t reserved;
+            /// Bounding box of the waypoints
+            double minX, minY, maxX, maxY;
+            uint64_t padding;
+        };
+
+        /**
+         * Constructor, maps the file
+         * 
+         * Files that are not a route and routes repeating a waypoint are rejected, see isOpen
+         * 
+         * @param filepath: Path of the route file
+         */
+        explicit RouteFile(const std::string &filepath);
+
+        /// Destructor
+        ~RouteFile();
+
+        /// Delete copy constructor
+        RouteFile(const RouteFile &) = delete;
+
+        /**
+         * Check if the file could be mapped and is a valid route
+         * 
+         * @return True if usable, false otherwise
+         */
+        bool isOpen() const;
+
+        /// Number of waypoints
+        size_t size() const;
+
+        /// Header of the file
+        const Header &header() const;
+
+        /// Waypoint arrays, each of size() elements
+        const double *x() const;
+        const double *y() const;
+        const double *heading() const;
+        const double *speed() const;
+
+        /// Arc length at each waypoint, null if the file has none
+        const double *arcLength() const;
+
+        /**
+         * Convert a CSV waypoint log into a route file
+         * 
+         * Rows are `x,y[,heading[,speed]]`, lines that do not start with a number are skipped. Missing
+         * headings are taken from the direction to the next waypoint, missing speeds are 0. Consecutive
+         * duplicate waypoints are dropped. The CSV is streamed twice, the output is written through a
+         * mapping, so neither has to fit in memory.
+         * 
+         * @param csvPath: Input CSV file
+         * @param routePath: Output route file
+         * 
+         * @return Number of waypoints written, 0 on failure
+         */
+        static size_t convertCsv(const std::string &csvPath, const std::string &routePath);
+
+    private:
+        /**
+         * Array of a field
+         * 
+         * @param field: Index of the field, in file order
+         */
+        const double *_array(size_t field) const;
+
+        /// Release the mapping of a rejected file
+        void _unmap();
+
+        void *m_mapping;
+        size_t m_mappingSize;
+    };
+} // namespace model
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef MPC_EVENT_TRIGGER_H_
+#define MPC_EVENT_TRIGGER_H_
+
+#include "primary.h"
+#include "mpc_lib/mpc.h"
+
+namespace mpc
+{
+    /**
+     * Event-triggered MPC, skips solves while the robot follows the last optimal plan
+     *
+     * After a solve the control loop keeps the plan, on the following steps it applies the next planned
+     * controls as long as the state the NLP would be posed for stays within the tolerance of the planned
+     * state. It solves again on a deviation or when the plan runs out of controls.
+     *
+     * All states are world frame states after the latency compensation of the control loop, i.e. the
+     * state the NLP is posed for, rotated out of the robot frame.
+     */
+    class EventTrigger
+    {
+    public:
+        /// Largest deviation from the plan that is still followed
+        struct Tolerance
+        {
+            double position, heading, velocity;
+        };
+
+        /// Constructor, disabled: every step solves
+        EventTrigger();
+
+        /**
+         * Constructor
+         *
+         * @param tolerance: Deviations up to which the plan is followed
+         */
+        explicit EventTrigger(const Tolerance &tolerance);
+
+        bool enabled() const;
+
+        /// Drop the plan, the next step solves
+        void reset();
+
+        /**
+         * Get the plan to be filled by the next solve, see MPC::solve
+         *
+         * @return Plan buffers, reused from solve to solve
+         */
+        Plan &plan();
+
+        /**
+         * Keep the plan just solved for, a failed solve drops it
+         *
+         * @param stats: Statistics of the solve
+         * @param px: World x of the robot frame the NLP was posed in
+         * @param py: World y of the robot frame
+         * @param theta: World heading of the robot frame
+         */
+        void accept(const SolveStats &stats, double px, double py, double theta);
+
+        /**
+         * Take the next controls from the plan if it is still valid
+         *
+         * @param x: World x the NLP would be posed for
+         * @param y: World y
+         * @param theta: World heading
+         * @param v: Linear velocity
+         * @param omega: Receives the planned angular velocity
+         * @param acc: Receives the planned acceleration
+         *
+         * @return True if the step follows the plan, false if it has to solve
+         */
+        bool follow(double x, double y, double theta, double v, double &omega, double &acc);
+
+        /**
+         * Get the steps that followed a plan, over every trigger of the process
+         *
+         * @return Skipped solves so far
+         */
+        static uint64_t skippedTotal();
+
+    private:
+        bool m_enabled;
+        Tolerance m_tolerance;
+
+        Plan m_plan;
+        bool m_valid;
+        /// Steps since the plan was solved
+        size_t m_step;
+        /// Robot frame of the plan
+        double m_px, m_py, m_theta;
+    };
+} // namespace mpc
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef MPC_HORIZON_SCHEDULER_H_
+#define MPC_HORIZON_SCHEDULER_H_
+
+#include "primary.h"
+#include "mpc_lib/mpc.h"
+
+namespace mpc
+{
+    /**
+     * Adaptive prediction horizon
+     *
+     * Grows the horizon while the tracking errors are large and shrinks it once they are small or the
+     * recent solves get expensive. The horizon moves by a fixed step between bounds, so the solver only
+     * ever sees a handful of NLP sizes, each set up once per thread. Optionally holds the controls over
+     * blocks of steps (move blocking), which cuts the control variables of every horizon.
+     */
+    class HorizonScheduler
+    {
+    public:
+        struct Settings
+        {
+            size_t minTimesteps, maxTimesteps;
+            /// Timesteps added or removed at once
+            size_t step;
+            /// Grow above, shrink below this largest absolute error of cte, etheta and velocity
+            double growError, shrinkError;
+            /// Shrink while the smoothed Ipopt iterations per solve are above this
+            double maxIterations;
+            /// Steps each control is held for, 1 for no move blocking
+            size_t blocking;
+        };
+
+        /// Smoothing factor of the Ipopt iterations, the weight of the latest solve
+        static constexpr double EFFORT_SMOOTHING = 0.25;
+
+        /// Constructor, disabled: the horizon of the parameters is used as is
+        HorizonScheduler();
+
+        /**
+         * Constructor, starts at the largest horizon
+         *
+         * @param settings: Bounds and thresholds
+         *
+         * @throw std::invalid_argument if the bounds are empty, below 3 timesteps or the step or blocking is 0
+         */
+        explicit HorizonScheduler(const Settings &settings);
+
+        bool enabled() const;
+
+        /// Back to the largest horizon, forgetting the solver effort
+        void reset();
+
+        /**
+         * Set the horizon and move blocking of the next solve
+         *
+         * @param params: Parameters of the solve, left as they are if disabled
+         */
+        void schedule(Params &params) const;
+
+        /**
+         * Adapt the horizon to the step just taken
+         *
+         * @param cte: Cross track error the step was solved for
+         * @param etheta: Orientation error
+         * @param velError: Velocity error
+         * @param stats: Statistics of the solve, a skipped one only counts with its errors
+         */
+        void update(double cte, double etheta, double velError, const SolveStats &stats);
+
+        /// Horizon of the next solve
+        size_t timesteps() const;
+
+    private:
+        bool m_enabled;
+        Settings m_settings;
+
+        size_t m_timesteps;
+        /// Smoothed Ipopt iterations per solve, 0 before the first solve
+        double m_effort;
+    };
+} // namespace mpc
+
+#endif
@@ -2,15 +2,23 @@
 #define DIFF_DRIVE_MPC_H_
 
 #include "primary.h"
+#include "mpc_lib/polyfit.hpp"
 #include <Eigen/Core>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <cppad/cppad.hpp>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
 /**
  * Utilities/helpers for NMPC
  */
 namespace mpc::utils
 {
     /**
-     * Evaluate a polynomial
+     * Evaluate a polynomial, see horner()
      * 
      * @param coeffs: Coefficients of the polynomial, constant term first
      * @param x: The X value at which the polynomial is to be evaluated
@@ -19,9 +27,21 @@ namespace mpc::utils
      */
     double polyeval(const Eigen::VectorXd &coeffs, double x);
 
+    /**
+     * Evaluate the derivative of a polynomial, see hornerDerivative()
+     * 
+     * @param coeffs: Coefficients of the polynomial, constant term first
+     * @param x: The X value at which the derivative is to be evaluated
+     * 
+     * @return Result
+     */
+    double polyderiv(const Eigen::VectorXd &coeffs, double x);
+
     /**
      * Find best fit polynomial coefficients
      * 
+     * Allocates, prefer the fixed-size polyfit<__Order, __Window>() when the sizes are known
+     * 
      * @param xvals: The x values
      * @param yvals: The y values
      * @param order: Order of the polynomial
@@ -48,6 +68,8 @@ namespace mpc
             size_t timesteps;
             /// Sample time of the controller
             double dt;
+            /// Steps each control is held for (move blocking), 1 to change the controls every step
+            size_t blocking = 1;
         } forward;
 
         /// Desired errors and velocity, plant will try to achieve these / stay close to these values
@@ -84,15 +106,72 @@ namespace mpc
         size_t x_start, y_start, theta_start;
         size_t v_start, omega_start, acc_start;
         size_t cte_start, etheta_start;
+        /// Steps each control is held for, controls per actuator and variables in total
+        size_t blocking, n_controls, n_vars;
 
         /**
          * Constructor
          * 
          * Initialises all indicies based on the timesteps
+         * 
+         * @param timesteps: Number of timesteps in the prediction horizon
+         * @param blocking: Steps each control is held for, see Params::forward
          */
-        explicit VarIndices(size_t timesteps);
+        explicit VarIndices(size_t timesteps, size_t blocking = 1);
+
+        /**
+         * Get the control applied at a step
+         * 
+         * @param t: Step of the horizon, 0 to timesteps - 2
+         * 
+         * @return Offset of the control from omega_start or acc_start
+         */
+        size_t control(size_t t) const
+        {
+            return t / blocking;
+        }
+    };
+
+    /// Outcome of one NLP solve
+    struct SolveStats
+    {
+        /// CppAD::ipopt::solve_result status, 1 is success
+        int status = 0;
+        size_t iterations = 0;
+        /// Wall time of the whole solve
+        double seconds = 0.0;
+        /// Wall time evaluating the objective, constraints and their derivatives
+        double evalSeconds = 0.0;
+        /// Wall time factorizing and back solving the linear systems, 0 if Ipopt does not time them
+        double linearSolverSeconds = 0.0;
+        /// Heap allocations during the solve, 0 unless the allocation hooks are linked
+        uint64_t allocations = 0;
+        /// True for a control step that followed the previous plan instead of solving, see EventTrigger
+        bool skipped = false;
+        /// Prediction horizon the NLP was posed over
+        size_t timesteps = 0;
+        /// True if Ipopt started from a cached solution, see WarmStartCache
+        bool warmStarted = false;
+
+        bool success() const
+        {
+            return status == 1;
+        }
     };
 
+    /// Optimal open-loop plan of a solve, in the robot frame the NLP was posed in
+    struct Plan
+    {
+        /// Predicted states, the first is the initial state of the NLP
+        std::vector<double> x, y, theta, v;
+        /// Controls of every step, one less than the states. Repeated over a block with move blocking
+        std::vector<double> omega, acc;
+        /// Optimal cost
+        double cost = 0.0;
+    };
+
+    class WarmStartCache;
+
     /// Main class for MPC implementation
     class MPC
     {
@@ -116,16 +195,154 @@ namespace mpc
          * Solve the NLP
          * 
          * @param state: Current state of the model
+         * @param plan: If given, receives the whole optimal plan. Its buffers are reused
          * 
          * @return Vector of manipulated variables and other parameters like cost
          */
-        std::vector<double> solve(Eigen::VectorXd &state);
+        std::vector<double> solve(Eigen::VectorXd &state, Plan *plan = nullptr);
+
+        /**
+         * Start the solves from the nearest earlier solution, cold starts by default
+         * 
+         * @param cache: Shared cache of solutions, nullptr for cold starts
+         */
+        void setWarmStart(WarmStartCache *cache);
+
+        /**
+         * Get the statistics of the last solve
+         * 
+         * @return Status, iterations and timing
+         */
+        const SolveStats &stats() const;
 
     private:
         const Params m_Params;
         const Eigen::VectorXd m_Coeffs;
         const VarIndices m_VarIndices;
+
+        SolveStats m_stats;
+        WarmStartCache *m_warmStart = nullptr;
+    };
+
+    /// One NLP of a batch, everything needed to construct and solve an MPC
+    struct Problem
+    {
+        Params params;
+        /// Coefficients of the reference polynomial
+        Eigen::VectorXd coeffs;
+        /// Current state of the model
+        Eigen::VectorXd state;
+        /// Receives the optimal plan if set
+        Plan *plan = nullptr;
+        /// Warm starts the solve if set
+        WarmStartCache *warmStart = nullptr;
     };
+
+    /**
+     * Get the linear solver Ipopt uses, as set by the linear_solver option, e.g. in ipopt.opt
+     * 
+     * @return Name of the linear solver, empty if Ipopt failed to initialize
+     */
+    std::string linearSolver();
+
+    /**
+     * Check if Ipopt can solve on several threads at once
+     * 
+     * @return True for the linear solvers known to be thread-safe (HSL, SPRAL, MKL Pardiso), false for MUMPS
+     */
+    bool threadSafeLinearSolver();
+
+    /**
+     * Worker threads for solveBatch, alive as long as the pool
+     * 
+     * Each worker keeps its Ipopt application and NLP buffers from one batch to the next, and its slot
+     * in the allocation accounting. CppAD is switched to parallel mode while a batch runs. The thread
+     * numbers CppAD sees are those of the pool, so only one pool with more than one thread may exist
+     * at a time.
+     */
+    class SolverPool
+    {
+    public:
+        /**
+         * Constructor, starts the workers
+         * 
+         * @param threads: Number of threads solving a batch, the calling thread included
+         * 
+         * @throw std::invalid_argument for more than one thread if the linear solver is not thread-safe
+         */
+        explicit SolverPool(size_t threads);
+
+        /// Stops the workers, releasing their solver memory
+        ~SolverPool();
+
+        /// Delete copy constructor
+        SolverPool(const SolverPool &) = delete;
+
+        size_t threads() const;
+
+        /**
+         * Run a task for every index, on the workers and the calling thread
+         * 
+         * @param count: Number of indices
+         * @param task: Called once for every index below count, from any of the threads
+         */
+        void forEach(size_t count, const std::function<void(size_t)> &task);
+
+    private:
+        void _work(size_t id);
+        void _drain();
+
+        const size_t m_threads;
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_start, m_done;
+
+        /// Task of the running batch, taken index by index
+        const std::function<void(size_t)> *m_task = nullptr;
+        size_t m_count = 0;
+        std::atomic<size_t> m_next{0};
+
+        /// Batches started so far, workers still busy with the current one
+        uint64_t m_batch = 0;
+        size_t m_busy = 0;
+        bool m_stop = false;
+    };
+
+    /**
+     * Solve a batch of independent NLPs
+     * 
+     * @param problems: Problems to solve
+     * @param pool: Worker threads to share the problems among, nullptr solves on the calling thread
+     * @param stats: If given, receives the MPC::stats of each problem
+     * 
+     * @return Results of MPC::solve in the order of the problems, empty for a problem that threw
+     */
+    std::vector<std::vector<double>> solveBatch(std::vector<Problem> &problems, SolverPool *pool = nullptr,
+                                                std::vector<SolveStats> *stats = nullptr);
+
+    /// Counts over every MPC::solve of the process
+    struct SolverTotals
+    {
+        uint64_t solves, failures, iterations;
+        /// Control steps that followed the previous plan instead of solving
+        uint64_t skipped;
+        /// Prediction horizons summed over the solves, divide by the solves for the mean
+        uint64_t timesteps;
+        /// NLP workspaces set up, once per thread, horizon and move blocking
+        uint64_t setups;
+        /// Wall time spent in Ipopt, summed over threads
+        double seconds;
+    };
+
+    /**
+     * Get the solver totals so far, safe to call while solves are running on other threads
+     * 
+     * Take the difference of two calls for the solves in between
+     * 
+     * @return Totals
+     */
+    SolverTotals solverTotals();
 } // namespace mpc
 
 #endif // DIFF_DRIVE_MPC_H_
\ No newline at end of file
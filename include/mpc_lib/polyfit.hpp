@@ -0,0 +1,98 @@
+#ifndef MPC_POLYFIT_HPP_
+#define MPC_POLYFIT_HPP_
+
+#include <Eigen/Core>
+#include <Eigen/QR>
+
+/**
+ * Fixed-size polynomial kernels for the per-step reference fit
+ * 
+ * Sizes are template parameters, so all matrices live on the stack and nothing is allocated in the
+ * control loop.
+ */
+namespace mpc::utils
+{
+    /**
+     * Evaluate a polynomial with Horner's scheme
+     * 
+     * Works for any scalar type with + and *, including CppAD::AD<double>
+     * 
+     * @param coeffs: Coefficients of the polynomial, constant term first
+     * @param x: The X value at which the polynomial is to be evaluated
+     * 
+     * @return Result
+     */
+    template <typename __T, typename __Coeffs>
+    __T horner(const __Coeffs &coeffs, const __T &x)
+    {
+        const int n = static_cast<int>(coeffs.size());
+
+        if (n == 0)
+            return __T(0.0);
+
+        __T result = coeffs[n - 1];
+
+        for (int i = n - 2; i >= 0; i--)
+            result = result * x + coeffs[i];
+
+        return result;
+    }
+
+    /**
+     * Evaluate the derivative of a polynomial with Horner's scheme
+     * 
+     * @param coeffs: Coefficients of the polynomial, constant term first
+     * @param x: The X value at which the derivative is to be evaluated
+     * 
+     * @return Result
+     */
+    template <typename __T, typename __Coeffs>
+    __T hornerDerivative(const __Coeffs &coeffs, const __T &x)
+    {
+        const int n = static_cast<int>(coeffs.size());
+
+        if (n < 2)
+            return __T(0.0);
+
+        __T result = (n - 1) * coeffs[n - 1];
+
+        for (int i = n - 2; i >= 1; i--)
+            result = result * x + i * coeffs[i];
+
+        return result;
+    }
+
+    /**
+     * Least squares polynomial fit of a fixed number of points
+     * 
+     * Same Householder QR as the dynamic polyfit, on stack allocated matrices
+     * 
+     * @tparam __Order: Order of the polynomial
+     * @tparam __Window: Number of points
+     * 
+     * @param xvals: The x values
+     * @param yvals: The y values
+     * 
+     * @return The coefficients, constant term first
+     */
+    template <int __Order, int __Window>
+    Eigen::Matrix<double, __Order + 1, 1> polyfit(const Eigen::Matrix<double, __Window, 1> &xvals,
+                                                  const Eigen::Matrix<double, __Window, 1> &yvals)
+    {
+        static_assert(__Order >= 1 && __Window > __Order, "Need more points than the order of the polynomial");
+
+        Eigen::Matrix<double, __Window, __Order + 1> A;
+
+        for (int j = 0; j < __Window; j++)
+        {
+            A(j, 0) = 1.0;
+
+            for (int i = 0; i < __Order; i++)
+                A(j, i + 1) = A(j, i) * xvals(j);
+        }
+
+        return A.householderQr().solve(yvals);
+    }
+} // namespace mpc::utils
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef MPC_SOLVER_PROFILE_H_
+#define MPC_SOLVER_PROFILE_H_
+
+#include "primary.h"
+#include "mpc_lib/mpc.h"
+#include "utils/hdr_histogram.hpp"
+#include "utils/json_logger.hpp"
+
+namespace mpc
+{
+    /**
+     * Solver cost of a rollout, aggregated from the SolveStats of its steps
+     */
+    class SolverProfile
+    {
+    public:
+        SolverProfile();
+
+        /**
+         * Add a solve, a skipped one only counts as such
+         * 
+         * @param stats: Statistics of the solve
+         */
+        void add(const SolveStats &stats);
+
+        /**
+         * Add the solves of another profile
+         * 
+         * @param other: Profile to add
+         */
+        void merge(const SolverProfile &other);
+
+        void reset();
+
+        /// Wall time of the solves, in nanoseconds
+        const HdrHistogram &latency() const;
+
+        /// Ipopt iterations of the solves
+        const HdrHistogram &iterations() const;
+
+        uint64_t solves() const;
+        uint64_t failures() const;
+
+        /// Control steps that followed the previous plan instead of solving
+        uint64_t skipped() const;
+
+        /// Prediction horizon averaged over the solves, 0 without solves
+        double meanTimesteps() const;
+
+        /// Total time evaluating the NLP functions and derivatives
+        double evalSeconds() const;
+
+        /// Total time in the linear solver
+        double linearSolverSeconds() const;
+
+        /// Total heap allocations of the solves, 0 unless the allocation hooks are linked
+        uint64_t allocations() const;
+
+        /**
+         * Get the summary saved with the run output
+         * 
+         * @return Percentiles and totals
+         */
+        SolverSummary summary() const;
+
+    private:
+        HdrHistogram m_latency;
+        HdrHistogram m_iterations;
+        uint64_t m_failures;
+        uint64_t m_skipped;
+        uint64_t m_timesteps;
+        double m_evalSeconds;
+        double m_linearSolverSeconds;
+        uint64_t m_allocations;
+    };
+} // namespace mpc
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef MPC_WARM_START_CACHE_H_
+#define MPC_WARM_START_CACHE_H_
+
+#include "primary.h"
+#include "mpc_lib/mpc.h"
+#include <array>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace mpc
+{
+    /**
+     * Solutions of earlier NLPs, handed out as the initial guess of similar ones
+     *
+     * Every organism of a GA run starts from the same initial state, so the rollouts pose the same few
+     * NLPs again and again with slightly different weights. The cache keeps the solutions of successful
+     * solves, keyed by the normalized initial state, reference cubic and weights, and finds the nearest
+     * one with a k-d tree. Only NLPs of the same horizon and move blocking share solutions.
+     *
+     * A guess only changes where Ipopt starts, MPC::solve solves again from the cold start whenever a
+     * warm started solve fails. Solutions agree within the Ipopt tolerance, the iterations may differ.
+     *
+     * Bounded, the oldest solution of a size is replaced once it holds capacity of them. Thread-safe.
+     */
+    class WarmStartCache
+    {
+    public:
+        /// Initial state, reference cubic and weights
+        static const size_t DIM = 6 + 4 + 7;
+        typedef std::array<double, DIM> Key;
+
+        struct Stats
+        {
+            uint64_t lookups = 0, hits = 0;
+            /// Warm started solves that failed and were solved again from the cold start
+            uint64_t fallbacks = 0;
+            /// Ipopt iterations of the cold and the warm started solves, fallbacks included
+            uint64_t coldSolves = 0, coldIterations = 0;
+            uint64_t warmSolves = 0, warmIterations = 0;
+
+            Stats operator-(const Stats &other) const;
+
+            double hitRate() const;
+
+            /**
+             * Estimate the Ipopt iterations saved by the warm starts
+             *
+             * Assumes a warm started solve would have taken the mean iterations of the cold ones
+             *
+             * @return Iterations saved, negative if the warm starts cost iterations
+             */
+            double iterationsSaved() const;
+        };
+
+        /**
+         * Constructor
+         *
+         * @param capacity: Solutions kept per horizon and move blocking
+         * @param radius: Largest distance of a hit, in normalized units, see key()
+         */
+        WarmStartCache(size_t capacity, double radius);
+
+        /**
+         * Normalize an NLP into a key
+         *
+         * States and coefficients are divided by their typical magnitudes along a path, the weights,
+         * spanning orders of magnitude, are compared by their logarithm. A distance of 1 is about a
+         * tenth of a meter or radian, or weights a factor of 3 apart.
+         *
+         * @param state: Initial state of the NLP
+         * @param coeffs: Coefficients of the reference cubic
+         * @param weights: Weights of the cost function
+         *
+         * @return The key
+         */
+        static Key key(const Eigen::VectorXd &state, const Eigen::VectorXd &coeffs, const Params::Weights &weights);
+
+        /**
+         * Find the solution of the nearest earlier NLP of the same size
+         *
+         * @param key: Key of the NLP
+         * @param timesteps: Horizon of the NLP
+         * @param guess: Receives the solution on a hit
+         * @param size: Number of variables of the NLP
+         *
+         * @return True on a hit
+         */
+        bool lookup(const Key &key, size_t timesteps, double *guess, size_t size);
+
+        /**
+         * Keep the solution of a successful solve
+         *
+         * @param key: Key of the NLP
+         * @param timesteps: Horizon of the NLP
+         * @param solution: Optimal variables
+         * @param size: Number of variables
+         */
+        void insert(const Key &key, size_t timesteps, const double *solution, size_t size);
+
+        /**
+         * Count a solve into the statistics
+         *
+         * @param stats: Statistics of the solve
+         * @param fallback: True if the warm start failed and it was solved again
+         */
+        void record(const SolveStats &stats, bool fallback);
+
+        Stats stats() const;
+
+        /// Solutions kept, over every size
+        size_t size() const;
+
+    private:
+        /// Node of the implicit k-d tree, the split is kept since the entry may be replaced
+        struct Node
+        {
+            uint32_t entry;
+            double split;
+        };
+
+        /// Solutions of one NLP size
+        struct Store
+        {
+            std::vector<Key> keys;
+            /// Solutions back to back
+            std::vector<double> solutions;
+            /// Entry replaced next once full
+            size_t next = 0;
+
+            /// Tree over the entries at the last build, in order of a balanced median split
+            std::vector<Node> tree;
+            /// Entries added or replaced since, searched one by one
+            std::vector<uint32_t> pending;
+            std::vector<bool> stale;
+        };
+
+        void _build(Store &store);
+        void _buildRange(Store &store, std::vector<uint32_t> &entries, size_t lo, size_t hi, size_t depth);
+        void _search(const Store &store, const Key &key, size_t lo, size_t hi, size_t depth, double &best, int64_t &nearest) const;
+
+        static double _distance2(const Key &a, const Key &b);
+
+        const size_t m_capacity;
+        const double m_radius2;
+
+        mutable std::mutex m_mutex;
+        /// By timesteps and number of variables
+        std::map<std::pair<size_t, size_t>, Store> m_stores;
+        Stats m_stats;
+    };
+} // namespace mpc
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef ALLOC_TRACKER_H_
+#define ALLOC_TRACKER_H_
+
+#include "primary.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Heap allocation accounting
+ *
+ * The counters live here, the allocation functions that feed them in src/utils/alloc_hooks.cpp. Only
+ * tests and benchmarks link the hooks, everywhere else every count stays 0 and tracking() is false.
+ *
+ * Every thread counts into its own slot, so counting costs no contention. Take the difference of two
+ * snapshots of local() for the allocations of the calling thread in between, of total() for those of
+ * the whole process. ALLOC_SCOPE("name") attributes the allocations of the calling thread until the end
+ * of the enclosing scope to the site name, nested scopes included, see sites(). The name must be a
+ * string literal, only the pointer is stored.
+ *
+ * Nothing here allocates, it runs inside the allocation functions.
+ */
+namespace alloc
+{
+    struct Counts
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        /// Bytes requested, frees are not subtracted
+        uint64_t bytes = 0;
+
+        Counts operator-(const Counts &other) const
+        {
+            Counts diff;
+            diff.allocations = allocations - other.allocations;
+            diff.frees = frees - other.frees;
+            diff.bytes = bytes - other.bytes;
+
+            return diff;
+        }
+
+        Counts &operator+=(const Counts &other)
+        {
+            allocations += other.allocations;
+            frees += other.frees;
+            bytes += other.bytes;
+
+            return *this;
+        }
+    };
+
+    /// Counts of a thread or a site, only the owning thread writes a thread slot
+    struct Slot
+    {
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<uint64_t> bytes{0};
+
+        Counts load() const
+        {
+            Counts counts;
+            counts.allocations = allocations.load(std::memory_order_relaxed);
+            counts.frees = frees.load(std::memory_order_relaxed);
+            counts.bytes = bytes.load(std::memory_order_relaxed);
+
+            return counts;
+        }
+
+        void add(const Counts &counts)
+        {
+            allocations.fetch_add(counts.allocations, std::memory_order_relaxed);
+            frees.fetch_add(counts.frees, std::memory_order_relaxed);
+            bytes.fetch_add(counts.bytes, std::memory_order_relaxed);
+        }
+    };
+
+    /// Threads beyond this share the last slot, at the price of atomic updates
+    const size_t MAX_THREADS = 256;
+    const size_t MAX_SITES = 64;
+
+    namespace detail
+    {
+        inline std::atomic<bool> s_hooked(false);
+        inline std::atomic<size_t> s_threads(0);
+        inline Slot s_threadSlots[MAX_THREADS];
+
+        inline std::atomic<const char *> s_siteClaims[MAX_SITES];
+        inline Slot s_siteSlots[MAX_SITES];
+
+        inline Slot &slot()
+        {
+            // Constant initialized, first use from inside malloc must not allocate
+            thread_local Slot *t_slot = nullptr;
+
+            if (!t_slot)
+                t_slot = &s_threadSlots[std::min(s_threads.fetch_add(1, std::memory_order_relaxed), MAX_THREADS - 1)];
+
+            return *t_slot;
+        }
+
+        /// The last slot may have several writers, which must add atomically
+        inline bool shared(const Slot &slot)
+        {
+            return &slot == &s_threadSlots[MAX_THREADS - 1];
+        }
+
+        inline Slot *site(const char *name)
+        {
+            for (size_t i = 0; i < MAX_SITES; i++)
+            {
+                const char *claimed = s_siteClaims[i].load(std::memory_order_acquire);
+
+                if (!claimed && s_siteClaims[i].compare_exchange_strong(claimed, name, std::memory_order_acq_rel))
+                    claimed = name;
+
+                if (claimed == name)
+                    return &s_siteSlots[i];
+            }
+
+            return nullptr;
+        }
+    } // namespace detail
+
+    /// Called by the allocation functions
+    inline void onAllocation(size_t bytes)
+    {
+        Slot &slot = detail::slot();
+
+        if (detail::shared(slot))
+        {
+            slot.allocations.fetch_add(1, std::memory_order_relaxed);
+            slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return;
+        }
+
+        slot.allocations.store(slot.allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        slot.bytes.store(slot.bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    }
+
+    /// Called by the deallocation functions, not for null pointers
+    inline void onFree()
+    {
+        Slot &slot = detail::slot();
+
+        if (detail::shared(slot))
+        {
+            slot.frees.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        slot.frees.store(slot.frees.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Check if the allocation hooks are linked
+     *
+     * @return False if every count stays 0
+     */
+    inline bool tracking()
+    {
+        return detail::s_hooked.load(std::memory_order_relaxed);
+    }
+
+    /// Counts of the calling thread so far
+    inline Counts local()
+    {
+        return detail::slot().load();
+    }
+
+    /// Counts of every thread so far, including finished ones
+    inline Counts total()
+    {
+        Counts counts;
+        const size_t threads = std::min(detail::s_threads.load(std::memory_order_relaxed), MAX_THREADS);
+
+        for (size_t i = 0; i < threads; i++)
+            counts += detail::s_threadSlots[i].load();
+
+        return counts;
+    }
+
+    struct SiteCounts
+    {
+        const char *name;
+        Counts counts;
+    };
+
+    /**
+     * Get the counts attributed to every site so far
+     *
+     * @return Counts per ALLOC_SCOPE name, in order of first use
+     */
+    inline std::vector<SiteCounts> sites()
+    {
+        std::vector<SiteCounts> result;
+
+        for (size_t i = 0; i < MAX_SITES; i++)
+        {
+            const char *name = detail::s_siteClaims[i].load(std::memory_order_acquire);
+
+            if (!name)
+                break;
+
+            result.push_back({name, detail::s_siteSlots[i].load()});
+        }
+
+        return result;
+    }
+
+    /// Attributes the allocations of the calling thread from construction to destruction to a site
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name) : m_name(name), m_start(local())
+        {
+        }
+
+        ~Scope()
+        {
+            // Sites beyond MAX_SITES are dropped
+            if (Slot *site = detail::site(m_name))
+                site->add(local() - m_start);
+        }
+
+        Scope(const Scope &) = delete;
+
+    private:
+        const char *m_name;
+        const Counts m_start;
+    };
+} // namespace alloc
+
+#define ALLOC_CONCAT_(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_(a, b)
+#define ALLOC_SCOPE(name) alloc::Scope ALLOC_CONCAT(_allocScope, __LINE__)(name)
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef ASYNC_OUTPUT_H_
+#define ASYNC_OUTPUT_H_
+
+#include "primary.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Bounded lock-free queue for one producer and one consumer thread
+ *
+ * @tparam T: Element type, must be default constructible and movable
+ * @tparam Capacity: Number of slots, a power of two
+ */
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_tail(0)
+    {
+    }
+
+    /**
+     * Append an element, producer thread only
+     *
+     * @param value: Element, left untouched if the queue is full
+     *
+     * @return False if the queue is full
+     */
+    bool push(T &value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        m_slots[tail & (Capacity - 1)] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Take the oldest element, consumer thread only
+     *
+     * @param value: Receives the element
+     *
+     * @return False if the queue is empty
+     */
+    bool pop(T &value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        T &slot = m_slots[head & (Capacity - 1)];
+        value = std::move(slot);
+        // Release what the element owned now, not when the slot is reused
+        slot = T();
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T m_slots[Capacity];
+
+    /// Separate cache lines, each index is written by one thread only
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
+
+/**
+ * Background thread for file and terminal output
+ *
+ * The thread running the GA (or the MPC) hands over finished work, e.g. a trajectory to save or a
+ * progress bar update, and continues without waiting for the disk or the terminal. Both queues
+ * have a single producer, only post from the thread that drives the run. When a queue is full the
+ * producer waits for a free slot rather than dropping output.
+ *
+ * Everything posted is written before the process exits normally: flush() waits for the queues to
+ * drain and the instance flushes when it is destroyed.
+ */
+class AsyncOutput
+{
+public:
+    typedef std::function<void()> Task;
+
+    /// Delete copy constructor
+    AsyncOutput(const AsyncOutput &) = delete;
+
+    /// Delete assignment operator
+    AsyncOutput &operator=(const AsyncOutput &) = delete;
+
+    /**
+     * Get the shared instance, the thread is started on first use
+     */
+    static AsyncOutput &get()
+    {
+        static AsyncOutput instance;
+        return instance;
+    }
+
+    ~AsyncOutput()
+    {
+        flush();
+
+        m_stop.store(true, std::memory_order_release);
+        _wake();
+        m_thread.join();
+    }
+
+    /**
+     * Run a task on the output thread
+     *
+     * @param task: Task owning everything it writes, it must not refer to state the producer modifies
+     */
+    void post(Task task)
+    {
+        _push(m_tasks, task);
+    }
+
+    /**
+     * Print to the console from the output thread
+     *
+     * @param text: Text to print
+     */
+    void print(std::string text)
+    {
+        _push(m_console, text);
+    }
+
+    /**
+     * Wait until everything posted so far is written
+     */
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_drained.wait(lock, [this]() { return m_completed.load(std::memory_order_acquire) == m_posted; });
+    }
+
+private:
+    static const size_t TASK_SLOTS = 64;
+    static const size_t CONSOLE_SLOTS = 256;
+
+    AsyncOutput() : m_posted(0), m_completed(0), m_stop(false)
+    {
+        m_thread = std::thread(&AsyncOutput::_run, this);
+    }
+
+    template <typename Queue, typename T>
+    void _push(Queue &queue, T &value)
+    {
+        m_posted++;
+
+        while (!queue.push(value))
+        {
+            _wake();
+            std::this_thread::yield();
+        }
+
+        _wake();
+    }
+
+    void _wake()
+    {
+        // Taking the lock orders the notification after the check in _run
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.notify_one();
+    }
+
+    void _run()
+    {
+        Task task;
+        std::string text;
+
+        while (true)
+        {
+            size_t done = 0;
+
+            // Terminal first, progress should not lag behind a slow file
+            while (m_console.pop(text))
+            {
+                CONSOLE_LOG(text << std::flush);
+                done++;
+            }
+
+            if (m_tasks.pop(task))
+            {
+                task();
+                task = nullptr;
+                done++;
+            }
+
+            if (done > 0)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_completed.fetch_add(done, std::memory_order_release);
+                m_drained.notify_all();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            if (m_stop.load(std::memory_order_acquire) && m_console.empty() && m_tasks.empty())
+                return;
+
+            m_pending.wait(lock, [this]() {
+                return m_stop.load(std::memory_order_acquire) || !m_console.empty() || !m_tasks.empty();
+            });
+        }
+    }
+
+    SpscQueue<Task, TASK_SLOTS> m_tasks;
+    SpscQueue<std::string, CONSOLE_SLOTS> m_console;
+
+    /// Elements pushed, producer thread only
+    size_t m_posted;
+
+    /// Elements written by the output thread
+    std::atomic<size_t> m_completed;
+
+    std::atomic<bool> m_stop;
+
+    /// Only used to sleep, the queues themselves are lock-free
+    std::mutex m_mutex;
+    std::condition_variable m_pending;
+    std::condition_variable m_drained;
+
+    std::thread m_thread;
+};
+
+#endif
@@ -27,14 +27,37 @@ namespace config
     {
         struct General
         {
-            size_t generations, population_size, mating_pool_size, iterations_per_genome;
-            bool interactive_decision_tree;
+            size_t generations, population_size, mating_pool_size, iterations_per_genome, checkpoint_interval;
+            bool interactive_decision_tree, idt_speculation, multi_objective, record_trajectories;
         } general;
 
+        struct Objective
+        {
+            std::string solver_cost;
+            double solver_weight;
+        } objective;
+
         struct Operators
         {
             double mutation_probability, crossover_bias;
         } operators;
+
+        struct Archive
+        {
+            std::string file;
+            double seed_fraction;
+        } archive;
+
+        struct Lockstep
+        {
+            bool enabled;
+            size_t worker_threads;
+        } lockstep;
+
+        struct Output
+        {
+            std::string run_file, telemetry_file;
+        } output;
     };
 
     /**
@@ -49,6 +72,12 @@ namespace config
 
         } general;
 
+        struct __Reference
+        {
+            /// Binary route file, empty to follow the x axis
+            std::string route_file;
+        } reference;
+
         struct __Initial
         {
             double x, y, theta, linear_velocity, angular_velocity, throttle;
@@ -64,6 +93,30 @@ namespace config
             double omega, throttle;
         } max_bounds;
 
+        struct __EventTrigger
+        {
+            /// Follow the last plan instead of solving while the state stays within the tolerances
+            bool enabled;
+            double position, heading, velocity;
+        } event_trigger;
+
+        struct __AdaptiveHorizon
+        {
+            /// Adapt the horizon between the bounds instead of using timesteps
+            bool enabled;
+            size_t min_timesteps, max_timesteps, step;
+            double grow_error, shrink_error, max_iterations;
+            size_t move_blocking;
+        } adaptive_horizon;
+
+        struct __WarmStart
+        {
+            /// Start the solves from the nearest earlier solution
+            bool enabled;
+            size_t capacity;
+            double radius;
+        } warm_start;
+
         struct __WeightBounds
         {
             std::pair<double, double> w_cte, w_etheta, w_vel, w_omega, w_acc, w_omega_d, w_acc_d;
@@ -82,6 +135,12 @@ namespace config
 
         } general;
 
+        struct __Reference
+        {
+            /// Binary route file, empty to follow the x axis
+            std::string route_file;
+        } reference;
+
         struct __Initial
         {
             double x, y, theta, linear_velocity, angular_velocity, throttle;
@@ -97,6 +156,30 @@ namespace config
             double omega, throttle;
         } max_bounds;
 
+        struct __EventTrigger
+        {
+            /// Follow the last plan instead of solving while the state stays within the tolerances
+            bool enabled;
+            double position, heading, velocity;
+        } event_trigger;
+
+        struct __AdaptiveHorizon
+        {
+            /// Adapt the horizon between the bounds instead of using timesteps
+            bool enabled;
+            size_t min_timesteps, max_timesteps, step;
+            double grow_error, shrink_error, max_iterations;
+            size_t move_blocking;
+        } adaptive_horizon;
+
+        struct __WarmStart
+        {
+            /// Start the solves from the nearest earlier solution
+            bool enabled;
+            size_t capacity;
+            double radius;
+        } warm_start;
+
         struct __Weights
         {
             double w_cte, w_etheta, w_vel, w_omega, w_acc, w_omega_d, w_acc_d;
@@ -224,13 +307,30 @@ namespace config
                 m_genConfig.general.population_size = m_root["Genetic-Algorithm"]["General"]["population_size"].as<size_t>();
                 m_genConfig.general.mating_pool_size = m_root["Genetic-Algorithm"]["General"]["mating_pool_size"].as<size_t>();
                 m_genConfig.general.iterations_per_genome = m_root["Genetic-Algorithm"]["General"]["iterations_per_genome"].as<size_t>();
+                m_genConfig.general.checkpoint_interval = m_root["Genetic-Algorithm"]["General"]["checkpoint_interval"].as<size_t>();
                 m_genConfig.general.interactive_decision_tree = m_root["Genetic-Algorithm"]["General"]["interactive_decision_tree"].as<bool>();
+                m_genConfig.general.idt_speculation = m_root["Genetic-Algorithm"]["General"]["idt_speculation"].as<bool>();
+                m_genConfig.general.multi_objective = m_root["Genetic-Algorithm"]["General"]["multi_objective"].as<bool>();
+                m_genConfig.general.record_trajectories = m_root["Genetic-Algorithm"]["General"]["record_trajectories"].as<bool>();
+
+                m_genConfig.objective.solver_cost = m_root["Genetic-Algorithm"]["Objective"]["solver_cost"].as<std::string>();
+                m_genConfig.objective.solver_weight = m_root["Genetic-Algorithm"]["Objective"]["solver_weight"].as<double>();
 
                 m_genConfig.operators.mutation_probability = m_root["Genetic-Algorithm"]["Operators"]["mutation_probability"].as<double>();
                 m_genConfig.operators.crossover_bias = m_root["Genetic-Algorithm"]["Operators"]["crossover_bias"].as<double>();
 
+                m_genConfig.archive.file = m_root["Genetic-Algorithm"]["Archive"]["file"].as<std::string>();
+                m_genConfig.archive.seed_fraction = m_root["Genetic-Algorithm"]["Archive"]["seed_fraction"].as<double>();
+
+                m_genConfig.lockstep.enabled = m_root["Genetic-Algorithm"]["Lockstep"]["enabled"].as<bool>();
+                m_genConfig.lockstep.worker_threads = m_root["Genetic-Algorithm"]["Lockstep"]["worker_threads"].as<size_t>();
+
+                m_genConfig.output.run_file = m_root["Genetic-Algorithm"]["Output"]["run_file"].as<std::string>();
+                m_genConfig.output.telemetry_file = m_root["Genetic-Algorithm"]["Output"]["telemetry_file"].as<std::string>();
+
                 m_mpcConfigGA.general.timesteps = m_root["MPC-Controller"]["General"]["timesteps"].as<size_t>();
                 m_mpcConfigGA.general.sample_time = m_root["MPC-Controller"]["General"]["sample_time"].as<double>();
+                m_mpcConfigGA.reference.route_file = m_root["MPC-Controller"]["Reference"]["route_file"].as<std::string>();
 
                 m_mpcConfigGA.initial_state.x = m_root["MPC-Controller"]["Initial-State"]["x"].as<double>();
                 m_mpcConfigGA.initial_state.y = m_root["MPC-Controller"]["Initial-State"]["y"].as<double>();
@@ -246,6 +346,24 @@ namespace config
                 m_mpcConfigGA.max_bounds.omega = m_root["MPC-Controller"]["Max-Bounds"]["omega"].as<double>();
                 m_mpcConfigGA.max_bounds.throttle = m_root["MPC-Controller"]["Max-Bounds"]["throttle"].as<double>();
 
+                m_mpcConfigGA.event_trigger.enabled = m_root["MPC-Controller"]["Event-Trigger"]["enabled"].as<bool>();
+                m_mpcConfigGA.event_trigger.position = m_root["MPC-Controller"]["Event-Trigger"]["position"].as<double>();
+                m_mpcConfigGA.event_trigger.heading = m_root["MPC-Controller"]["Event-Trigger"]["heading"].as<double>();
+                m_mpcConfigGA.event_trigger.velocity = m_root["MPC-Controller"]["Event-Trigger"]["velocity"].as<double>();
+
+                m_mpcConfigGA.adaptive_horizon.enabled = m_root["MPC-Controller"]["Adaptive-Horizon"]["enabled"].as<bool>();
+                m_mpcConfigGA.adaptive_horizon.min_timesteps = m_root["MPC-Controller"]["Adaptive-Horizon"]["min_timesteps"].as<size_t>();
+                m_mpcConfigGA.adaptive_horizon.max_timesteps = m_root["MPC-Controller"]["Adaptive-Horizon"]["max_timesteps"].as<size_t>();
+                m_mpcConfigGA.adaptive_horizon.step = m_root["MPC-Controller"]["Adaptive-Horizon"]["step"].as<size_t>();
+                m_mpcConfigGA.adaptive_horizon.grow_error = m_root["MPC-Controller"]["Adaptive-Horizon"]["grow_error"].as<double>();
+                m_mpcConfigGA.adaptive_horizon.shrink_error = m_root["MPC-Controller"]["Adaptive-Horizon"]["shrink_error"].as<double>();
+                m_mpcConfigGA.adaptive_horizon.max_iterations = m_root["MPC-Controller"]["Adaptive-Horizon"]["max_iterations"].as<double>();
+                m_mpcConfigGA.adaptive_horizon.move_blocking = m_root["MPC-Controller"]["Adaptive-Horizon"]["move_blocking"].as<size_t>();
+
+                m_mpcConfigGA.warm_start.enabled = m_root["MPC-Controller"]["Warm-Start"]["enabled"].as<bool>();
+                m_mpcConfigGA.warm_start.capacity = m_root["MPC-Controller"]["Warm-Start"]["capacity"].as<size_t>();
+                m_mpcConfigGA.warm_start.radius = m_root["MPC-Controller"]["Warm-Start"]["radius"].as<double>();
+
                 YAML::Node bounds = m_root["MPC-Controller"]["Weight-Bounds"];
 
                 m_mpcConfigGA.weight_bounds.w_cte = std::make_pair(bounds["w_cte"][0].as<double>(), bounds["w_cte"][1].as<double>());
@@ -261,6 +379,7 @@ namespace config
             {
                 m_mpcConfigMono.general.timesteps = m_root["MPC-Controller"]["General"]["timesteps"].as<size_t>();
                 m_mpcConfigMono.general.sample_time = m_root["MPC-Controller"]["General"]["sample_time"].as<double>();
+                m_mpcConfigMono.reference.route_file = m_root["MPC-Controller"]["Reference"]["route_file"].as<std::string>();
 
                 m_mpcConfigMono.initial_state.x = m_root["MPC-Controller"]["Initial-State"]["x"].as<double>();
                 m_mpcConfigMono.initial_state.y = m_root["MPC-Controller"]["Initial-State"]["y"].as<double>();
@@ -276,6 +395,24 @@ namespace config
                 m_mpcConfigMono.max_bounds.omega = m_root["MPC-Controller"]["Max-Bounds"]["omega"].as<double>();
                 m_mpcConfigMono.max_bounds.throttle = m_root["MPC-Controller"]["Max-Bounds"]["throttle"].as<double>();
 
+                m_mpcConfigMono.event_trigger.enabled = m_root["MPC-Controller"]["Event-Trigger"]["enabled"].as<bool>();
+                m_mpcConfigMono.event_trigger.position = m_root["MPC-Controller"]["Event-Trigger"]["position"].as<double>();
+                m_mpcConfigMono.event_trigger.heading = m_root["MPC-Controller"]["Event-Trigger"]["heading"].as<double>();
+                m_mpcConfigMono.event_trigger.velocity = m_root["MPC-Controller"]["Event-Trigger"]["velocity"].as<double>();
+
+                m_mpcConfigMono.adaptive_horizon.enabled = m_root["MPC-Controller"]["Adaptive-Horizon"]["enabled"].as<bool>();
+                m_mpcConfigMono.adaptive_horizon.min_timesteps = m_root["MPC-Controller"]["Adaptive-Horizon"]["min_timesteps"].as<size_t>();
+                m_mpcConfigMono.adaptive_horizon.max_timesteps = m_root["MPC-Controller"]["Adaptive-Horizon"]["max_timesteps"].as<size_t>();
+                m_mpcConfigMono.adaptive_horizon.step = m_root["MPC-Controller"]["Adaptive-Horizon"]["step"].as<size_t>();
+                m_mpcConfigMono.adaptive_horizon.grow_error = m_root["MPC-Controller"]["Adaptive-Horizon"]["grow_error"].as<double>();
+                m_mpcConfigMono.adaptive_horizon.shrink_error = m_root["MPC-Controller"]["Adaptive-Horizon"]["shrink_error"].as<double>();
+                m_mpcConfigMono.adaptive_horizon.max_iterations = m_root["MPC-Controller"]["Adaptive-Horizon"]["max_iterations"].as<double>();
+                m_mpcConfigMono.adaptive_horizon.move_blocking = m_root["MPC-Controller"]["Adaptive-Horizon"]["move_blocking"].as<size_t>();
+
+                m_mpcConfigMono.warm_start.enabled = m_root["MPC-Controller"]["Warm-Start"]["enabled"].as<bool>();
+                m_mpcConfigMono.warm_start.capacity = m_root["MPC-Controller"]["Warm-Start"]["capacity"].as<size_t>();
+                m_mpcConfigMono.warm_start.radius = m_root["MPC-Controller"]["Warm-Start"]["radius"].as<double>();
+
                 m_mpcConfigMono.weights.w_cte = m_root["MPC-Controller"]["Weights"]["w_cte"].as<double>();
                 m_mpcConfigMono.weights.w_etheta = m_root["MPC-Controller"]["Weights"]["w_etheta"].as<double>();
                 m_mpcConfigMono.weights.w_vel = m_root["MPC-Controller"]["Weights"]["w_vel"].as<double>();
@@ -308,13 +445,26 @@ namespace config
                 CONSOLE_LOG("? Population size              : " << m_genConfig.general.population_size << std::endl);
                 CONSOLE_LOG("? Mating pool size             : " << m_genConfig.general.mating_pool_size << std::endl);
                 CONSOLE_LOG("? Iterations per genome        : " << m_genConfig.general.iterations_per_genome << std::endl);
+                CONSOLE_LOG("? Checkpoint interval          : " << m_genConfig.general.checkpoint_interval << std::endl);
                 CONSOLE_LOG("? Interactive Decision Tree    : " << m_genConfig.general.interactive_decision_tree << std::endl);
+                CONSOLE_LOG("? IDT speculative branches     : " << m_genConfig.general.idt_speculation << std::endl);
+                CONSOLE_LOG("? Multi-objective (NSGA-II)    : " << m_genConfig.general.multi_objective << std::endl);
+                CONSOLE_LOG("? Record all trajectories      : " << m_genConfig.general.record_trajectories << std::endl);
+                CONSOLE_LOG("? Solver cost metric           : " << m_genConfig.objective.solver_cost << std::endl);
+                CONSOLE_LOG("? Solver cost weight           : " << m_genConfig.objective.solver_weight << std::endl);
                 CONSOLE_LOG("? Mutation probability         : " << m_genConfig.operators.mutation_probability << std::endl);
                 CONSOLE_LOG("? Crossover bias               : " << m_genConfig.operators.crossover_bias << std::endl);
+                CONSOLE_LOG("? Archive file                 : " << m_genConfig.archive.file << std::endl);
+                CONSOLE_LOG("? Archive seed fraction        : " << m_genConfig.archive.seed_fraction << std::endl);
+                CONSOLE_LOG("? Lockstep rollouts            : " << m_genConfig.lockstep.enabled << std::endl);
+                CONSOLE_LOG("? Lockstep worker threads      : " << m_genConfig.lockstep.worker_threads << std::endl);
+                CONSOLE_LOG("? Run output file              : " << m_genConfig.output.run_file << std::endl);
+                CONSOLE_LOG("? Telemetry file               : " << m_genConfig.output.telemetry_file << std::endl);
                 CONSOLE_LOG(std::endl);
                 CONSOLE_LOG("* PARAMETERS  - Model Predictive Control\n\n");
                 CONSOLE_LOG("? Timesteps                    : " << m_mpcConfigGA.general.timesteps << std::endl);
                 CONSOLE_LOG("? Sample time                  : " << m_mpcConfigGA.general.sample_time << std::endl);
+                CONSOLE_LOG("? Route file                   : " << m_mpcConfigGA.reference.route_file << std::endl);
                 CONSOLE_LOG("? Initial state - x            : " << m_mpcConfigGA.initial_state.x << std::endl);
                 CONSOLE_LOG("? Initial state - y            : " << m_mpcConfigGA.initial_state.y << std::endl);
                 CONSOLE_LOG("? Initial state - theta        : " << m_mpcConfigGA.initial_state.theta << std::endl);
@@ -328,6 +478,21 @@ namespace config
                             << "[ " << -m_mpcConfigGA.max_bounds.omega << ", " << m_mpcConfigGA.max_bounds.omega << " ]" << std::endl);
                 CONSOLE_LOG("? Constraints   - throttle     : "
                             << "[ " << -m_mpcConfigGA.max_bounds.throttle << ", " << m_mpcConfigGA.max_bounds.throttle << " ]" << std::endl);
+                CONSOLE_LOG("? Event trigger                : " << m_mpcConfigGA.event_trigger.enabled << std::endl);
+                CONSOLE_LOG("? Event trigger - position     : " << m_mpcConfigGA.event_trigger.position << std::endl);
+                CONSOLE_LOG("? Event trigger - heading      : " << m_mpcConfigGA.event_trigger.heading << std::endl);
+                CONSOLE_LOG("? Event trigger - velocity     : " << m_mpcConfigGA.event_trigger.velocity << std::endl);
+                CONSOLE_LOG("? Adaptive horizon             : " << m_mpcConfigGA.adaptive_horizon.enabled << std::endl);
+                CONSOLE_LOG("? Adaptive horizon - timesteps : "
+                            << "[ " << m_mpcConfigGA.adaptive_horizon.min_timesteps << ", " << m_mpcConfigGA.adaptive_horizon.max_timesteps << " ] by "
+                            << m_mpcConfigGA.adaptive_horizon.step << std::endl);
+                CONSOLE_LOG("? Adaptive horizon - errors    : "
+                            << "grow above " << m_mpcConfigGA.adaptive_horizon.grow_error << ", shrink below " << m_mpcConfigGA.adaptive_horizon.shrink_error << std::endl);
+                CONSOLE_LOG("? Adaptive horizon - max iter  : " << m_mpcConfigGA.adaptive_horizon.max_iterations << std::endl);
+                CONSOLE_LOG("? Move blocking                : " << m_mpcConfigGA.adaptive_horizon.move_blocking << std::endl);
+                CONSOLE_LOG("? Warm start                   : " << m_mpcConfigGA.warm_start.enabled << std::endl);
+                CONSOLE_LOG("? Warm start - capacity        : " << m_mpcConfigGA.warm_start.capacity << std::endl);
+                CONSOLE_LOG("? Warm start - radius          : " << m_mpcConfigGA.warm_start.radius << std::endl);
                 CONSOLE_LOG("? Weight bounds - w_cte        : "
                             << "[ " << m_mpcConfigGA.weight_bounds.w_cte.first << ", " << m_mpcConfigGA.weight_bounds.w_cte.second << " ]" << std::endl);
                 CONSOLE_LOG("? Weight bounds - w_etheta     : "
@@ -350,6 +515,7 @@ namespace config
                 CONSOLE_LOG("* PARAMETERS  - Model Predictive Control\n\n");
                 CONSOLE_LOG("? Timesteps                    : " << m_mpcConfigMono.general.timesteps << std::endl);
                 CONSOLE_LOG("? Sample time                  : " << m_mpcConfigMono.general.sample_time << std::endl);
+                CONSOLE_LOG("? Route file                   : " << m_mpcConfigMono.reference.route_file << std::endl);
                 CONSOLE_LOG("? Initial state - x            : " << m_mpcConfigMono.initial_state.x << std::endl);
                 CONSOLE_LOG("? Initial state - y            : " << m_mpcConfigMono.initial_state.y << std::endl);
                 CONSOLE_LOG("? Initial state - theta        : " << m_mpcConfigMono.initial_state.theta << std::endl);
@@ -363,6 +529,21 @@ namespace config
                             << "[ " << -m_mpcConfigMono.max_bounds.omega << ", " << m_mpcConfigMono.max_bounds.omega << " ]" << std::endl);
                 CONSOLE_LOG("? Constraints   - throttle     : "
                             << "[ " << -m_mpcConfigMono.max_bounds.throttle << ", " << m_mpcConfigMono.max_bounds.throttle << " ]" << std::endl);
+                CONSOLE_LOG("? Event trigger                : " << m_mpcConfigMono.event_trigger.enabled << std::endl);
+                CONSOLE_LOG("? Event trigger - position     : " << m_mpcConfigMono.event_trigger.position << std::endl);
+                CONSOLE_LOG("? Event trigger - heading      : " << m_mpcConfigMono.event_trigger.heading << std::endl);
+                CONSOLE_LOG("? Event trigger - velocity     : " << m_mpcConfigMono.event_trigger.velocity << std::endl);
+                CONSOLE_LOG("? Adaptive horizon             : " << m_mpcConfigMono.adaptive_horizon.enabled << std::endl);
+                CONSOLE_LOG("? Adaptive horizon - timesteps : "
+                            << "[ " << m_mpcConfigMono.adaptive_horizon.min_timesteps << ", " << m_mpcConfigMono.adaptive_horizon.max_timesteps << " ] by "
+                            << m_mpcConfigMono.adaptive_horizon.step << std::endl);
+                CONSOLE_LOG("? Adaptive horizon - errors    : "
+                            << "grow above " << m_mpcConfigMono.adaptive_horizon.grow_error << ", shrink below " << m_mpcConfigMono.adaptive_horizon.shrink_error << std::endl);
+                CONSOLE_LOG("? Adaptive horizon - max iter  : " << m_mpcConfigMono.adaptive_horizon.max_iterations << std::endl);
+                CONSOLE_LOG("? Move blocking                : " << m_mpcConfigMono.adaptive_horizon.move_blocking << std::endl);
+                CONSOLE_LOG("? Warm start                   : " << m_mpcConfigMono.warm_start.enabled << std::endl);
+                CONSOLE_LOG("? Warm start - capacity        : " << m_mpcConfigMono.warm_start.capacity << std::endl);
+                CONSOLE_LOG("? Warm start - radius          : " << m_mpcConfigMono.warm_start.radius << std::endl);
                 CONSOLE_LOG("? Weight        - w_cte        : " << m_mpcConfigMono.weights.w_cte << std::endl);
                 CONSOLE_LOG("? Weight        - w_etheta     : " << m_mpcConfigMono.weights.w_etheta << std::endl);
                 CONSOLE_LOG("? Weight        - w_vel        : " << m_mpcConfigMono.weights.w_vel << std::endl);
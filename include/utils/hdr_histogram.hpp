@@ -0,0 +1,153 @@
+#ifndef HDR_HISTOGRAM_H_
+#define HDR_HISTOGRAM_H_
+
+#include "primary.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/**
+ * Histogram of non-negative integers with a bounded relative error, in the manner of HdrHistogram
+ *
+ * Values below 2^SUB_BITS are counted exactly. Above, every power of two is split into 2^SUB_BITS
+ * linear sub-buckets, so a percentile is within 2^-SUB_BITS (about 3%) of the recorded value. Values
+ * from 2^MAX_BITS on are counted in the last bucket, with 40 bits nanoseconds go up to 18 minutes.
+ *
+ * Fixed size, recording is a count leading zeros and an increment.
+ */
+class HdrHistogram
+{
+public:
+    static const unsigned SUB_BITS = 5;
+    static const unsigned MAX_BITS = 40;
+    static const size_t SUB_BUCKETS = size_t(1) << SUB_BITS;
+    static const size_t N_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    HdrHistogram()
+    {
+        reset();
+    }
+
+    /**
+     * Count a value
+     *
+     * @param value: Value to count, clamped to the range of the histogram
+     */
+    void record(uint64_t value)
+    {
+        m_counts[_index(value)]++;
+        m_total++;
+        m_sum += value;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    /**
+     * Add the counts of another histogram
+     *
+     * @param other: Histogram to add
+     */
+    void merge(const HdrHistogram &other)
+    {
+        for (size_t i = 0; i < N_BUCKETS; i++)
+            m_counts[i] += other.m_counts[i];
+
+        m_total += other.m_total;
+        m_sum += other.m_sum;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    void reset()
+    {
+        m_counts.fill(0);
+        m_total = 0;
+        m_sum = 0;
+        m_min = UINT64_MAX;
+        m_max = 0;
+    }
+
+    uint64_t count() const
+    {
+        return m_total;
+    }
+
+    /// Smallest recorded value, 0 if empty
+    uint64_t min() const
+    {
+        return m_total > 0 ? m_min : 0;
+    }
+
+    /// Largest recorded value, exact
+    uint64_t max() const
+    {
+        return m_max;
+    }
+
+    /// Mean of the recorded values, exact
+    double mean() const
+    {
+        return m_total > 0 ? static_cast<double>(m_sum) / m_total : 0.0;
+    }
+
+    /**
+     * Get a percentile
+     *
+     * @param percentile: Percentile in [0, 100]
+     *
+     * @return Highest value equivalent to the one at the percentile, 0 if empty
+     */
+    uint64_t percentile(double percentile) const
+    {
+        if (m_total == 0)
+            return 0;
+
+        const double rank = std::max(1.0, std::min(percentile, 100.0) / 100.0 * m_total);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < N_BUCKETS; i++)
+        {
+            seen += m_counts[i];
+
+            if (seen >= rank)
+                return std::min(_highest(i), m_max);
+        }
+
+        return m_max;
+    }
+
+private:
+    static size_t _index(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+            return value;
+
+        const unsigned msb = 63 - __builtin_clzll(value);
+
+        if (msb >= MAX_BITS)
+            return N_BUCKETS - 1;
+
+        const unsigned shift = msb - SUB_BITS;
+
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    /// Highest value counted in a bucket
+    static uint64_t _highest(size_t index)
+    {
+        if (index < SUB_BUCKETS)
+            return index;
+
+        const unsigned shift = index / SUB_BUCKETS - 1;
+        const uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+
+        return lowest + (uint64_t(1) << shift) - 1;
+    }
+
+    std::array<uint32_t, N_BUCKETS> m_counts;
+    uint64_t m_total;
+    uint64_t m_sum;
+    uint64_t m_min, m_max;
+};
+
+#endif
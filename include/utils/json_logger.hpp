@@ -2,67 +2,160 @@
 #define JSON_LOGGER_H_
 
 #include "primary.h"
+#include "utils/trace.hpp"
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <json/writer.h>
 #include <string>
+#include <vector>
+
+/**
+ * Columns of a recorded control loop run, one value per step in each
+ */
+struct Trajectory
+{
+    std::vector<double> x, y, vel, cte, etheta, costs;
+
+    /**
+     * Reserve space in all columns
+     * 
+     * @param steps: Expected number of steps
+     */
+    void reserve(size_t steps)
+    {
+        for (auto *column : columns())
+            column->reserve(steps);
+    }
+
+    /// Drop all values, keeping the allocated space
+    void clear()
+    {
+        for (auto *column : columns())
+            column->clear();
+    }
+
+    /// Number of recorded steps
+    size_t size() const
+    {
+        return x.size();
+    }
+
+    /// Columns in the order of the output formats
+    std::array<std::vector<double> *, 6> columns()
+    {
+        return {&x, &y, &vel, &cte, &etheta, &costs};
+    }
+
+    std::array<const std::vector<double> *, 6> columns() const
+    {
+        return {&x, &y, &vel, &cte, &etheta, &costs};
+    }
+};
+
+/**
+ * Solver cost of a recorded run
+ */
+struct SolverSummary
+{
+    uint64_t solves, failures;
+    /// Percentiles of the wall time of a solve, in microseconds
+    double latencyP50, latencyP90, latencyP99, latencyMax;
+    /// Percentiles of the Ipopt iterations of a solve
+    double iterationsP50, iterationsP99, iterationsMax;
+    /// Total time evaluating the NLP functions and derivatives, and in the linear solver, in seconds
+    double evalSeconds, linearSolverSeconds;
+};
 
 /**
  * Log the performance data into JSON files for visualising
+ * 
+ * Steps are recorded into a columnar Trajectory, the JSON document is only built by dump
  */
 class JsonLogger
 {
 
 public:
-    JsonLogger()
-        : x_data(Json::arrayValue),
-          y_data(Json::arrayValue),
-          vel_data(Json::arrayValue),
-          cte_data(Json::arrayValue),
-          etheta_data(Json::arrayValue),
-          costs_data(Json::arrayValue)
+    JsonLogger() : m_weights{}, m_hasWeights(false), m_solver{}, m_hasSolver(false), m_recording(true)
     {
     }
 
     void logWeights(double w_vel, double w_cte, double w_etheta, double w_omega, double w_acc, double w_omega_d, double w_acc_d)
     {
         // vel, cte, etheta, omega, acc, omega_d, acc_d
-        root["weights"]["vel"] = w_vel;
-        root["weights"]["cte"] = w_cte;
-        root["weights"]["etheta"] = w_etheta;
-        root["weights"]["omega"] = w_omega;
-        root["weights"]["acc"] = w_acc;
-        root["weights"]["omega_d"] = w_omega_d;
-        root["weights"]["acc_d"] = w_acc_d;
+        m_weights = {w_vel, w_cte, w_etheta, w_omega, w_acc, w_omega_d, w_acc_d};
+        m_hasWeights = true;
     }
 
-    void logX(double x)
+    void logSolver(const SolverSummary &solver)
     {
-        x_data.append(Json::Value(x));
+        m_solver = solver;
+        m_hasSolver = true;
     }
 
-    void logY(double y)
+    /**
+     * Record one step of the control loop, ignored while recording is off
+     */
+    void logStep(double x, double y, double vel, double cte, double etheta, double cost)
     {
-        y_data.append(Json::Value(y));
+        if (!m_recording)
+            return;
+
+        m_trajectory.x.push_back(x);
+        m_trajectory.y.push_back(y);
+        m_trajectory.vel.push_back(vel);
+        m_trajectory.cte.push_back(cte);
+        m_trajectory.etheta.push_back(etheta);
+        m_trajectory.costs.push_back(cost);
     }
 
-    void logVelError(double vel)
+    /**
+     * Switch recording of steps on or off
+     * 
+     * @param recording: False to skip recording, e.g. for evaluations that are never saved
+     */
+    void setRecording(bool recording)
     {
-        vel_data.append(Json::Value(vel));
+        m_recording = recording;
     }
 
-    void logCte(double cte)
+    bool isRecording() const
     {
-        cte_data.append(Json::Value(cte));
+        return m_recording;
     }
 
-    void logEtheta(double etheta)
+    /**
+     * Reserve space for a run
+     * 
+     * @param steps: Expected number of steps
+     */
+    void reserve(size_t steps)
     {
-        etheta_data.append(Json::Value(etheta));
+        if (m_recording)
+            m_trajectory.reserve(steps);
     }
 
-    void logCost(double cost)
+    /**
+     * Forget recorded steps, weights and solver summary, keeping the allocated space and the recording switch
+     */
+    void clear()
+    {
+        m_trajectory.clear();
+        m_hasWeights = false;
+        m_hasSolver = false;
+    }
+
+    const Trajectory &getTrajectory() const
+    {
+        return m_trajectory;
+    }
+
+    /**
+     * Weights logged with logWeights, in the order vel, cte, etheta, omega, acc, omega_d, acc_d
+     */
+    const std::array<double, 7> &getWeights() const
     {
-        costs_data.append(Json::Value(cost));
+        return m_weights;
     }
 
     /**
@@ -72,14 +165,48 @@ public:
      * 
      * @return True on success, false otherwise
      */
-    bool dump(std::string filepath)
+    bool dump(std::string filepath) const
     {
-        root["x"] = x_data;
-        root["y"] = y_data;
-        root["vel"] = vel_data;
-        root["cte"] = cte_data;
-        root["etheta"] = etheta_data;
-        root["costs"] = costs_data;
+        TRACE_SCOPE("JsonLogger::dump");
+
+        Json::Value root;
+
+        if (m_hasWeights)
+        {
+            root["weights"]["vel"] = m_weights[0];
+            root["weights"]["cte"] = m_weights[1];
+            root["weights"]["etheta"] = m_weights[2];
+            root["weights"]["omega"] = m_weights[3];
+            root["weights"]["acc"] = m_weights[4];
+            root["weights"]["omega_d"] = m_weights[5];
+            root["weights"]["acc_d"] = m_weights[6];
+        }
+
+        if (m_hasSolver)
+        {
+            root["solver"]["solves"] = static_cast<Json::UInt64>(m_solver.solves);
+            root["solver"]["failures"] = static_cast<Json::UInt64>(m_solver.failures);
+            root["solver"]["latency_us"]["p50"] = m_solver.latencyP50;
+            root["solver"]["latency_us"]["p90"] = m_solver.latencyP90;
+            root["solver"]["latency_us"]["p99"] = m_solver.latencyP99;
+            root["solver"]["latency_us"]["max"] = m_solver.latencyMax;
+            root["solver"]["iterations"]["p50"] = m_solver.iterationsP50;
+            root["solver"]["iterations"]["p99"] = m_solver.iterationsP99;
+            root["solver"]["iterations"]["max"] = m_solver.iterationsMax;
+            root["solver"]["eval_seconds"] = m_solver.evalSeconds;
+            root["solver"]["linear_solver_seconds"] = m_solver.linearSolverSeconds;
+        }
+
+        const char *names[] = {"x", "y", "vel", "cte", "etheta", "costs"};
+        const auto columns = m_trajectory.columns();
+
+        for (size_t c = 0; c < columns.size(); c++)
+        {
+            Json::Value &data = root[names[c]] = Json::Value(Json::arrayValue);
+
+            for (const double value : *columns[c])
+                data.append(Json::Value(value));
+        }
 
         try
         {
@@ -100,13 +227,16 @@ public:
     }
 
 private:
-    Json::Value root;
-    Json::Value x_data;
-    Json::Value y_data;
-    Json::Value vel_data;
-    Json::Value cte_data;
-    Json::Value etheta_data;
-    Json::Value costs_data;
+    Trajectory m_trajectory;
+
+    std::array<double, 7> m_weights;
+    bool m_hasWeights;
+
+    SolverSummary m_solver;
+    bool m_hasSolver;
+
+    /// Steps are only recorded while set
+    bool m_recording;
 };
 
 #endif
@@ -2,6 +2,8 @@
 #define PROGRESS_BAR_H_
 
 #include "primary.h"
+#include "utils/async_output.hpp"
+#include <string>
 
 class ProgressBar
 {
@@ -13,27 +15,36 @@ public:
     {
     }
 
-    void show(double progress)
+    /**
+     * Hands the bar to the output thread, the caller does not wait for the terminal
+     * 
+     * @param progress: Percentage done
+     * @param label: Printed in front of the bar
+     */
+    void show(double progress, const std::string &label = "")
     {
         size_t pos = m_barWidth * progress / 100;
 
-        CONSOLE_LOG("[");
+        std::string bar = label + "[";
         for (size_t i = 0; i < m_barWidth; ++i)
         {
             if (i < pos)
-                CONSOLE_LOG("=");
+                bar += "=";
             else if (i == pos)
-                CONSOLE_LOG(">");
+                bar += ">";
             else
-                CONSOLE_LOG(" ");
+                bar += " ";
         }
-        CONSOLE_LOG("] " << int(progress) << " %\r");
-        std::cout.flush();
+        bar += "] " + std::to_string(int(progress)) + " %\r";
+
+        AsyncOutput::get().print(std::move(bar));
     }
 
+    /// Waits until the bar is printed, so that following console output is not mixed into it
     void done(void)
     {
-        CONSOLE_LOG(std::endl);
+        AsyncOutput::get().print("\n");
+        AsyncOutput::get().flush();
     }
 };
 
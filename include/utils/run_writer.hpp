@@ -0,0 +1,231 @@
+#ifndef RUN_WRITER_H_
+#define RUN_WRITER_H_
+
+#include "primary.h"
+#include "utils/json_logger.hpp"
+#include "utils/trace.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+/**
+ * Streaming writer of the binary run output
+ * 
+ * One file per run. The file header names the columns, then every saved trajectory is appended as a
+ * chunk: a fixed size chunk header with the generation, the number of steps, the weights and the
+ * solver cost, followed by the columns one after the other as little-endian float64. All offsets
+ * stay 8 byte aligned, so the columns can be used in place from a memory map, see
+ * scripts/python/run_output.py. A chunk cut short by a crash is ignored by readers and dropped when
+ * the file is opened again to append.
+ */
+class RunWriter
+{
+public:
+    static const size_t MAX_COLUMNS = 8;
+
+    /// Header at the start of the file
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t columns;
+        /// Names of the columns, zero padded
+        char names[MAX_COLUMNS][8];
+    };
+
+    /// Header of each chunk, followed by columns * steps values
+    struct ChunkHeader
+    {
+        uint32_t magic;
+        uint32_t columns;
+        uint64_t generation;
+        uint64_t steps;
+        /// vel, cte, etheta, omega, acc, omega_d, acc_d
+        double weights[7];
+        SolverSummary solver;
+    };
+
+    static_assert(sizeof(FileHeader) == 80 && sizeof(ChunkHeader) == 168, "Run output layout changed, readers would misread it");
+
+    RunWriter() = default;
+
+    /// Delete copy constructor
+    RunWriter(const RunWriter &) = delete;
+
+    /**
+     * Open the output file
+     * 
+     * In append mode a chunk cut short at the end of the file, e.g. by a run killed while writing it,
+     * is truncated so that the following chunks stay readable
+     * 
+     * @param filepath: Path of the run output
+     * @param append: Continue an existing file, e.g. when resuming, instead of starting a new one
+     * 
+     * @return True on success, false otherwise
+     */
+    bool open(const std::string &filepath, bool append)
+    {
+        m_lastGeneration = 0;
+
+        if (append && !_resume(filepath))
+            return false;
+
+        m_file.open(filepath, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+
+        if (!m_file.is_open())
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not open run output " << filepath << std::endl);
+            return false;
+        }
+
+        if (m_file.tellp() > 0)
+            return true;
+
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+        header.version = VERSION;
+        header.columns = N_COLUMNS;
+
+        for (size_t c = 0; c < N_COLUMNS; c++)
+            std::strncpy(header.names[c], COLUMN_NAMES[c], sizeof(header.names[c]));
+
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        m_file.flush();
+
+        return m_file.good();
+    }
+
+    bool isOpen() const
+    {
+        return m_file.is_open();
+    }
+
+    /**
+     * Get the last generation in the file
+     * 
+     * @return Generation of the last complete chunk, 0 if there is none
+     */
+    size_t lastGeneration() const
+    {
+        return m_lastGeneration;
+    }
+
+    /**
+     * Append the trajectory of one generation
+     * 
+     * A generation not past the last one in the file is skipped. A resumed run saves the generation of
+     * its checkpoint again, the chunk is only written if the killed run did not get to it.
+     * 
+     * @param generation: Generation number
+     * @param weights: MPC weights, in the order of ChunkHeader::weights
+     * @param trajectory: Recorded run
+     * @param solver: Solver cost of the run
+     * 
+     * @return True on success, false otherwise
+     */
+    bool append(size_t generation, const std::array<double, 7> &weights, const Trajectory &trajectory, const SolverSummary &solver)
+    {
+        TRACE_SCOPE("RunWriter::append");
+
+        if (!isOpen())
+            return false;
+
+        if (generation <= m_lastGeneration)
+            return true;
+
+        ChunkHeader chunk;
+        std::memset(&chunk, 0, sizeof(chunk));
+        chunk.magic = CHUNK_MAGIC;
+        chunk.columns = N_COLUMNS;
+        chunk.generation = generation;
+        chunk.steps = trajectory.size();
+        std::copy(weights.begin(), weights.end(), chunk.weights);
+        chunk.solver = solver;
+
+        m_file.write(reinterpret_cast<const char *>(&chunk), sizeof(chunk));
+
+        for (const auto *column : trajectory.columns())
+            m_file.write(reinterpret_cast<const char *>(column->data()), column->size() * sizeof(double));
+
+        // Each chunk is complete on disk before the next generation starts
+        m_file.flush();
+
+        m_lastGeneration = generation;
+
+        return m_file.good();
+    }
+
+private:
+    static constexpr const char *FILE_MAGIC = "GNRUN\0\0";
+    static const uint32_t VERSION = 1;
+    static const uint32_t CHUNK_MAGIC = 0x4B434E47; // "GNCK"
+
+    static const size_t N_COLUMNS = 6;
+    static constexpr const char *COLUMN_NAMES[N_COLUMNS] = {"x", "y", "vel", "cte", "etheta", "costs"};
+
+    /**
+     * Check the header of an existing file and cut it after its last complete chunk
+     * 
+     * @param filepath: Path of the run output, may not exist yet
+     * 
+     * @return False if the file is not a run output of this version
+     */
+    bool _resume(const std::string &filepath)
+    {
+        std::ifstream in(filepath, std::ios::binary | std::ios::ate);
+
+        if (!in || in.tellg() <= 0)
+            return true;
+
+        const uint64_t size = static_cast<uint64_t>(in.tellg());
+        in.seekg(0);
+
+        // Chunks of another version would be misread, a resumed run continues only its own format
+        FileHeader existing;
+
+        if (!in.read(reinterpret_cast<char *>(&existing), sizeof(existing)) ||
+            std::memcmp(existing.magic, FILE_MAGIC, sizeof(existing.magic)) != 0 || existing.version != VERSION)
+        {
+            CONSOLE_LOG("[ ERROR ]: " << filepath << " is not a run output of version " << VERSION << std::endl);
+            return false;
+        }
+
+        uint64_t end = sizeof(FileHeader);
+        ChunkHeader chunk;
+
+        while (in.seekg(end) && in.read(reinterpret_cast<char *>(&chunk), sizeof(chunk)))
+        {
+            if (chunk.magic != CHUNK_MAGIC || chunk.columns != N_COLUMNS)
+                break;
+
+            const uint64_t chunkEnd = end + sizeof(ChunkHeader) + chunk.columns * chunk.steps * sizeof(double);
+
+            if (chunkEnd > size)
+                break;
+
+            end = chunkEnd;
+            m_lastGeneration = chunk.generation;
+        }
+
+        in.close();
+
+        if (end < size && ::truncate(filepath.c_str(), end) != 0)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not drop the partial chunk at the end of " << filepath << std::endl);
+            return false;
+        }
+
+        return true;
+    }
+
+    std::ofstream m_file;
+
+    /// Generation of the last complete chunk
+    size_t m_lastGeneration = 0;
+};
+
+#endif
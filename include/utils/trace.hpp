@@ -0,0 +1,200 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "primary.h"
+
+/**
+ * Scoped trace spans, written as Chrome trace-event JSON for chrome://tracing or Perfetto
+ *
+ * TRACE_SCOPE("name") records the time until the end of the enclosing scope, TRACE_DUMP("file")
+ * writes every span recorded so far. Both compile to nothing unless GNT_TRACING is defined, see the
+ * ENABLE_TRACING CMake option. The name must be a string literal, only the pointer is stored.
+ *
+ * Every thread appends to its own buffer, a span costs two clock reads and a push_back. Buffers
+ * outlive their threads, so spans of the mpc::SolverPool workers are kept after the pool is gone.
+ */
+#ifdef GNT_TRACING
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace
+{
+    struct Event
+    {
+        const char *name;
+        /// Nanoseconds since the start of the process
+        int64_t start;
+        int64_t duration;
+    };
+
+    /// Spans of one thread, in fixed size chunks so that recording never copies earlier spans
+    class Buffer
+    {
+    public:
+        static const size_t CHUNK_EVENTS = 4096;
+
+        explicit Buffer(size_t tid) : m_tid(tid), m_used(CHUNK_EVENTS)
+        {
+        }
+
+        size_t tid() const
+        {
+            return m_tid;
+        }
+
+        void push(const Event &event)
+        {
+            if (m_used == CHUNK_EVENTS)
+            {
+                m_chunks.emplace_back(new Event[CHUNK_EVENTS]);
+                m_used = 0;
+            }
+
+            m_chunks.back()[m_used++] = event;
+        }
+
+        template <typename Func>
+        void forEach(Func func) const
+        {
+            for (size_t c = 0; c < m_chunks.size(); c++)
+            {
+                const size_t n = (c + 1 == m_chunks.size()) ? m_used : CHUNK_EVENTS;
+
+                for (size_t i = 0; i < n; i++)
+                    func(m_chunks[c][i]);
+            }
+        }
+
+    private:
+        const size_t m_tid;
+        std::vector<std::unique_ptr<Event[]>> m_chunks;
+        size_t m_used;
+    };
+
+    class Registry
+    {
+    public:
+        static Registry &get()
+        {
+            static Registry instance;
+            return instance;
+        }
+
+        /// Buffer of the calling thread, registered on first use
+        Buffer &local()
+        {
+            thread_local std::shared_ptr<Buffer> buffer = _register();
+            return *buffer;
+        }
+
+        int64_t now() const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+        }
+
+        /**
+         * Write the spans of every thread, no span may be recorded meanwhile
+         *
+         * @param filepath: Path of the trace file
+         *
+         * @return True on success, false otherwise
+         */
+        bool dump(const std::string &filepath)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            std::ofstream file(filepath);
+
+            if (!file.is_open())
+            {
+                CONSOLE_LOG("[ ERROR ]: Could not write trace " << filepath << std::endl);
+                return false;
+            }
+
+            // Timestamps are in microseconds
+            file << std::fixed << std::setprecision(3);
+            file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+            bool first = true;
+            for (const auto &buffer : m_buffers)
+            {
+                const size_t tid = buffer->tid();
+
+                file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                     << ",\"args\":{\"name\":\"thread " << tid << "\"}}";
+                first = false;
+
+                buffer->forEach([&file, tid](const Event &event) {
+                    file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                         << ",\"ts\":" << event.start * 1e-3 << ",\"dur\":" << event.duration * 1e-3 << "}";
+                });
+            }
+
+            file << "\n]}\n";
+
+            return file.good();
+        }
+
+    private:
+        Registry() : m_epoch(std::chrono::steady_clock::now())
+        {
+        }
+
+        std::shared_ptr<Buffer> _register()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto buffer = std::make_shared<Buffer>(m_buffers.size());
+            m_buffers.push_back(buffer);
+
+            return buffer;
+        }
+
+        const std::chrono::steady_clock::time_point m_epoch;
+
+        std::mutex m_mutex;
+        std::vector<std::shared_ptr<Buffer>> m_buffers;
+    };
+
+    /// Records a span from construction to destruction
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name) : m_registry(Registry::get()), m_name(name), m_start(m_registry.now())
+        {
+        }
+
+        ~Scope()
+        {
+            m_registry.local().push({m_name, m_start, m_registry.now() - m_start});
+        }
+
+        Scope(const Scope &) = delete;
+
+    private:
+        Registry &m_registry;
+        const char *m_name;
+        const int64_t m_start;
+    };
+} // namespace trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(_traceScope, __LINE__)(name)
+#define TRACE_DUMP(filepath) trace::Registry::get().dump(filepath)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_DUMP(filepath)
+
+#endif // GNT_TRACING
+
+#endif
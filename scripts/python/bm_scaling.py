@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+
+# -*- coding: utf-8 -*-
+
+""" bm_scaling.py: Scaling of the MPC solve in the horizon N, from bm_pipeline results.
+
+bm_pipeline writes google-benchmark JSON to data/bm_pipeline.json. Keep the files of
+earlier commits around and pass them all, each becomes one column per regime.
+
+Usage:
+    bm_scaling.py data/bm_pipeline.json                  table of time and iterations per N
+    bm_scaling.py old.json new.json --plot scaling.png   time per N of every file and regime
+"""
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+import argparse
+import json
+import os
+import re
+from typing import Dict, List, Tuple
+
+REGIMES = ("tuned", "tracking", "smooth")
+
+# BM_Solve/N:20/regime:1 or BM_Solve/N:20/regime:1/real_time
+SOLVE_NAME = re.compile(r"^BM_Solve/N:(\d+)/regime:(\d+)")
+
+
+def read(path: str) -> Dict[str, List[Tuple[int, float, float]]]:
+    """ (N, milliseconds, Ipopt iterations) per regime, sorted by N """
+    with open(path) as f:
+        results = json.load(f)
+
+    curves = {regime: [] for regime in REGIMES}
+
+    for bm in results["benchmarks"]:
+        match = SOLVE_NAME.match(bm["name"])
+
+        # Aggregates of repeated runs are reported in addition, only take the mean
+        if not match or bm.get("aggregate_name", "mean") != "mean":
+            continue
+
+        scale = {"ns": 1e-6, "us": 1e-3, "ms": 1.0, "s": 1e3}[bm["time_unit"]]
+        regime = REGIMES[int(match.group(2))]
+
+        curves[regime].append((int(match.group(1)), bm["real_time"] * scale, bm.get("ipopt_iterations", 0.0)))
+
+    for curve in curves.values():
+        curve.sort()
+
+    return curves
+
+
+def plot(files: Dict[str, Dict[str, List[Tuple[int, float, float]]]], out_path: str) -> None:
+    import matplotlib.pyplot as plt
+
+    fig, ax = plt.subplots(figsize=(8, 5))
+
+    for label, curves in files.items():
+        for regime, curve in curves.items():
+            if curve:
+                ax.plot([c[0] for c in curve], [c[1] for c in curve], marker="o", label=f"{label} {regime}")
+
+    ax.set_xlabel("Horizon N")
+    ax.set_ylabel("MPC::solve [ms]")
+    ax.set_yscale("log")
+    ax.grid(True, which="both", alpha=0.3)
+    ax.legend()
+
+    fig.tight_layout()
+    fig.savefig(out_path)
+
+    print("[ Benchmark-INFO ]: Saved: ", out_path)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Scaling of MPC::solve in the horizon N")
+    parser.add_argument("results", nargs="+", help="JSON output of bm_pipeline")
+    parser.add_argument("--plot", metavar="PNG", help="plot the time per N instead of printing it")
+    args = parser.parse_args()
+
+    files = {os.path.basename(path): read(path) for path in args.results}
+
+    if args.plot:
+        plot(files, args.plot)
+    else:
+        for label, curves in files.items():
+            print(label)
+            for regime, curve in curves.items():
+                for n, ms, iterations in curve:
+                    print(f"  {regime:8s}  N {n:3d}  {ms:10.3f} ms  {iterations:6.1f} iterations")
@@ -13,6 +13,8 @@ import matplotlib as mpl
 import json
 import os
 
+import run_output
+
 
 class Visualize:
     def __init__(self, data: dict) -> None:
@@ -129,18 +131,32 @@ if __name__ == "__main__":
     if not os.path.exists(os.path.join(data_dir, "plots")):
         os.mkdir(os.path.join(data_dir, "plots"))
 
+    def plot(data: dict, save_file_name: str) -> None:
+        save_path = os.path.join(data_dir, "plots", save_file_name)
+
+        if os.path.exists(save_path):
+            return
+
+        vis = Visualize(data)
+        vis.visualize()
+        vis.save(save_path)
+        print("[ Plot-INFO ]: Saved: ", save_file_name)
+        plt.clf()
+
     for file in os.listdir(data_dir):
         file_path = os.path.join(data_dir, file)
-        if os.path.isfile(file_path):
+        if not os.path.isfile(file_path):
+            continue
+
+        if file.endswith(".json"):
             data = json.loads(open(file_path).read())
-            save_file_name = file.split(".")[0] + ".png"
-            save_path = os.path.join(data_dir, "plots", save_file_name)
 
-            if os.path.exists(save_path):
+            # Only trajectory logs can be plotted, skip other run outputs
+            if not isinstance(data, dict) or "x" not in data:
                 continue
 
-            vis = Visualize(data)
-            vis.visualize()
-            vis.save(save_path)
-            print("[ Plot-INFO ]: Saved: ", save_file_name)
-            plt.clf()
+            plot(data, file.split(".")[0] + ".png")
+
+        elif run_output.is_run_output(file_path):
+            for gen in run_output.read(file_path):
+                plot(dict(gen.columns, weights=gen.weights), f"best-of-generation-{gen.generation}.png")
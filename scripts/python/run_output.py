@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+
+# -*- coding: utf-8 -*-
+
+""" run_output.py: Reads the binary run output written by hone_weights.
+
+The file is memory mapped and every column is returned as a view into the
+map, nothing is copied until it is used. Layout, see include/utils/run_writer.hpp:
+
+    file header  80 bytes  magic "GNRUN", version, column count, column names
+    chunk header 168 bytes magic "GNCK", column count, generation, steps, 7 weights, solver summary
+    columns      columns * steps little-endian float64, column after column
+    ...          one chunk per generation
+
+Usage:
+    run_output.py data/run.gnr                  summary of the saved generations
+    run_output.py data/run.gnr --to-json data   best-of-generation-N.json files for plot.py
+"""
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+import argparse
+import json
+import os
+from typing import Dict, Iterator, NamedTuple
+
+import numpy as np
+
+FILE_MAGIC = b"GNRUN\x00\x00\x00"
+CHUNK_MAGIC = 0x4B434E47
+
+FILE_VERSION = 1
+
+FILE_HEADER = np.dtype([("magic", "S8"), ("version", "<u4"), ("columns", "<u4"), ("names", "S8", (8,))])
+
+SOLVER_FIELDS = [("solves", "<u8"), ("failures", "<u8"),
+                 ("latency_p50", "<f8"), ("latency_p90", "<f8"), ("latency_p99", "<f8"), ("latency_max", "<f8"),
+                 ("iterations_p50", "<f8"), ("iterations_p99", "<f8"), ("iterations_max", "<f8"),
+                 ("eval_seconds", "<f8"), ("linear_solver_seconds", "<f8")]
+
+CHUNK_HEADER = np.dtype([("magic", "<u4"), ("columns", "<u4"), ("generation", "<u8"), ("steps", "<u8"),
+                         ("weights", "<f8", (7,))] + SOLVER_FIELDS)
+
+WEIGHT_NAMES = ("vel", "cte", "etheta", "omega", "acc", "omega_d", "acc_d")
+
+
+class Generation(NamedTuple):
+    generation: int
+    weights: Dict[str, float]
+    columns: Dict[str, np.ndarray]
+    solver: Dict[str, float]
+
+
+def _solver_dict(chunk) -> dict:
+    """ Solver summary in the layout of the JSON output """
+    return {
+        "solves": int(chunk["solves"]),
+        "failures": int(chunk["failures"]),
+        "latency_us": {p: float(chunk["latency_" + p]) for p in ("p50", "p90", "p99", "max")},
+        "iterations": {p: float(chunk["iterations_" + p]) for p in ("p50", "p99", "max")},
+        "eval_seconds": float(chunk["eval_seconds"]),
+        "linear_solver_seconds": float(chunk["linear_solver_seconds"]),
+    }
+
+
+def is_run_output(path: str) -> bool:
+    with open(path, "rb") as f:
+        return f.read(len(FILE_MAGIC)) == FILE_MAGIC
+
+
+def read(path: str) -> Iterator[Generation]:
+    """ Yields the saved generations in file order, a chunk cut short at the end is skipped """
+    data = np.memmap(path, dtype=np.uint8, mode="r")
+
+    if data.size < FILE_HEADER.itemsize:
+        raise ValueError(f"{path}: too short for a run output")
+
+    header = data[:FILE_HEADER.itemsize].view(FILE_HEADER)[0]
+    if header["magic"] != FILE_MAGIC.rstrip(b"\x00") or int(header["version"]) != FILE_VERSION:
+        raise ValueError(f"{path}: not a run output of version {FILE_VERSION}")
+
+    names = [name.decode() for name in header["names"][:header["columns"]]]
+
+    offset = FILE_HEADER.itemsize
+    while offset + CHUNK_HEADER.itemsize <= data.size:
+        chunk = data[offset:offset + CHUNK_HEADER.itemsize].view(CHUNK_HEADER)[0]
+        if chunk["magic"] != CHUNK_MAGIC or chunk["columns"] != len(names):
+            break
+
+        begin = offset + CHUNK_HEADER.itemsize
+        end = begin + 8 * len(names) * int(chunk["steps"])
+        if end > data.size:
+            break
+
+        columns = data[begin:end].view("<f8").reshape(len(names), int(chunk["steps"]))
+
+        yield Generation(int(chunk["generation"]),
+                         dict(zip(WEIGHT_NAMES, map(float, chunk["weights"]))),
+                         dict(zip(names, columns)),
+                         _solver_dict(chunk))
+        offset = end
+
+
+def to_json(path: str, out_dir: str) -> None:
+    """ Writes every generation in the layout of data/best-of-generation-N.json """
+    for gen in read(path):
+        data = {name: column.tolist() for name, column in gen.columns.items()}
+        data["weights"] = gen.weights
+        data["solver"] = gen.solver
+
+        out_path = os.path.join(out_dir, f"best-of-generation-{gen.generation}.json")
+        with open(out_path, "w") as f:
+            json.dump(data, f, indent=3)
+
+        print("[ Run-INFO ]: Saved: ", out_path)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Read the binary run output of hone_weights")
+    parser.add_argument("run_file")
+    parser.add_argument("--to-json", metavar="DIR", help="write best-of-generation-N.json files to DIR")
+    args = parser.parse_args()
+
+    if args.to_json:
+        to_json(args.run_file, args.to_json)
+    else:
+        for gen in read(args.run_file):
+            costs = gen.columns["costs"]
+            print(f"generation {gen.generation:4d}  steps {costs.size:5d}  "
+                  f"total cost {costs.sum():12.4f}  weights {gen.weights}")
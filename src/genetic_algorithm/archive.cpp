@@ -0,0 +1,347 @@
+#include "genetic_algorithm/archive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t RECORD_MAGIC = 0x52544E47; // "GNTR"
+
+static_assert(sizeof(ga::EvalArchive::Record) == 120, "Archive record layout changed, existing archives would be misread");
+
+/**
+ * 64 bit FNV-1a over a block of bytes
+ */
+static uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL)
+{
+    const auto *bytes = static_cast<const unsigned char *>(data);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+namespace ga
+{
+    EvalArchive::EvalArchive(const std::string &filepath, uint64_t configHash)
+        : m_configHash(configHash),
+          m_fd(-1),
+          m_mapping(nullptr),
+          m_mappingSize(0),
+          m_lookups(0),
+          m_hits(0)
+    {
+        m_fd = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+
+        if (m_fd < 0)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not open evaluation archive " << filepath << std::endl);
+            return;
+        }
+
+        if (!_load())
+        {
+            CONSOLE_LOG("[ ERROR ]: " << filepath << " is not an evaluation archive, choose another file" << std::endl);
+
+            ::close(m_fd);
+            m_fd = -1;
+            return;
+        }
+
+        CONSOLE_LOG("? Evaluation archive           : " << filepath << ", " << m_index.size() << " usable records" << std::endl);
+    }
+
+    EvalArchive::~EvalArchive()
+    {
+        if (m_mapping != nullptr)
+            ::munmap(m_mapping, m_mappingSize);
+
+        if (m_fd >= 0)
+            ::close(m_fd);
+    }
+
+    bool EvalArchive::isOpen() const
+    {
+        return m_fd >= 0;
+    }
+
+    bool EvalArchive::_load()
+    {
+        ::flock(m_fd, LOCK_EX);
+
+        struct stat st;
+        ::fstat(m_fd, &st);
+
+        // Truncating to the record size below would damage a file of another layout, leave it alone
+        uint32_t magic = RECORD_MAGIC;
+        if (st.st_size > 0 && ::pread(m_fd, &magic, sizeof(magic), 0) == sizeof(magic) && magic != RECORD_MAGIC)
+        {
+            ::flock(m_fd, LOCK_UN);
+            return false;
+        }
+
+        // A crash in the middle of an append leaves a partial record behind, drop it so that
+        // following appends stay aligned
+        const size_t fileSize = static_cast<size_t>(st.st_size);
+        const size_t usableSize = fileSize - fileSize % sizeof(Record);
+
+        if (usableSize != fileSize)
+            if (::ftruncate(m_fd, usableSize) != 0)
+                DEBUG_LOG("Could not truncate partial archive record");
+
+        if (usableSize > 0)
+        {
+            void *mapping = ::mmap(nullptr, usableSize, PROT_READ, MAP_SHARED, m_fd, 0);
+
+            if (mapping != MAP_FAILED)
+            {
+                m_mapping = mapping;
+                m_mappingSize = usableSize;
+            }
+        }
+
+        ::flock(m_fd, LOCK_UN);
+
+        if (m_mapping == nullptr)
+            return true;
+
+        ::madvise(m_mapping, m_mappingSize, MADV_SEQUENTIAL);
+
+        const auto *records = static_cast<const Record *>(m_mapping);
+        const size_t count = m_mappingSize / sizeof(Record);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const Record &record = records[i];
+
+            if (record.magic != RECORD_MAGIC || record.checksum != _checksum(record) || record.configHash != m_configHash)
+                continue;
+
+            Key key;
+            std::copy(std::begin(record.genes), std::end(record.genes), key.begin());
+
+            m_index[key] = &record;
+        }
+
+        return true;
+    }
+
+    bool EvalArchive::lookup(const ga::core::Genome &genome, ga::fitness::metrics_t &metrics) const
+    {
+        const Key key = _key(genome);
+
+        m_lookups++;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto it = m_index.find(key);
+
+        if (it == m_index.end())
+            return false;
+
+        std::copy(std::begin(it->second->metrics), std::end(it->second->metrics), metrics.begin());
+        m_hits++;
+
+        return true;
+    }
+
+    void EvalArchive::append(const ga::core::Genome &genome, const ga::fitness::metrics_t &metrics, double fitness, double rolloutSeconds)
+    {
+        if (!isOpen())
+            return;
+
+        Record record;
+        std::memset(&record, 0, sizeof(Record));
+
+        const Key key = _key(genome);
+
+        record.magic = RECORD_MAGIC;
+        record.configHash = m_configHash;
+        std::copy(key.begin(), key.end(), record.genes);
+        std::copy(metrics.begin(), metrics.end(), record.metrics);
+        record.fitness = fitness;
+        record.rolloutSeconds = rolloutSeconds;
+        record.checksum = _checksum(record);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // One write per record with O_APPEND, the lock keeps other processes from interleaving
+        ::flock(m_fd, LOCK_EX);
+        const ssize_t written = ::write(m_fd, &record, sizeof(Record));
+        ::flock(m_fd, LOCK_UN);
+
+        if (written != static_cast<ssize_t>(sizeof(Record)))
+            DEBUG_LOG("Could not append to evaluation archive");
+
+        m_appended.push_back(record);
+        m_index[key] = &m_appended.back();
+    }
+
+    std::vector<ga::core::Genome> EvalArchive::seeds(size_t count, const ga::core::Genome &prototype) const
+    {
+        std::vector<std::pair<double, const Record *>> ranked;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            ranked.reserve(m_index.size());
+
+            for (const auto &entry : m_index)
+            {
+                ga::fitness::metrics_t metrics;
+                std::copy(std::begin(entry.second->metrics), std::end(entry.second->metrics), metrics.begin());
+
+                // Rank under the current objective, not the one the record was scored with
+                ranked.emplace_back(ga::fitness::ObjFunction::score(metrics), entry.second);
+            }
+        }
+
+        count = std::min(count, ranked.size());
+
+        std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                          [](const auto &a, const auto &b) { return a.first > b.first; });
+
+        std::vector<ga::core::Genome> result;
+        result.reserve(count);
+
+        for (size_t k = 0; k < count; k++)
+        {
+            ga::core::Genome genome = prototype;
+
+            for (size_t i = 0; i < genome.chromosomes.size() && i < N_CHROMOSOMES; i++)
+                genome.chromosomes[i].genes = std::bitset<ga::core::Chromosome::__MAX_LEN>(ranked[k].second->genes[i]);
+
+            result.push_back(genome);
+        }
+
+        return result;
+    }
+
+    size_t EvalArchive::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_index.size();
+    }
+
+    size_t EvalArchive::lookups() const
+    {
+        return m_lookups;
+    }
+
+    size_t EvalArchive::hits() const
+    {
+        return m_hits;
+    }
+
+    uint64_t EvalArchive::configHash(const config::MPC_Controller_GA &mpcConfig, size_t iterations,
+                                     ga::fitness::SolverCost solverCost)
+    {
+        const double values[] = {
+            static_cast<double>(mpcConfig.general.timesteps),
+            mpcConfig.general.sample_time,
+            mpcConfig.initial_state.x,
+            mpcConfig.initial_state.y,
+            mpcConfig.initial_state.theta,
+            mpcConfig.initial_state.linear_velocity,
+            mpcConfig.initial_state.angular_velocity,
+            mpcConfig.initial_state.throttle,
+            mpcConfig.desired.velocity,
+            mpcConfig.desired.cross_track_error,
+            mpcConfig.desired.orientation_error,
+            mpcConfig.max_bounds.omega,
+            mpcConfig.max_bounds.throttle,
+            mpcConfig.weight_bounds.w_vel.first, mpcConfig.weight_bounds.w_vel.second,
+            mpcConfig.weight_bounds.w_cte.first, mpcConfig.weight_bounds.w_cte.second,
+            mpcConfig.weight_bounds.w_etheta.first, mpcConfig.weight_bounds.w_etheta.second,
+            mpcConfig.weight_bounds.w_omega.first, mpcConfig.weight_bounds.w_omega.second,
+            mpcConfig.weight_bounds.w_acc.first, mpcConfig.weight_bounds.w_acc.second,
+            mpcConfig.weight_bounds.w_omega_d.first, mpcConfig.weight_bounds.w_omega_d.second,
+            mpcConfig.weight_bounds.w_acc_d.first, mpcConfig.weight_bounds.w_acc_d.second,
+            static_cast<double>(iterations),
+            static_cast<double>(ga::core::Chromosome::__MAX_LEN),
+            static_cast<double>(solverCost)};
+
+        uint64_t hash = fnv1a(values, sizeof(values));
+
+        // The route itself rather than its path, a route edited in place must not hit old evaluations.
+        // Folding in an empty route leaves the hash of existing archives unchanged
+        const std::string &route = mpcConfig.reference.route_file;
+
+        if (!route.empty())
+        {
+            std::ifstream file(route, std::ios::binary);
+
+            if (file)
+            {
+                std::vector<char> buffer(1 << 16);
+
+                while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+                    hash = fnv1a(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+            }
+            else
+                hash = fnv1a(route.data(), route.size(), hash);
+        }
+
+        // Likewise a disabled event trigger, skipped solves change the rollouts
+        if (mpcConfig.event_trigger.enabled)
+        {
+            const double tolerances[] = {mpcConfig.event_trigger.position, mpcConfig.event_trigger.heading, mpcConfig.event_trigger.velocity};
+            hash = fnv1a(tolerances, sizeof(tolerances), hash);
+        }
+
+        if (mpcConfig.adaptive_horizon.enabled)
+        {
+            const double horizon[] = {static_cast<double>(mpcConfig.adaptive_horizon.min_timesteps),
+                                      static_cast<double>(mpcConfig.adaptive_horizon.max_timesteps),
+                                      static_cast<double>(mpcConfig.adaptive_horizon.step),
+                                      mpcConfig.adaptive_horizon.grow_error,
+                                      mpcConfig.adaptive_horizon.shrink_error,
+                                      mpcConfig.adaptive_horizon.max_iterations,
+                                      static_cast<double>(mpcConfig.adaptive_horizon.move_blocking)};
+            hash = fnv1a(horizon, sizeof(horizon), hash);
+        }
+
+        // Warm starts agree within the Ipopt tolerance, not to the bit
+        if (mpcConfig.warm_start.enabled)
+        {
+            const double warmStart[] = {static_cast<double>(mpcConfig.warm_start.capacity), mpcConfig.warm_start.radius};
+            hash = fnv1a(warmStart, sizeof(warmStart), hash);
+        }
+
+        return hash;
+    }
+
+    size_t EvalArchive::KeyHash::operator()(const Key &key) const
+    {
+        return static_cast<size_t>(fnv1a(key.data(), sizeof(uint32_t) * key.size()));
+    }
+
+    EvalArchive::Key EvalArchive::_key(const ga::core::Genome &genome)
+    {
+        Key key;
+        key.fill(0);
+
+        for (size_t i = 0; i < genome.chromosomes.size() && i < N_CHROMOSOMES; i++)
+            key[i] = static_cast<uint32_t>(genome.chromosomes[i].genes.to_ulong());
+
+        return key;
+    }
+
+    uint32_t EvalArchive::_checksum(const Record &record)
+    {
+        const auto *begin = reinterpret_cast<const unsigned char *>(&record.configHash);
+        const auto *end = reinterpret_cast<const unsigned char *>(&record) + sizeof(Record);
+
+        const uint64_t hash = fnv1a(begin, end - begin);
+
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+} // namespace ga
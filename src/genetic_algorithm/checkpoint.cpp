@@ -0,0 +1,345 @@
+#include "genetic_algorithm/checkpoint.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t CHECKPOINT_MAGIC = 0x43544E47; // "GNTC"
+static const uint32_t CHECKPOINT_VERSION = 3;
+
+/**
+ * 64 bit FNV-1a over a block of bytes
+ */
+static uint64_t fnv1a(const char *data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+namespace
+{
+    /**
+     * Append plain values to a byte buffer
+     */
+    class Encoder
+    {
+    public:
+        template <typename T>
+        void put(const T &value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be encoded");
+            bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        void putString(const std::string &value)
+        {
+            put<uint64_t>(value.size());
+            bytes.append(value);
+        }
+
+        void putEvaluation(const ga::Evaluation &evaluation)
+        {
+            put<uint64_t>(evaluation.genome.chromosomes.size());
+            for (const auto &chrom : evaluation.genome.chromosomes)
+                put<uint32_t>(static_cast<uint32_t>(chrom.genes.to_ulong()));
+
+            put(evaluation.metrics);
+            put(evaluation.fitness);
+            put<uint64_t>(evaluation.generation);
+        }
+
+        std::string bytes;
+    };
+
+    /**
+     * Read plain values from a byte buffer, failing softly on truncation
+     */
+    class Decoder
+    {
+    public:
+        explicit Decoder(const std::string &data) : m_data(data), m_pos(0), ok(true)
+        {
+        }
+
+        template <typename T>
+        T get()
+        {
+            T value{};
+
+            if (m_pos + sizeof(T) > m_data.size())
+            {
+                ok = false;
+                return value;
+            }
+
+            std::memcpy(&value, m_data.data() + m_pos, sizeof(T));
+            m_pos += sizeof(T);
+
+            return value;
+        }
+
+        std::string getString()
+        {
+            const uint64_t size = get<uint64_t>();
+
+            if (!ok || m_pos + size > m_data.size())
+            {
+                ok = false;
+                return std::string();
+            }
+
+            std::string value = m_data.substr(m_pos, size);
+            m_pos += size;
+
+            return value;
+        }
+
+        ga::Evaluation getEvaluation(const ga::core::Genome &prototype)
+        {
+            ga::Evaluation evaluation{prototype, {}, 0.0, 0};
+
+            const uint64_t nChromosomes = get<uint64_t>();
+
+            if (nChromosomes != prototype.chromosomes.size())
+                ok = false;
+
+            for (size_t i = 0; ok && i < nChromosomes; i++)
+                evaluation.genome.chromosomes[i].genes = std::bitset<ga::core::Chromosome::__MAX_LEN>(get<uint32_t>());
+
+            evaluation.metrics = get<ga::fitness::metrics_t>();
+            evaluation.fitness = get<double>();
+            evaluation.generation = get<uint64_t>();
+
+            return evaluation;
+        }
+
+    private:
+        const std::string &m_data;
+        size_t m_pos;
+
+    public:
+        bool ok;
+    };
+} // namespace
+
+namespace ga::checkpoint
+{
+    std::string serialize(const Checkpoint &cp)
+    {
+        Encoder enc;
+
+        enc.put(CHECKPOINT_MAGIC);
+        enc.put(CHECKPOINT_VERSION);
+        enc.put(cp.generation);
+        enc.put(cp.configHash);
+
+        enc.put(cp.objective.weights);
+        enc.put(cp.objective.prevMetrics);
+        enc.put<uint8_t>(cp.objective.started);
+        enc.put<uint8_t>(cp.objective.terminated);
+
+        enc.putString(cp.rngState);
+
+        enc.put<uint64_t>(cp.organisms.size());
+        for (const auto &evaluation : cp.organisms)
+            enc.putEvaluation(evaluation);
+
+        enc.put(cp.historySize);
+
+        enc.put(fnv1a(enc.bytes.data(), enc.bytes.size()));
+
+        return enc.bytes;
+    }
+
+    bool deserialize(const std::string &bytes, const ga::core::Genome &prototype, Checkpoint &cp)
+    {
+        if (bytes.size() < sizeof(uint64_t))
+            return false;
+
+        const size_t contentSize = bytes.size() - sizeof(uint64_t);
+
+        uint64_t checksum;
+        std::memcpy(&checksum, bytes.data() + contentSize, sizeof(uint64_t));
+
+        if (checksum != fnv1a(bytes.data(), contentSize))
+            return false;
+
+        Decoder dec(bytes);
+
+        if (dec.get<uint32_t>() != CHECKPOINT_MAGIC || dec.get<uint32_t>() != CHECKPOINT_VERSION)
+            return false;
+
+        cp.generation = dec.get<uint64_t>();
+        cp.configHash = dec.get<uint64_t>();
+
+        cp.objective.weights = dec.get<ga::fitness::metrics_t>();
+        cp.objective.prevMetrics = dec.get<ga::fitness::metrics_t>();
+        cp.objective.started = dec.get<uint8_t>();
+        cp.objective.terminated = dec.get<uint8_t>();
+
+        cp.rngState = dec.getString();
+
+        const uint64_t nOrganisms = dec.get<uint64_t>();
+        cp.organisms.clear();
+        for (size_t i = 0; dec.ok && i < nOrganisms; i++)
+            cp.organisms.push_back(dec.getEvaluation(prototype));
+
+        cp.historySize = dec.get<uint64_t>();
+        cp.history.clear();
+
+        return dec.ok;
+    }
+
+    bool load(const std::string &filepath, const ga::core::Genome &prototype, Checkpoint &cp)
+    {
+        std::ifstream inFile(filepath, std::ios::binary);
+
+        if (!inFile)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not open checkpoint " << filepath << std::endl);
+            return false;
+        }
+
+        const std::string bytes((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+
+        if (!deserialize(bytes, prototype, cp))
+        {
+            CONSOLE_LOG("[ ERROR ]: Checkpoint " << filepath << " is corrupt" << std::endl);
+            return false;
+        }
+
+        // Evaluations past historySize were appended by a write that did not complete
+        std::ifstream historyFile(historyPath(filepath), std::ios::binary);
+        const std::string history((std::istreambuf_iterator<char>(historyFile)), std::istreambuf_iterator<char>());
+
+        Decoder dec(history);
+        for (size_t i = 0; dec.ok && i < cp.historySize; i++)
+            cp.history.push_back(dec.getEvaluation(prototype));
+
+        if (!dec.ok)
+        {
+            CONSOLE_LOG("[ ERROR ]: Evaluation history " << historyPath(filepath) << " is missing or corrupt" << std::endl);
+            return false;
+        }
+
+        return true;
+    }
+
+    std::string historyPath(const std::string &filepath)
+    {
+        return filepath + ".history";
+    }
+
+    /**
+     * Write all of a buffer to a file descriptor
+     */
+    static bool writeAll(int fd, const std::string &bytes)
+    {
+        size_t written = 0;
+        while (written < bytes.size())
+        {
+            const ssize_t n = ::write(fd, bytes.data() + written, bytes.size() - written);
+
+            if (n <= 0)
+                return false;
+
+            written += static_cast<size_t>(n);
+        }
+
+        return true;
+    }
+
+    /**
+     * Cut the history file to the evaluations before the new ones, append these and sync
+     */
+    static bool appendHistory(const std::string &filepath, uint64_t offset, const std::string &bytes)
+    {
+        const int fd = ::open(filepath.c_str(), O_WRONLY | O_CREAT, 0644);
+
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        bool ok = ::fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) >= offset;
+
+        ok = ok && ::ftruncate(fd, offset) == 0 && ::lseek(fd, offset, SEEK_SET) >= 0;
+        ok = ok && writeAll(fd, bytes) && ::fsync(fd) == 0;
+
+        ::close(fd);
+
+        return ok;
+    }
+
+    /**
+     * Write bytes to a temporary file, sync and rename it over the destination
+     */
+    static bool writeAtomic(const std::string &filepath, const std::string &bytes)
+    {
+        const std::string tmpPath = filepath + ".tmp";
+
+        const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0)
+            return false;
+
+        if (!writeAll(fd, bytes))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        const bool synced = (::fsync(fd) == 0);
+        ::close(fd);
+
+        return synced && std::rename(tmpPath.c_str(), filepath.c_str()) == 0;
+    }
+
+    Writer::~Writer()
+    {
+        wait();
+    }
+
+    void Writer::write(const std::string &filepath, const Checkpoint &cp)
+    {
+        wait();
+
+        Encoder history;
+        for (const auto &evaluation : cp.history)
+            history.putEvaluation(evaluation);
+
+        // Evaluations have the same size within a run, the ones before are already in the file
+        Encoder one;
+        if (!cp.organisms.empty())
+            one.putEvaluation(cp.organisms.front());
+
+        const uint64_t offset = (cp.historySize - cp.history.size()) * one.bytes.size();
+
+        m_pending = std::async(std::launch::async, [filepath, offset, history = std::move(history.bytes), bytes = serialize(cp)]() {
+            const bool ok = appendHistory(historyPath(filepath), offset, history) && writeAtomic(filepath, bytes);
+
+            if (!ok)
+                CONSOLE_LOG("[ ERROR ]: Could not write checkpoint " << filepath << std::endl);
+
+            return ok;
+        });
+    }
+
+    bool Writer::wait()
+    {
+        if (!m_pending.valid())
+            return true;
+
+        return m_pending.get();
+    }
+} // namespace ga::checkpoint
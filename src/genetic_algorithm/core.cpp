@@ -57,6 +57,18 @@ namespace ga::core
         return result;
     }
 
+    bool Genome::operator==(const Genome &other) const
+    {
+        if (chromosomes.size() != other.chromosomes.size())
+            return false;
+
+        for (size_t i = 0; i < chromosomes.size(); i++)
+            if (chromosomes[i].genes != other.chromosomes[i].genes)
+                return false;
+
+        return true;
+    }
+
     void Genome::encode(const mpc::Params::Weights &weights)
     {
         chromosomes[0].encodeWeight(weights.vel);
@@ -87,4 +99,18 @@ namespace ga::core
     {
         chromosomes.emplace_back(lb, ub);
     }
-} // namespace ga::core
\ No newline at end of file
+} // namespace ga::core
+
+namespace ga::random
+{
+    std::mt19937_64 &engine()
+    {
+        static std::mt19937_64 s_Engine;
+        return s_Engine;
+    }
+
+    double uniform()
+    {
+        return std::generate_canonical<double, 53>(engine());
+    }
+} // namespace ga::random
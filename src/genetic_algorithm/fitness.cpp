@@ -1,5 +1,7 @@
 #include "genetic_algorithm/fitness.h"
+#include "utils/trace.hpp"
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 
 /**
@@ -13,18 +15,38 @@ static void normalize(std::vector<double> &array)
         array[i] = (array[i] - *min) / (*max - *min);
 }
 
+/**
+ * Nearest-rank percentile, reorders the data
+ */
+static double percentile(std::vector<double> &array, double percent)
+{
+    if (array.empty())
+        return 0.0;
+
+    const size_t rank = std::max<size_t>(1, std::ceil(percent / 100.0 * array.size()));
+    const auto nth = array.begin() + (rank - 1);
+
+    std::nth_element(array.begin(), nth, array.end());
+
+    return *nth;
+}
+
 namespace ga::fitness
 {
-    ObjFunction::ObjFunction() : m_Weights{{0.2, 1.0, 0.4, 0.2, 0.2}},
+    ObjFunction::ObjFunction() : m_Weights{{0.2, 1.0, 0.4, 0.2, 0.2, 0.0, 0.0}},
+                                 m_prevMetrics{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}},
+                                 m_solverCost(SolverCost::NONE),
                                  m_started(false),
                                  m_terminated(false),
                                  m_deltaN(0.05)
     {
     }
 
-    darr5_t ObjFunction::_getMetrics(model::Performance performance)
+    metrics_t ObjFunction::_getMetrics(model::Performance performance)
     {
-        darr5_t metrics = {0.0, 0.0, 0.0, 0.0, 0.0};
+        TRACE_SCOPE("ObjFunction::getMetrics");
+
+        metrics_t metrics = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
 
         const size_t &iterations = performance.cteData.size();
 
@@ -47,21 +69,54 @@ namespace ga::fitness
             metrics[4] += abs(performance.rotationalEL[i]);
         }
 
+        // The solver cost is not normalized, a weight set that is twice as expensive to solve should
+        // score worse even if every weight set of the generation is expensive
+        std::vector<double> *cost = nullptr;
+        double scale = 1.0;
+
+        if (m_solverCost == SolverCost::ITERATIONS)
+        {
+            cost = &performance.solveIterations;
+        }
+        else if (m_solverCost == SolverCost::LATENCY)
+        {
+            cost = &performance.solveSeconds;
+            scale = 1e3;
+        }
+
+        if (cost)
+        {
+            metrics[5] = scale * percentile(*cost, 50.0);
+            metrics[6] = scale * percentile(*cost, 99.0);
+        }
+
         return metrics;
     }
 
-    double ObjFunction::_evaluateImpl(const model::Performance &performance)
+    SolverCost ObjFunction::parseSolverCost(const std::string &name)
     {
-        double fitness = 0.0;
+        if (name == "iterations")
+            return SolverCost::ITERATIONS;
 
-        const darr5_t metrics = _getMetrics(performance);
+        if (name == "latency")
+            return SolverCost::LATENCY;
 
-        for (size_t i = 0; i < 5; i++)
-            fitness += m_Weights[i] * metrics[i];
+        if (name != "none")
+            CONSOLE_LOG("[ ERROR ]: Unknown solver cost " << name << ", leaving it out of the objective" << std::endl);
+
+        return SolverCost::NONE;
+    }
+
+    double ObjFunction::_scoreImpl(const metrics_t &metrics, const metrics_t &weights)
+    {
+        double fitness = 0.0;
+
+        for (size_t i = 0; i < N_METRICS; i++)
+            fitness += weights[i] * metrics[i];
 
         // We are trying to minimise the weighted average, hence goes in denominator
         double weightSum = 0;
-        weightSum = std::accumulate(m_Weights.begin(), m_Weights.end(), weightSum);
+        weightSum = std::accumulate(weights.begin(), weights.end(), weightSum);
 
         fitness = 10000 * weightSum / fitness;
 
@@ -71,12 +126,22 @@ namespace ga::fitness
         return fitness;
     }
 
-    void ObjFunction::_interactiveDctImpl(const model::Performance &performance)
+    metrics_t ObjFunction::_bumpedWeightsImpl(const std::vector<size_t> &bumps) const
     {
-        if (m_terminated)
-            return;
+        metrics_t weights = m_Weights;
 
-        const darr5_t currMetrics = _getMetrics(performance);
+        for (const size_t j : bumps)
+            weights[j] += m_deltaN;
+
+        return weights;
+    }
+
+    std::vector<size_t> ObjFunction::_promptIdtImpl(const metrics_t &currMetrics)
+    {
+        std::vector<size_t> bumps;
+
+        if (m_terminated)
+            return bumps;
 
         if (!m_started)
         {
@@ -84,10 +149,12 @@ namespace ga::fitness
         }
         else
         {
-            darr5_t improv;
+            metrics_t improv;
             size_t n, j;
 
-            for (size_t i = 0; i < 5; i++)
+            const size_t count = metricCount();
+
+            for (size_t i = 0; i < count; i++)
                 improv[i] = 100 * (1 - currMetrics[i] / m_prevMetrics[i]);
 
             CONSOLE_LOG(
@@ -97,15 +164,21 @@ namespace ga::fitness
                 << "    (j = 2) ITAE vel     : " << improv[2] << "\n"
                 << "    (j = 3) IAE EL trans : " << improv[3] << "\n"
                 << "    (j = 4) IAE EL rot   : " << improv[4] << "\n");
+
+            if (count > N_TRACKING_METRICS)
+                CONSOLE_LOG(
+                    "    (j = 5) Solver p50   : " << improv[5] << "\n"
+                    << "    (j = 6) Solver p99   : " << improv[6] << "\n");
+
             CONSOLE_LOG("Number of improvements: (0 to terminate IDT) ");
 
             while (true)
             {
                 std::cin >> n;
 
-                if (n < 0 && n > 5)
+                if (n > count)
                 {
-                    CONSOLE_LOG("Input should be less than 5\n");
+                    CONSOLE_LOG("Input should be at most " << count << "\n");
                 }
                 else
                 {
@@ -121,11 +194,17 @@ namespace ga::fitness
             while (n--)
             {
                 std::cin >> j;
-                m_Weights[j] += m_deltaN;
+
+                if (j < count)
+                    bumps.push_back(j);
+                else
+                    CONSOLE_LOG("Ignoring j = " << j << ", should be less than " << count << "\n");
             }
             CONSOLE_LOG("\n");
         }
 
         m_prevMetrics = currMetrics;
+
+        return bumps;
     }
 } // namespace ga::fitness
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "genetic_algorithm/nsga2.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace ga::nsga2
+{
+    bool dominates(const ga::fitness::metrics_t &a, const ga::fitness::metrics_t &b)
+    {
+        bool better = false;
+
+        for (size_t m = 0; m < a.size(); m++)
+        {
+            if (a[m] > b[m])
+                return false;
+
+            better |= (a[m] < b[m]);
+        }
+
+        return better;
+    }
+
+    std::vector<size_t> nonDominatedSort(const std::vector<ga::fitness::metrics_t> &objectives)
+    {
+        const size_t n = objectives.size();
+
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+
+        // After a lexicographic sort no point can dominate one that comes before it
+        std::sort(order.begin(), order.end(), [&objectives](size_t a, size_t b) {
+            return objectives[a] < objectives[b];
+        });
+
+        std::vector<size_t> result(n, 0);
+        std::vector<std::vector<size_t>> fronts;
+
+        const auto isDominatedBy = [&objectives](const std::vector<size_t> &front, size_t p) {
+            // Points added last are the closest in lexicographic order, check them first
+            for (auto it = front.rbegin(); it != front.rend(); ++it)
+                if (dominates(objectives[*it], objectives[p]))
+                    return true;
+
+            return false;
+        };
+
+        for (const size_t p : order)
+        {
+            // If p is dominated by some point in front k, it is dominated in every front before k as
+            // well, hence the first front that does not dominate p can be found by binary search
+            size_t lo = 0, hi = fronts.size();
+
+            while (lo < hi)
+            {
+                const size_t mid = (lo + hi) / 2;
+
+                if (isDominatedBy(fronts[mid], p))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            if (lo == fronts.size())
+                fronts.emplace_back();
+
+            fronts[lo].push_back(p);
+            result[p] = lo;
+        }
+
+        return result;
+    }
+
+    std::vector<double> crowdingDistance(const std::vector<ga::fitness::metrics_t> &objectives, const std::vector<size_t> &fronts)
+    {
+        const size_t n = objectives.size();
+        const double inf = std::numeric_limits<double>::infinity();
+
+        std::vector<double> distance(n, 0.0);
+
+        if (n == 0)
+            return distance;
+
+        const size_t nFronts = *std::max_element(fronts.begin(), fronts.end()) + 1;
+
+        std::vector<std::vector<size_t>> members(nFronts);
+        for (size_t i = 0; i < n; i++)
+            members[fronts[i]].push_back(i);
+
+        for (auto &front : members)
+        {
+            for (size_t m = 0; m < ga::fitness::N_METRICS; m++)
+            {
+                std::sort(front.begin(), front.end(), [&objectives, m](size_t a, size_t b) {
+                    return objectives[a][m] < objectives[b][m];
+                });
+
+                const double fMin = objectives[front.front()][m];
+                const double fMax = objectives[front.back()][m];
+
+                // A constant objective, e.g. an unused solver cost, has no boundary points
+                if (fMax - fMin <= 0.0)
+                    continue;
+
+                distance[front.front()] = inf;
+                distance[front.back()] = inf;
+
+                for (size_t k = 1; k + 1 < front.size(); k++)
+                    distance[front[k]] += (objectives[front[k + 1]][m] - objectives[front[k - 1]][m]) / (fMax - fMin);
+            }
+        }
+
+        return distance;
+    }
+
+    std::vector<size_t> rank(const std::vector<ga::fitness::metrics_t> &objectives)
+    {
+        const std::vector<size_t> fronts = nonDominatedSort(objectives);
+        const std::vector<double> distance = crowdingDistance(objectives, fronts);
+
+        std::vector<size_t> order(objectives.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        std::stable_sort(order.begin(), order.end(), [&fronts, &distance](size_t a, size_t b) {
+            if (fronts[a] != fronts[b])
+                return fronts[a] < fronts[b];
+
+            return distance[a] > distance[b];
+        });
+
+        return order;
+    }
+} // namespace ga::nsga2
@@ -1,14 +1,17 @@
 #include "genetic_algorithm/operators.h"
+#include "utils/trace.hpp"
 
 namespace ga::operators::mutation
 {
     ga::core::Genome bitFlip(const ga::core::Genome &genome, double mutationProbability)
     {
+        TRACE_SCOPE("mutation");
+
         ga::core::Genome newGenome = genome;
 
         for (auto &chrom : newGenome.chromosomes)
             for (size_t i = 0; i < chrom.genes.size(); i++)
-                if ((rand() / double(RAND_MAX)) < mutationProbability)
+                if (ga::random::uniform() < mutationProbability)
                     chrom.genes[i] = !chrom.genes[i];
 
         return newGenome;
@@ -19,6 +22,8 @@ namespace ga::operators::crossover
 {
     ga::core::Genome uniform(const ga::core::Genome &parent_1, const ga::core::Genome &parent_2, double bias)
     {
+        TRACE_SCOPE("crossover");
+
         // Copy gene of parent
         ga::core::Genome offspring_1 = parent_1;
         // Genome offspring_2 = parent_2;
@@ -30,7 +35,7 @@ namespace ga::operators::crossover
         {
             for (size_t j = 0; j < n_genes; j++)
             {
-                if ((rand() / double(RAND_MAX)) < bias)
+                if (ga::random::uniform() < bias)
                 {
                     offspring_1.chromosomes[i].genes[j] = parent_1.chromosomes[i].genes[j];
                     // offspring_2.chromosomes[i].unit[j] = parent_2.chromosomes[i].unit[j];
@@ -3,7 +3,8 @@
 
 namespace ga
 {
-    Organism::Organism()
+    Organism::Organism() : m_fitness(0.0),
+                           m_metrics{{0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}}
     {
         const auto mpcConfig = config::ConfigHandler<config::GA>::getMpcConfig();
 
@@ -41,6 +42,11 @@ namespace ga
         return m_genome;
     }
 
+    const ga::fitness::metrics_t &Organism::getMetrics() const
+    {
+        return m_metrics;
+    }
+
     void Organism::setFitness(double fitness)
     {
         m_fitness = fitness;
@@ -56,6 +62,11 @@ namespace ga
         m_genome = genome;
     }
 
+    void Organism::setMetrics(const ga::fitness::metrics_t &metrics)
+    {
+        m_metrics = metrics;
+    }
+
     void Organism::saveAsBest(size_t genCount)
     {
         const mpc::Params::Weights &w = getWeights();
@@ -69,9 +80,26 @@ namespace ga
             w.omega_d,
             w.acc_d);
 
+        m_jsonLogger.logSolver(getSolverProfile().summary());
+
         std::string name = "data/best-of-generation-" + std::to_string(genCount) + ".json";
 
-        m_jsonLogger.dump(name);
+        AsyncOutput::get().post([logger = m_jsonLogger, name]() {
+            if (!logger.dump(name))
+                CONSOLE_LOG("[ ERROR ]: Could not write " << name << std::endl);
+        });
+    }
+
+    void Organism::saveAsBest(size_t genCount, std::shared_ptr<RunWriter> writer) const
+    {
+        const mpc::Params::Weights &w = getWeights();
+        const std::array<double, 7> weights = {w.vel, w.cte, w.etheta, w.omega, w.acc, w.omega_d, w.acc_d};
+
+        AsyncOutput::get().post([writer, genCount, weights, trajectory = m_jsonLogger.getTrajectory(),
+                                 solver = getSolverProfile().summary()]() {
+            if (!writer->append(genCount, weights, trajectory, solver))
+                CONSOLE_LOG("[ ERROR ]: Could not append generation " << genCount << " to the run output" << std::endl);
+        });
     }
 
-} // namespace ga
\ No newline at end of file
+} // namespace ga
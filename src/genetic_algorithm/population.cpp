@@ -1,12 +1,22 @@
 #include "genetic_algorithm/population.h"
 #include "genetic_algorithm/operators.h"
 #include "genetic_algorithm/fitness.h"
+#include "genetic_algorithm/nsga2.h"
+#include "utils/alloc_tracker.hpp"
+#include "utils/trace.hpp"
 #include "utils/config_handler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <json/writer.h>
+#include <numeric>
 #include <random>
+#include <sstream>
 
-static bool sortByFitness(const ga::Organism &a, const ga::Organism &b)
+static double secondsSince(std::chrono::steady_clock::time_point start)
 {
-    return (a.getFitness() > b.getFitness());
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
 }
 
 namespace ga
@@ -14,22 +24,87 @@ namespace ga
     static const auto gaConfig = config::ConfigHandler<config::GA>::getGAConfig();
     static const auto mpcConfig = config::ConfigHandler<config::GA>::getMpcConfig();
 
-    Population::Population(size_t size, size_t matingPoolSize)
+    Population::Population(size_t size, size_t matingPoolSize, Evaluator evaluator)
         : m_popSize(size),
-          m_matingPoolSize(matingPoolSize)
+          m_matingPoolSize(matingPoolSize),
+          m_evaluator(std::move(evaluator)),
+          m_genCount(0),
+          m_path(model::ReferencePath::load(mpcConfig.reference.route_file)),
+          m_solverPool(gaConfig.lockstep.enabled && gaConfig.lockstep.worker_threads > 1
+                           ? std::make_unique<mpc::SolverPool>(gaConfig.lockstep.worker_threads)
+                           : nullptr),
+          m_lockstep(m_solverPool.get()),
+          m_speculation(gaConfig.general.idt_speculation),
+          m_outputsOpened(false)
     {
+        m_params.forward.timesteps = mpcConfig.general.timesteps;
+        m_params.forward.dt = mpcConfig.general.sample_time;
+        m_params.desired.vel = mpcConfig.desired.velocity;
+        m_params.desired.cte = mpcConfig.desired.cross_track_error;
+        m_params.desired.etheta = mpcConfig.desired.orientation_error;
+        m_params.limits.omega = {-mpcConfig.max_bounds.omega, mpcConfig.max_bounds.omega};
+        m_params.limits.throttle = {-mpcConfig.max_bounds.throttle, mpcConfig.max_bounds.throttle};
+
+        m_condn.iterations = gaConfig.general.iterations_per_genome;
+
+        mpc::EventTrigger trigger;
+        if (mpcConfig.event_trigger.enabled)
+            trigger = mpc::EventTrigger({mpcConfig.event_trigger.position, mpcConfig.event_trigger.heading, mpcConfig.event_trigger.velocity});
+
+        m_lockstep.setEventTrigger(trigger);
+
+        mpc::HorizonScheduler horizon;
+        if (mpcConfig.adaptive_horizon.enabled)
+            horizon = mpc::HorizonScheduler({mpcConfig.adaptive_horizon.min_timesteps, mpcConfig.adaptive_horizon.max_timesteps,
+                                             mpcConfig.adaptive_horizon.step, mpcConfig.adaptive_horizon.grow_error,
+                                             mpcConfig.adaptive_horizon.shrink_error, mpcConfig.adaptive_horizon.max_iterations,
+                                             mpcConfig.adaptive_horizon.move_blocking});
+
+        m_lockstep.setHorizonScheduler(horizon);
+
+        if (mpcConfig.warm_start.enabled)
+            m_warmStart = std::make_shared<mpc::WarmStartCache>(mpcConfig.warm_start.capacity, mpcConfig.warm_start.radius);
+
+        m_lockstep.setWarmStartCache(m_warmStart);
+
+        const ga::fitness::SolverCost solverCost = ga::fitness::ObjFunction::parseSolverCost(gaConfig.objective.solver_cost);
+        ga::fitness::ObjFunction::setSolverCost(solverCost, gaConfig.objective.solver_weight);
+
+        m_configHash = ga::EvalArchive::configHash(mpcConfig, gaConfig.general.iterations_per_genome, solverCost);
+
+        // Stand-in evaluations must not mix with real ones, nor overwrite the outputs of a real run
+        if (!gaConfig.archive.file.empty() && !m_evaluator)
+        {
+            m_archive = std::make_unique<ga::EvalArchive>(gaConfig.archive.file, m_configHash);
+
+            if (!m_archive->isOpen())
+                m_archive.reset();
+        }
+
+        if (!gaConfig.output.run_file.empty() && !m_evaluator)
+            m_runOutput = std::make_shared<RunWriter>();
+
+        if (!gaConfig.output.telemetry_file.empty() && !m_evaluator)
+            m_telemetry = std::make_shared<ga::telemetry::Stream>();
+
         m_organisms.reserve(size);
 
         for (size_t i = 0; i < size; i++)
+        {
             m_organisms.emplace_back();
+            m_organisms.back().setPath(m_path);
+            m_organisms.back().setRecording(gaConfig.general.record_trajectories);
+            m_organisms.back().setEventTrigger(trigger);
+            m_organisms.back().setHorizonScheduler(horizon);
+            m_organisms.back().setWarmStartCache(m_warmStart);
+        }
     }
 
     void Population::randDistInit()
     {
         typedef std::uniform_real_distribution<double> Rd_t;
         // Generator for the distribution
-        std::random_device rand_dev;
-        std::mt19937 generator(rand_dev());
+        std::mt19937_64 &generator = ga::random::engine();
 
         // Distributions for different weights
         Rd_t dist_vel(mpcConfig.weight_bounds.w_vel.first, mpcConfig.weight_bounds.w_vel.second);
@@ -54,15 +129,64 @@ namespace ga
 
             m_organisms[i].setWeights(w);
         }
+
+        if (!m_archive)
+            return;
+
+        const size_t nSeeds = static_cast<size_t>(gaConfig.archive.seed_fraction * m_popSize);
+        const std::vector<ga::core::Genome> seeds = m_archive->seeds(nSeeds, m_organisms[0].getGenome());
+
+        for (size_t i = 0; i < seeds.size(); i++)
+            m_organisms[i].setGenome(seeds[i]);
+
+        CONSOLE_LOG(" -- Seeded " << seeds.size() << " organisms from the evaluation archive\n");
     }
 
     void Population::mainLoop()
     {
-        _updateFitnessVals();
-        std::sort(m_organisms.begin(), m_organisms.end(), sortByFitness);
+        TRACE_SCOPE("Population::mainLoop");
+
+        m_stats = ga::GenerationStats();
+        m_stats.workerThreads = m_solverPool ? m_solverPool->threads() : 1;
+        m_solverStart = mpc::solverTotals();
+        m_allocStart = alloc::total();
+        m_warmStartStart = m_warmStart ? m_warmStart->stats() : mpc::WarmStartCache::Stats();
+        m_generationStart = std::chrono::steady_clock::now();
+
+        std::vector<Result> results;
 
-        _crossover();
-        _mutation();
+        auto start = std::chrono::steady_clock::now();
+        _updateFitnessVals(results);
+        m_stats.seconds.evaluation = secondsSince(start);
+
+        // The rollouts above do not depend on the objective weights, so they were valid whatever the
+        // operator answers. Use the remaining think time on the branches the answer could lead to.
+        if (m_pendingIDT.valid())
+        {
+            start = std::chrono::steady_clock::now();
+            if (m_speculation)
+                _speculate();
+            m_stats.seconds.speculation = secondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            _resolveIDT(results);
+            m_stats.seconds.decision = secondsSince(start);
+
+            if (m_heldBest)
+            {
+                _saveBest(*m_heldBest, m_heldGeneration);
+                m_heldBest.reset();
+            }
+        }
+
+        _commit(results);
+
+        start = std::chrono::steady_clock::now();
+        _rank();
+        m_stats.seconds.ranking = secondsSince(start);
+
+        m_genCount++;
+        m_stats.generation = m_genCount;
     }
 
     double Population::getBestFitness() const
@@ -75,79 +199,657 @@ namespace ga
         return static_cast<std::string>(m_organisms[0].getWeights());
     }
 
-    void Population::runIDT() const
+    void Population::runIDT()
     {
-        ga::fitness::ObjFunction::interactiveDCT(m_organisms[0].getPerformance());
+        m_pendingIDT = std::async(std::launch::async, ga::fitness::ObjFunction::promptIDT, m_organisms[0].getMetrics());
     }
 
-    void Population::refresh(size_t gen_count)
+    bool Population::prompting() const
+    {
+        return m_pendingIDT.valid();
+    }
+
+    void Population::setSpeculation(bool enabled)
+    {
+        m_speculation = enabled;
+    }
+
+    const std::vector<ga::Evaluation> &Population::getHistory() const
+    {
+        return m_history;
+    }
+
+    bool Population::savePareto(const std::string &filepath) const
+    {
+        std::vector<ga::fitness::metrics_t> objectives;
+        objectives.reserve(m_history.size());
+
+        for (const auto &evaluation : m_history)
+            objectives.push_back(evaluation.metrics);
+
+        const std::vector<size_t> fronts = ga::nsga2::nonDominatedSort(objectives);
+
+        Json::Value root(Json::arrayValue);
+        std::vector<ga::core::Genome> saved;
+
+        for (size_t i = 0; i < m_history.size(); i++)
+        {
+            const ga::Evaluation &evaluation = m_history[i];
+
+            // Parents are evaluated again in every generation, keep one entry per genome
+            if (fronts[i] != 0 || std::find(saved.begin(), saved.end(), evaluation.genome) != saved.end())
+                continue;
+
+            saved.push_back(evaluation.genome);
+
+            const mpc::Params::Weights w = evaluation.genome.decode();
+            Json::Value point;
+
+            point["weights"]["vel"] = w.vel;
+            point["weights"]["cte"] = w.cte;
+            point["weights"]["etheta"] = w.etheta;
+            point["weights"]["omega"] = w.omega;
+            point["weights"]["acc"] = w.acc;
+            point["weights"]["omega_d"] = w.omega_d;
+            point["weights"]["acc_d"] = w.acc_d;
+
+            point["metrics"]["itae_cte"] = evaluation.metrics[0];
+            point["metrics"]["itae_etheta"] = evaluation.metrics[1];
+            point["metrics"]["itae_vel"] = evaluation.metrics[2];
+            point["metrics"]["iae_el_trans"] = evaluation.metrics[3];
+            point["metrics"]["iae_el_rot"] = evaluation.metrics[4];
+
+            if (ga::fitness::ObjFunction::metricCount() > ga::fitness::N_TRACKING_METRICS)
+            {
+                point["metrics"]["solver_p50"] = evaluation.metrics[5];
+                point["metrics"]["solver_p99"] = evaluation.metrics[6];
+            }
+
+            point["fitness"] = evaluation.fitness;
+            point["generation"] = static_cast<Json::UInt64>(evaluation.generation);
+
+            root.append(point);
+        }
+
+        try
+        {
+            std::ofstream outFile;
+            Json::StyledStreamWriter writer;
+
+            outFile.open(filepath);
+            writer.write(outFile, root);
+            outFile.close();
+        }
+        catch (std::exception &e)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not save Pareto front - " << e.what() << std::endl);
+            return false;
+        }
+
+        CONSOLE_LOG(" -- Pareto front of " << root.size() << " weight sets saved to " << filepath << "\n");
+
+        return true;
+    }
+
+    void Population::checkpoint(const std::string &filepath)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        ga::Checkpoint cp;
+
+        cp.generation = m_genCount;
+        cp.configHash = m_configHash;
+        cp.objective = ga::fitness::ObjFunction::getState();
+
+        std::ostringstream rngState;
+        rngState << ga::random::engine();
+        cp.rngState = rngState.str();
+
+        cp.organisms.reserve(m_organisms.size());
+        for (const auto &organism : m_organisms)
+            cp.organisms.push_back({organism.getGenome(), organism.getMetrics(), organism.getFitness(), m_genCount});
+
+        // A failed write may have left the history file short, write all of it again
+        if (!m_checkpointWriter.wait())
+            m_historySaved = 0;
+
+        cp.historySize = m_history.size();
+        cp.history.assign(m_history.begin() + m_historySaved, m_history.end());
+        m_historySaved = m_history.size();
+
+        m_checkpointWriter.write(filepath, cp);
+
+        m_stats.seconds.checkpoint += secondsSince(start);
+    }
+
+    bool Population::resume(const std::string &filepath, size_t &genCount)
     {
-        m_organisms[0].saveAsBest(gen_count);
+        ga::Checkpoint cp;
+
+        if (!ga::checkpoint::load(filepath, m_organisms[0].getGenome(), cp))
+            return false;
+
+        if (cp.configHash != m_configHash || cp.organisms.size() != m_popSize)
+        {
+            CONSOLE_LOG("[ ERROR ]: Checkpoint " << filepath << " was written with a different configuration" << std::endl);
+            return false;
+        }
+
+        ga::fitness::ObjFunction::setState(cp.objective);
+
+        std::istringstream rngState(cp.rngState);
+        rngState >> ga::random::engine();
 
         for (size_t i = 0; i < m_popSize; i++)
+        {
             m_organisms[i].refresh();
+            m_organisms[i].setGenome(cp.organisms[i].genome);
+            m_organisms[i].setMetrics(cp.organisms[i].metrics);
+            m_organisms[i].setFitness(cp.organisms[i].fitness);
+        }
+
+        // Stored with the fitness at the time of evaluation
+        m_history = std::move(cp.history);
+        m_historySaved = m_history.size();
+
+        for (auto &evaluation : m_history)
+            evaluation.fitness = ga::fitness::ObjFunction::score(evaluation.metrics);
+
+        m_genCount = cp.generation;
+        genCount = cp.generation;
+
+        // Keep the generations saved before the checkpoint
+        _openOutputs(true);
+
+        CONSOLE_LOG(" -- Resumed from " << filepath << " after generation " << genCount << "\n");
+
+        if (m_warmStart)
+            CONSOLE_LOG(" -- Warm start cache starts empty, the resumed run only agrees within the Ipopt tolerance\n");
+
+        return true;
+    }
+
+    void Population::refresh(size_t gen_count)
+    {
+        TRACE_SCOPE("Population::refresh");
+
+        if (!m_outputsOpened)
+            _openOutputs(false);
+
+        auto start = std::chrono::steady_clock::now();
+
+        // Organisms served from the archive or screened without recording have no trajectory to save yet.
+        // Right after resuming the run output skips the generation if the killed run saved it already
+        if (!m_organisms[0].hasTrajectory() && !m_evaluator)
+        {
+            m_organisms[0].refresh();
+            m_organisms[0].setRecording(true);
+            _rollout(m_organisms[0]);
+            m_organisms[0].setRecording(gaConfig.general.record_trajectories);
+            m_stats.rollouts++;
+        }
+
+        // Written on the output thread, evaluation of the next generation starts right away. A failure
+        // would be reported in the middle of the decision tree prompt, hold the save until it is answered
+        if (m_pendingIDT.valid() && !m_evaluator)
+        {
+            m_heldBest = std::make_unique<ga::Organism>(m_organisms[0]);
+            m_heldGeneration = gen_count;
+        }
+        else
+            _saveBest(m_organisms[0], gen_count);
+
+        m_stats.seconds.saving = secondsSince(start);
+
+        m_lastGeneration.clear();
+        for (const auto &organism : m_organisms)
+            m_lastGeneration.push_back({organism.getGenome(), organism.getMetrics(), organism.getFitness(), m_genCount});
+
+        // The population is already ranked, the fittest organisms form the mating pool
+        m_breedPool.clear();
+        for (size_t k = 0; k < m_matingPoolSize; k++)
+            m_breedPool.push_back(m_organisms[k].getGenome());
+
+        m_branches.clear();
+
+        start = std::chrono::steady_clock::now();
+        _breed(m_organisms, m_breedPool);
+        m_stats.seconds.breeding = secondsSince(start);
+
+        // Refreshing right after resuming closes no generation
+        if (m_stats.generation == gen_count)
+            _emitTelemetry();
+    }
+
+    void Population::_saveBest(ga::Organism &organism, size_t genCount)
+    {
+        if (m_runOutput)
+            organism.saveAsBest(genCount, m_runOutput);
+        else if (!m_evaluator)
+            organism.saveAsBest(genCount);
+    }
+
+    void Population::_openOutputs(bool append)
+    {
+        if (m_runOutput)
+        {
+            AsyncOutput::get().post([writer = m_runOutput, append]() {
+                writer->open(gaConfig.output.run_file, append);
+            });
+        }
+
+        if (m_telemetry)
+        {
+            AsyncOutput::get().post([stream = m_telemetry, append]() {
+                stream->open(gaConfig.output.telemetry_file, append);
+            });
+        }
+
+        m_outputsOpened = true;
+    }
+
+    void Population::_emitTelemetry()
+    {
+        if (!m_telemetry)
+            return;
+
+        m_stats.seconds.total = secondsSince(m_generationStart);
+
+        const mpc::SolverTotals solver = mpc::solverTotals();
+        m_stats.solver.solves = solver.solves - m_solverStart.solves;
+        m_stats.solver.failures = solver.failures - m_solverStart.failures;
+        m_stats.solver.iterations = solver.iterations - m_solverStart.iterations;
+        m_stats.solver.skipped = solver.skipped - m_solverStart.skipped;
+        m_stats.solver.timesteps = solver.timesteps - m_solverStart.timesteps;
+        m_stats.solver.setups = solver.setups - m_solverStart.setups;
+        m_stats.solver.seconds = solver.seconds - m_solverStart.seconds;
+
+        m_stats.allocations = alloc::total() - m_allocStart;
+
+        if (m_warmStart)
+            m_stats.warmStart = m_warmStart->stats() - m_warmStartStart;
+
+        // The population is bred by now, use the evaluated one
+        std::vector<ga::core::Genome> genomes;
+        std::vector<double> fitness;
+        for (const auto &evaluation : m_lastGeneration)
+        {
+            genomes.push_back(evaluation.genome);
+            fitness.push_back(evaluation.fitness);
+        }
+
+        // Not necessarily ordered by fitness, the multi-objective ranking is by front
+        std::sort(fitness.begin(), fitness.end());
+
+        m_stats.population = fitness.size();
+        m_stats.fitnessMin = fitness.front();
+        m_stats.fitnessMax = fitness.back();
+        m_stats.fitnessMedian = fitness.size() % 2 ? fitness[fitness.size() / 2]
+                                                   : 0.5 * (fitness[fitness.size() / 2 - 1] + fitness[fitness.size() / 2]);
+        m_stats.diversity = ga::telemetry::diversity(genomes);
+
+        AsyncOutput::get().post([stream = m_telemetry, stats = m_stats]() {
+            if (!stream->write(stats))
+                CONSOLE_LOG("[ ERROR ]: Could not write telemetry of generation " << stats.generation << std::endl);
+        });
     }
 
-    void Population::_updateFitnessVals()
+    void Population::_updateFitnessVals(std::vector<Result> &results)
     {
-        mpc::Params params;
+        TRACE_SCOPE("evaluation");
+        ALLOC_SCOPE("evaluation");
 
-        params.forward.timesteps = mpcConfig.general.timesteps;
-        params.forward.dt = mpcConfig.general.sample_time;
-        params.desired.vel = mpcConfig.desired.velocity;
-        params.desired.cte = mpcConfig.desired.cross_track_error;
-        params.desired.etheta = mpcConfig.desired.orientation_error;
-        params.limits.omega = {-mpcConfig.max_bounds.omega, mpcConfig.max_bounds.omega};
-        params.limits.throttle = {-mpcConfig.max_bounds.throttle, mpcConfig.max_bounds.throttle};
+        // Keep the console free for the decision tree prompt. A progress bar would also take longer
+        // than a stand-in evaluation
+        const bool quiet = m_pendingIDT.valid() || m_evaluator;
+
+        if (gaConfig.lockstep.enabled && !m_evaluator)
+        {
+            if (!quiet)
+                CONSOLE_LOG(" -- Lockstep rollout of " << m_popSize << " organisms\n");
 
-        model::TerminateOn<config::GA> condn;
-        condn.iterations = gaConfig.general.iterations_per_genome;
+            _evaluateLockstep(m_organisms, results);
+            return;
+        }
 
         for (size_t i = 0; i < m_popSize; i++)
         {
-            params.weights = m_organisms[i].getWeights();
-            const bool ok = m_organisms[i].followSetpoints(params, condn);
+            _evaluate(m_organisms[i], results);
+
+            if (!quiet)
+                m_pBar.show(static_cast<double>(i + 1) * 100 / m_popSize,
+                            " " + std::to_string(i + 1) + "/" + std::to_string(m_popSize) + " ");
+        }
+
+        if (!quiet)
+            m_pBar.done();
+    }
+
+    void Population::_evaluate(ga::Organism &organism, std::vector<Result> &results)
+    {
+        if (_lookup(organism, results))
+            return;
+
+        if (m_evaluator)
+        {
+            _store(organism, m_evaluator(organism.getWeights()), 0.0, results);
+            return;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        _rollout(organism);
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        _store(organism, ga::fitness::ObjFunction::getMetrics(organism.getPerformance()), elapsed.count(), results);
+    }
+
+    void Population::_evaluateLockstep(std::vector<ga::Organism> &organisms, std::vector<Result> &results)
+    {
+        TRACE_SCOPE("lockstep evaluation");
+        ALLOC_SCOPE("lockstep evaluation");
+
+        std::vector<ga::Organism *> pending;
+        std::vector<mpc::Params> params;
+        std::vector<model::State> initStates;
+
+        for (auto &organism : organisms)
+        {
+            if (_lookup(organism, results))
+                continue;
+
+            mpc::Params p = m_params;
+            p.weights = organism.getWeights();
+
+            pending.push_back(&organism);
+            params.push_back(p);
+            initStates.push_back(organism.getModelState());
+        }
+
+        if (pending.empty())
+            return;
 
-            if (!ok)
+        const auto start = std::chrono::steady_clock::now();
+
+        const std::vector<bool> ok = m_lockstep.run(*m_path, params, initStates, m_condn.iterations,
+                                                    [&pending](size_t i, const model::StepRecord &step) {
+                                                        pending[i]->record(step);
+                                                    });
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // Solves of a step are shared, the archive gets the average cost of a rollout
+        const double seconds = elapsed.count() / pending.size();
+
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            if (!ok[i])
                 DEBUG_LOG("Control loop fail!");
 
-            const double fitness = ga::fitness::ObjFunction::evaluate(m_organisms[i].getPerformance());
+            _store(*pending[i], ga::fitness::ObjFunction::getMetrics(pending[i]->getPerformance()), seconds, results);
+        }
+    }
+
+    bool Population::_lookup(ga::Organism &organism, std::vector<Result> &results)
+    {
+        ga::fitness::metrics_t metrics;
+
+        if (!m_archive)
+            return false;
+
+        m_stats.lookups++;
+
+        if (!m_archive->lookup(organism.getGenome(), metrics))
+            return false;
+
+        m_stats.hits++;
+
+        const double fitness = ga::fitness::ObjFunction::score(metrics);
+
+        organism.setMetrics(metrics);
+        organism.setFitness(fitness);
+
+        results.push_back({{organism.getGenome(), metrics, fitness, m_genCount + 1}, 0.0, true});
+
+        return true;
+    }
+
+    void Population::_store(ga::Organism &organism, const ga::fitness::metrics_t &metrics, double rolloutSeconds, std::vector<Result> &results)
+    {
+        TRACE_SCOPE("store evaluation");
+        ALLOC_SCOPE("store evaluation");
+
+        const double fitness = ga::fitness::ObjFunction::score(metrics);
+
+        organism.setMetrics(metrics);
+        organism.setFitness(fitness);
+
+        results.push_back({{organism.getGenome(), metrics, fitness, m_genCount + 1}, rolloutSeconds, false});
+    }
+
+    void Population::_commit(const std::vector<Result> &results)
+    {
+        for (const Result &result : results)
+        {
+            ga::Evaluation evaluation = result.evaluation;
+            evaluation.fitness = ga::fitness::ObjFunction::score(evaluation.metrics);
+
+            m_history.push_back(evaluation);
+
+            if (result.archived)
+                continue;
+
+            if (m_archive)
+                m_archive->append(evaluation.genome, evaluation.metrics, evaluation.fitness, result.rolloutSeconds);
+
+            if (!m_evaluator)
+                m_stats.rollouts++;
+        }
+    }
+
+    void Population::_rollout(ga::Organism &organism) const
+    {
+        mpc::Params params = m_params;
+        params.weights = organism.getWeights();
+
+        const bool ok = organism.followSetpoints(params, m_condn);
+
+        if (!ok)
+            DEBUG_LOG("Control loop fail!");
+    }
+
+    void Population::_rescore()
+    {
+        // Re-weighting is a dot product over the stored metrics, no need to simulate again
+        for (auto &organism : m_organisms)
+            organism.setFitness(ga::fitness::ObjFunction::score(organism.getMetrics()));
+
+        for (auto &evaluation : m_history)
+            evaluation.fitness = ga::fitness::ObjFunction::score(evaluation.metrics);
+
+        _rank();
+    }
+
+    void Population::_rank()
+    {
+        TRACE_SCOPE("ranking");
+        ALLOC_SCOPE("ranking");
+
+        std::vector<ga::fitness::metrics_t> metrics;
+        std::vector<double> fitness;
+
+        metrics.reserve(m_organisms.size());
+        fitness.reserve(m_organisms.size());
+
+        for (const auto &organism : m_organisms)
+        {
+            metrics.push_back(organism.getMetrics());
+            fitness.push_back(organism.getFitness());
+        }
+
+        std::vector<ga::Organism> ranked;
+        ranked.reserve(m_organisms.size());
+
+        for (const size_t i : _rank(metrics, fitness))
+            ranked.push_back(std::move(m_organisms[i]));
+
+        m_organisms = std::move(ranked);
+    }
+
+    std::vector<size_t> Population::_rank(const std::vector<ga::fitness::metrics_t> &metrics, const std::vector<double> &fitness) const
+    {
+        if (gaConfig.general.multi_objective)
+            return ga::nsga2::rank(metrics);
+
+        std::vector<size_t> order(fitness.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        // Stable, so that ranking a ranked population leaves it as it is
+        std::stable_sort(order.begin(), order.end(), [&fitness](size_t a, size_t b) { return fitness[a] > fitness[b]; });
+
+        return order;
+    }
+
+    std::vector<ga::core::Genome> Population::_matingPool(const ga::fitness::metrics_t &weights) const
+    {
+        std::vector<ga::fitness::metrics_t> metrics;
+        std::vector<double> fitness;
+
+        metrics.reserve(m_lastGeneration.size());
+        fitness.reserve(m_lastGeneration.size());
+
+        for (const auto &evaluation : m_lastGeneration)
+        {
+            metrics.push_back(evaluation.metrics);
+            fitness.push_back(ga::fitness::ObjFunction::score(evaluation.metrics, weights));
+        }
+
+        // Ranked as the population itself, so the pool matches the one bred from under the same weights
+        const std::vector<size_t> order = _rank(metrics, fitness);
+
+        std::vector<ga::core::Genome> pool;
+        pool.reserve(m_matingPoolSize);
+
+        for (size_t k = 0; k < m_matingPoolSize && k < order.size(); k++)
+            pool.push_back(m_lastGeneration[order[k]].genome);
+
+        return pool;
+    }
+
+    void Population::_speculate()
+    {
+        TRACE_SCOPE("speculation");
+
+        const auto isReady = [this]() {
+            return m_pendingIDT.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        };
+
+        // Each single bump is a candidate answer, only distinct mating pools lead to different offspring
+        for (size_t j = 0; j < ga::fitness::ObjFunction::metricCount() && !isReady(); j++)
+        {
+            const std::vector<ga::core::Genome> pool = _matingPool(ga::fitness::ObjFunction::bumpedWeights({j}));
+
+            if (pool == m_breedPool)
+                continue;
+
+            bool known = false;
+            for (const auto &branch : m_branches)
+                known |= (branch.pool == pool);
+
+            if (known)
+                continue;
+
+            // Breed from the same engine state the main branch would use if this answer comes in,
+            // so that speculation never changes the outcome of a run
+            const std::mt19937_64 engine = ga::random::engine();
 
-            m_organisms[i].setFitness(fitness);
+            Branch branch{pool, m_organisms, engine};
+            _breed(branch.organisms, pool);
 
-            CONSOLE_LOG(" " << i + 1 << "/" << m_popSize << " ");
-            m_pBar.show(static_cast<double>(i + 1) * 100 / m_popSize);
+            branch.engine = ga::random::engine();
+            ga::random::engine() = engine;
+
+            bool complete = true;
+            for (auto &organism : branch.organisms)
+            {
+                if (isReady())
+                {
+                    complete = false;
+                    break;
+                }
+
+                _evaluate(organism, branch.results);
+            }
+
+            if (complete)
+                m_branches.push_back(std::move(branch));
+        }
+    }
+
+    void Population::_resolveIDT(std::vector<Result> &results)
+    {
+        if (!ga::fitness::ObjFunction::applyIDT(m_pendingIDT.get()))
+            return;
+
+        const std::vector<ga::core::Genome> pool = _matingPool(ga::fitness::ObjFunction::bumpedWeights({}));
+
+        if (pool != m_breedPool)
+        {
+            // The speculative generation was bred from the wrong parents. Keep the matching branch if it
+            // was evaluated, otherwise breed it now. Only the evaluations of the kept generation are recorded
+            auto match = std::find_if(m_branches.begin(), m_branches.end(),
+                                      [&pool](const Branch &branch) { return branch.pool == pool; });
+
+            m_breedPool = pool;
+
+            if (match != m_branches.end())
+            {
+                m_organisms = std::move(match->organisms);
+                ga::random::engine() = match->engine;
+                results = std::move(match->results);
+            }
+            else
+            {
+                _breed(m_organisms, pool);
+
+                results.clear();
+                _updateFitnessVals(results);
+            }
         }
 
-        m_pBar.done();
+        m_branches.clear();
+
+        _rescore();
     }
 
-    void Population::_crossover()
+    void Population::_breed(std::vector<ga::Organism> &organisms, const std::vector<ga::core::Genome> &pool) const
     {
+        TRACE_SCOPE("breeding");
+        ALLOC_SCOPE("breeding");
+
         /**
          * We keep the parents in the new population along with the progenies. This is done because if all progenies
          * turn out to be less fit than their parents, we can carry on the same parents in the next crossover
          */
+        const double probab = gaConfig.operators.mutation_probability;
 
-        ga::core::Genome parent1, parent2;
+        for (size_t k = 0; k < m_matingPoolSize; k++)
+            organisms[k].setGenome(pool[k]);
 
         for (size_t k = m_matingPoolSize; k < m_popSize; k++)
         {
-            parent1 = m_organisms[k % m_matingPoolSize].getGenome();
-            parent2 = m_organisms[(k + 1) % m_matingPoolSize].getGenome();
+            const ga::core::Genome &parent1 = pool[k % m_matingPoolSize];
+            const ga::core::Genome &parent2 = pool[(k + 1) % m_matingPoolSize];
 
-            ga::core::Genome childGenome = ga::operators::crossover::uniform(parent1, parent2);
+            // Crossover followed by mutation of the progeny
+            const ga::core::Genome childGenome = ga::operators::crossover::uniform(parent1, parent2);
 
-            m_organisms[k].setGenome(childGenome);
+            organisms[k].setGenome(ga::operators::mutation::bitFlip(childGenome, probab));
         }
-    }
-
-    void Population::_mutation()
-    {
-        const double probab = config::ConfigHandler<config::GA>::getGAConfig().operators.mutation_probability;
 
-        for (size_t k = m_matingPoolSize; k < m_popSize; k++)
-            m_organisms[k].setGenome(ga::operators::mutation::bitFlip(m_organisms[k].getGenome(), probab));
+        for (auto &organism : organisms)
+            organism.refresh();
     }
 
-} // namespace ga
\ No newline at end of file
+} // namespace ga
@@ -0,0 +1,134 @@
+#include "genetic_algorithm/telemetry.h"
+
+#include <algorithm>
+#include <json/writer.h>
+
+namespace ga
+{
+    GenerationStats::GenerationStats()
+        : generation(0),
+          population(0),
+          fitnessMin(0.0),
+          fitnessMedian(0.0),
+          fitnessMax(0.0),
+          diversity(0.0),
+          lookups(0),
+          hits(0),
+          rollouts(0),
+          seconds{},
+          solver{},
+          allocations{},
+          warmStart{},
+          workerThreads(1)
+    {
+    }
+} // namespace ga
+
+namespace ga::telemetry
+{
+    double diversity(const std::vector<ga::core::Genome> &genomes)
+    {
+        if (genomes.size() < 2)
+            return 0.0;
+
+        size_t distance = 0;
+        size_t genes = 0;
+
+        for (const auto &chromosome : genomes[0].chromosomes)
+            genes += chromosome.genes.size();
+
+        for (size_t i = 0; i < genomes.size(); i++)
+            for (size_t j = i + 1; j < genomes.size(); j++)
+                for (size_t c = 0; c < genomes[i].chromosomes.size(); c++)
+                    distance += (genomes[i].chromosomes[c].genes ^ genomes[j].chromosomes[c].genes).count();
+
+        const double pairs = 0.5 * genomes.size() * (genomes.size() - 1);
+
+        return distance / (pairs * genes);
+    }
+
+    double utilization(const GenerationStats &stats)
+    {
+        const double simulated = stats.seconds.evaluation + stats.seconds.speculation + stats.seconds.saving;
+
+        if (simulated <= 0.0)
+            return 0.0;
+
+        return std::min(1.0, stats.solver.seconds / (simulated * stats.workerThreads));
+    }
+
+    std::string format(const GenerationStats &stats)
+    {
+        Json::Value root;
+
+        root["generation"] = static_cast<Json::UInt64>(stats.generation);
+        root["population"] = static_cast<Json::UInt64>(stats.population);
+
+        root["fitness"]["min"] = stats.fitnessMin;
+        root["fitness"]["median"] = stats.fitnessMedian;
+        root["fitness"]["max"] = stats.fitnessMax;
+        root["diversity"] = stats.diversity;
+
+        root["archive"]["lookups"] = static_cast<Json::UInt64>(stats.lookups);
+        root["archive"]["hits"] = static_cast<Json::UInt64>(stats.hits);
+        root["archive"]["hit_rate"] = stats.lookups > 0 ? static_cast<double>(stats.hits) / stats.lookups : 0.0;
+        root["rollouts"] = static_cast<Json::UInt64>(stats.rollouts);
+
+        root["seconds"]["total"] = stats.seconds.total;
+        root["seconds"]["evaluation"] = stats.seconds.evaluation;
+        root["seconds"]["speculation"] = stats.seconds.speculation;
+        root["seconds"]["decision"] = stats.seconds.decision;
+        root["seconds"]["ranking"] = stats.seconds.ranking;
+        root["seconds"]["checkpoint"] = stats.seconds.checkpoint;
+        root["seconds"]["saving"] = stats.seconds.saving;
+        root["seconds"]["breeding"] = stats.seconds.breeding;
+
+        root["ipopt"]["solves"] = static_cast<Json::UInt64>(stats.solver.solves);
+        root["ipopt"]["failures"] = static_cast<Json::UInt64>(stats.solver.failures);
+        root["ipopt"]["iterations"] = static_cast<Json::UInt64>(stats.solver.iterations);
+        root["ipopt"]["skipped"] = static_cast<Json::UInt64>(stats.solver.skipped);
+        root["ipopt"]["mean_timesteps"] = stats.solver.solves > 0 ? static_cast<double>(stats.solver.timesteps) / stats.solver.solves : 0.0;
+        root["ipopt"]["setups"] = static_cast<Json::UInt64>(stats.solver.setups);
+        root["ipopt"]["seconds"] = stats.solver.seconds;
+
+        root["warm_start"]["lookups"] = static_cast<Json::UInt64>(stats.warmStart.lookups);
+        root["warm_start"]["hit_rate"] = stats.warmStart.hitRate();
+        root["warm_start"]["iterations_saved"] = stats.warmStart.iterationsSaved();
+        root["warm_start"]["fallbacks"] = static_cast<Json::UInt64>(stats.warmStart.fallbacks);
+
+        root["allocations"]["count"] = static_cast<Json::UInt64>(stats.allocations.allocations);
+        root["allocations"]["bytes"] = static_cast<Json::UInt64>(stats.allocations.bytes);
+        root["allocations"]["per_rollout"] = stats.rollouts > 0 ? static_cast<double>(stats.allocations.allocations) / stats.rollouts : 0.0;
+
+        root["workers"]["threads"] = static_cast<Json::UInt64>(stats.workerThreads);
+        root["workers"]["utilization"] = utilization(stats);
+
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+
+        return Json::writeString(builder, root);
+    }
+
+    bool Stream::open(const std::string &filepath, bool append)
+    {
+        m_file.open(filepath, append ? std::ios::app : std::ios::trunc);
+
+        if (!m_file.is_open())
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not open telemetry file " << filepath << std::endl);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Stream::write(const GenerationStats &stats)
+    {
+        if (!m_file.is_open())
+            return false;
+
+        m_file << format(stats) << std::endl;
+
+        return m_file.good();
+    }
+} // namespace ga::telemetry
@@ -1,10 +1,27 @@
 #include "genetic_algorithm/population.h"
 #include "utils/config_handler.hpp"
+#include "utils/trace.hpp"
+#include <cstring>
 
 int main(int argc, char **argv)
 {
     DEBUG_LOG("Binary built in debug mode. If not intended, abort.");
-    srand(time(0));
+    ga::random::engine().seed(time(0));
+
+    // Usage: hone_weights [--resume [checkpoint]]
+    std::string checkpointPath = "data/checkpoint.bin";
+    bool resume = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--resume") == 0)
+        {
+            resume = true;
+
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                checkpointPath = argv[++i];
+        }
+    }
 
     const auto gaConfig = config::ConfigHandler<config::GA>::getGAConfig();
 
@@ -14,18 +31,50 @@ int main(int argc, char **argv)
 
     std::unique_ptr<ga::Population> newPopulation(new ga::Population(popSize, matingPoolSize));
 
-    newPopulation->randDistInit();
+    size_t firstGen = 1;
+
+    if (resume)
+    {
+        size_t lastGen = 0;
+
+        if (!newPopulation->resume(checkpointPath, lastGen))
+            return 1;
+
+        // Pick up exactly where the checkpoint was taken
+        if (gaConfig.general.interactive_decision_tree && lastGen < numberOfGenerations)
+            newPopulation->runIDT();
+
+        newPopulation->refresh(lastGen);
+        firstGen = lastGen + 1;
+    }
+    else
+    {
+        newPopulation->randDistInit();
+    }
 
-    for (size_t gen = 1; gen < numberOfGenerations + 1; gen++)
+    for (size_t gen = firstGen; gen < numberOfGenerations + 1; gen++)
     {
-        CONSOLE_LOG(" -- Generation: " << gen << "\n");
+        // The decision tree prompt owns the console until mainLoop picks up the answer
+        const bool prompting = newPopulation->prompting();
+
+        if (!prompting)
+            CONSOLE_LOG(" -- Generation: " << gen << "\n");
 
         // All magic happens here !!
         newPopulation->mainLoop();
 
+        if (prompting)
+            CONSOLE_LOG(" -- Generation: " << gen << "\n");
+
         CONSOLE_LOG("Best fitness: " << newPopulation->getBestFitness() << "\n\n");
 
-        if (gaConfig.general.interactive_decision_tree)
+        const size_t interval = gaConfig.general.checkpoint_interval;
+
+        if (interval > 0 && (gen % interval == 0 || gen == numberOfGenerations))
+            newPopulation->checkpoint(checkpointPath);
+
+        // Non-blocking, the answer is picked up while the next generation is evaluated
+        if (gaConfig.general.interactive_decision_tree && gen < numberOfGenerations)
             newPopulation->runIDT();
 
         newPopulation->refresh(gen);
@@ -33,6 +82,13 @@ int main(int argc, char **argv)
 
     CONSOLE_LOG("\033[1;33m COMPLETE \033[0m\n\n");
 
+    if (gaConfig.general.multi_objective)
+        newPopulation->savePareto("data/pareto-front.json");
+
     CONSOLE_LOG("Optimum weights found : \n"
                 << newPopulation->getBestWeights() << std::endl);
+
+    // The output thread records spans as well, wait until it is idle
+    AsyncOutput::get().flush();
+    TRACE_DUMP("data/trace.json");
 }
\ No newline at end of file
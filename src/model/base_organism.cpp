@@ -1,106 +1,114 @@
 #include "model/base_organism.h"
+#include "utils/alloc_tracker.hpp"
+#include "utils/trace.hpp"
 
 namespace model
 {
-    template <>
-    bool BaseOrganism<config::MONO>::followSetpoints(const mpc::Params &params, const TerminateOn<config::MONO> &term)
+    template <config::ConfigType __type>
+    StepRecord BaseOrganism<__type>::_step(const mpc::Params &params)
     {
-        m_dModel.setSampleTime(params.forward.dt);
+        TRACE_SCOPE("control step");
 
-        double prevOmega = 0.0, prevSpeed = 0.0;
-        size_t count = 0;
+        const alloc::Counts stepStart = alloc::local();
 
-        try
-        {
-            bool done = false;
+        const State state = m_dModel.getState();
 
-            while (!done)
-            {
-                std::array<double, 40> ptsx;
-                std::array<double, 40> ptsy;
+        const double px = state.x;
+        const double py = state.y;
+        const double theta = state.theta;
+        const double v = state.linVel;
+        double omega = state.angVel;
+        double throttle = state.throttle;
 
-                const State state = m_dModel.getState();
+        // Piece of the reference spline ahead, as a cubic in the robot frame
+        const std::array<double, 4> cubic = m_tracker.localCubic(px, py, theta, ReferencePath::LOOKAHEAD);
+        Eigen::VectorXd coeffs = Eigen::Map<const Eigen::Vector4d>(cubic.data());
 
-                for (size_t i = 0; i < 40; i++)
-                {
-                    ptsx[i] = state.x + i * 0.1;
-                    ptsy[i] = 0.0;
-                }
+        const double cte = mpc::utils::polyeval(coeffs, 0);
+        const double etheta = -atan(coeffs[1]);
 
-                const double px = state.x;
-                const double py = state.y;
-                const double theta = state.theta;
-                const double v = state.linVel;
-                double omega = state.angVel;
-                double throttle = state.throttle;
+        if (abs(cte) > 10)
+            DEBUG_LOG("CTE out of bounds!! Got: " << cte);
 
-                for (size_t i = 0; i < ptsx.size(); i++)
-                {
-                    const double shift_x = ptsx[i] - px;
-                    const double shift_y = ptsy[i] - py;
-                    ptsx[i] = shift_x * cos(-theta) - shift_y * sin(-theta);
-                    ptsy[i] = shift_x * sin(-theta) + shift_y * cos(-theta);
-                }
+        const double dt = params.forward.dt;
+        const double current_px = 0.0 + v * dt;
+        const double current_py = 0.0;
+        const double current_theta = 0.0 + omega * dt;
+        const double current_v = v + throttle * dt;
+        const double current_cte = cte + v * sin(etheta) * dt;
+        const double current_etheta = etheta - current_theta;
 
-                double *ptrx = &ptsx[0];
-                Eigen::Map<Eigen::VectorXd> ptsx_transform(ptrx, 6);
+        Eigen::VectorXd model_state(6);
+        model_state << current_px, current_py, current_theta, current_v, current_cte, current_etheta;
 
-                double *ptry = &ptsy[0];
-                Eigen::Map<Eigen::VectorXd> ptsy_transform(ptry, 6);
+        double cost;
+        mpc::SolveStats stats;
 
-                Eigen::VectorXd coeffs = mpc::utils::polyfit(ptsx_transform, ptsy_transform, 3);
+        // Follow the last plan while the robot stays on it, else time to solve !
+        stats.skipped = m_trigger.follow(px + current_px * cos(theta), py + current_px * sin(theta), theta + current_theta, current_v,
+                                         omega, throttle);
 
-                const double cte = mpc::utils::polyeval(coeffs, 0);
-                const double etheta = -atan(coeffs[1]);
+        if (stats.skipped)
+            cost = m_trigger.plan().cost;
+        else
+        {
+            mpc::Params stepParams(params);
+            m_horizon.schedule(stepParams);
 
-                if (abs(cte) > 10)
-                    DEBUG_LOG("CTE out of bounds!! Got: " << cte);
+            mpc::MPC _mpc(stepParams, coeffs);
+            _mpc.setWarmStart(m_warmStart.get());
 
-                const double dt = params.forward.dt;
-                const double current_px = 0.0 + v * dt;
-                const double current_py = 0.0;
-                const double current_theta = 0.0 + omega * dt;
-                const double current_v = v + throttle * dt;
-                const double current_cte = cte + v * sin(etheta) * dt;
-                const double current_etheta = etheta - current_theta;
+            const std::vector<double> &mpc_solns = _mpc.solve(model_state, m_trigger.enabled() ? &m_trigger.plan() : nullptr);
 
-                Eigen::VectorXd model_state(6);
-                model_state << current_px, current_py, current_theta, current_v, current_cte, current_etheta;
+            omega = mpc_solns[0];
+            throttle = mpc_solns[1];
+            cost = mpc_solns[2];
+            stats = _mpc.stats();
 
-                // time to solve !
-                mpc::MPC _mpc(params, coeffs);
-                const std::vector<double> &mpc_solns = _mpc.solve(model_state);
+            m_trigger.accept(stats, px, py, theta);
+        }
 
-                omega = mpc_solns[0];
-                throttle = mpc_solns[1];
+        const double velError = current_v - params.desired.vel;
 
-                double speed = current_v + throttle * dt;
+        m_horizon.update(current_cte, current_etheta, velError, stats);
 
-                m_dModel.step(speed, omega);
+        const double speed = current_v + throttle * dt;
 
-                count++;
-                CONSOLE_LOG(" [ INFO ]: Updating internal model ... timestep " << count << "\r");
+        m_dModel.step(speed, omega);
+
+        return {px, py, velError, current_cte, current_etheta, cost, speed, omega, stats, (alloc::local() - stepStart).allocations};
+    }
 
-                m_jsonLogger.logX(px);
-                m_jsonLogger.logY(py);
-                m_jsonLogger.logVelError(current_v - params.desired.vel);
-                m_jsonLogger.logCte(current_cte);
-                m_jsonLogger.logEtheta(current_etheta);
-                m_jsonLogger.logCost(mpc_solns[2]);
+    template <>
+    bool BaseOrganism<config::MONO>::followSetpoints(const mpc::Params &params, const TerminateOn<config::MONO> &term)
+    {
+        TRACE_SCOPE("followSetpoints");
 
-                m_performance.cteData.push_back(current_cte);
-                m_performance.ethetaData.push_back(current_etheta);
-                m_performance.velErrData.push_back(params.desired.vel - current_v);
+        m_dModel.setSampleTime(params.forward.dt);
+
+        m_prevSpeed = 0.0;
+        m_prevOmega = 0.0;
+        m_tracker.reset();
+        m_trigger.reset();
+        m_horizon.reset();
+        size_t count = 0;
 
-                m_performance.translationalEL.push_back(pow(speed, 2) - pow(prevSpeed, 2));
-                m_performance.rotationalEL.push_back(pow(omega, 2) - pow(prevOmega, 2));
+        try
+        {
+            bool done = false;
 
-                prevSpeed = speed;
-                prevOmega = omega;
+            while (!done)
+            {
+                const StepRecord step = _step(params);
 
-                done = abs(current_cte) < term.tolerance.cte &&
-                       abs(current_v - params.desired.vel) < term.tolerance.vel &&
-                       abs(current_etheta) < term.tolerance.etheta;
+                count++;
+                CONSOLE_LOG(" [ INFO ]: Updating internal model ... timestep " << count << "\r");
+
+                record(step);
+
+                done = abs(step.cte) < term.tolerance.cte &&
+                       abs(step.velError) < term.tolerance.vel &&
+                       abs(step.etheta) < term.tolerance.etheta;
             }
 
             CONSOLE_LOG("\n -- Run complete. Took " << count << " iterations" << std::endl);
@@ -117,98 +125,22 @@ namespace model
     template <>
     bool BaseOrganism<config::GA>::followSetpoints(const mpc::Params &params, const TerminateOn<config::GA> &term)
     {
+        TRACE_SCOPE("followSetpoints");
+
         m_dModel.setSampleTime(params.forward.dt);
+        m_jsonLogger.reserve(term.iterations);
 
-        double prevOmega = 0.0, prevSpeed = 0.0;
+        m_prevSpeed = 0.0;
+        m_prevOmega = 0.0;
+        m_tracker.reset();
+        m_trigger.reset();
+        m_horizon.reset();
 
         try
         {
             for (size_t count = 0; count < term.iterations; count++)
-            {
-                std::array<double, 40> ptsx;
-                std::array<double, 40> ptsy;
-
-                const State state = m_dModel.getState();
-
-                for (size_t i = 0; i < 40; i++)
-                {
-                    ptsx[i] = state.x + i * 0.1;
-                    ptsy[i] = 0.0;
-                }
-
-                const double px = state.x;
-                const double py = state.y;
-                const double theta = state.theta;
-                const double v = state.linVel;
-                double omega = state.angVel;
-                double throttle = state.throttle;
-
-                for (size_t i = 0; i < ptsx.size(); i++)
-                {
-                    const double shift_x = ptsx[i] - px;
-                    const double shift_y = ptsy[i] - py;
-                    ptsx[i] = shift_x * cos(-theta) - shift_y * sin(-theta);
-                    ptsy[i] = shift_x * sin(-theta) + shift_y * cos(-theta);
-                }
-
-                double *ptrx = &ptsx[0];
-                Eigen::Map<Eigen::VectorXd> ptsx_transform(ptrx, 6);
-
-                double *ptry = &ptsy[0];
-                Eigen::Map<Eigen::VectorXd> ptsy_transform(ptry, 6);
-
-                Eigen::VectorXd coeffs = mpc::utils::polyfit(ptsx_transform, ptsy_transform, 3);
-
-                const double cte = mpc::utils::polyeval(coeffs, 0);
-                const double etheta = -atan(coeffs[1]);
-
-                if (abs(cte) > 10)
-                    DEBUG_LOG("CTE out of bounds!! Got: " << cte);
-
-                const double dt = params.forward.dt;
-                const double current_px = 0.0 + v * dt;
-                const double current_py = 0.0;
-                const double current_theta = 0.0 + omega * dt;
-                const double current_v = v + throttle * dt;
-                const double current_cte = cte + v * sin(etheta) * dt;
-                const double current_etheta = etheta - current_theta;
-
-                Eigen::VectorXd model_state(6);
-                model_state << current_px, current_py, current_theta, current_v, current_cte, current_etheta;
-
-                // time to solve !
-                mpc::MPC _mpc(params, coeffs);
-
-                const std::vector<double> &mpc_solns = _mpc.solve(model_state);
-
-                omega = mpc_solns[0];
-                throttle = mpc_solns[1];
-                const double cost = mpc_solns[2];
-
-                const double speed = current_v + throttle * dt;
-
-                m_dModel.step(speed, omega);
-                const double velError = current_v - params.desired.vel;
-
-                m_jsonLogger.logX(px);
-                m_jsonLogger.logY(py);
-                m_jsonLogger.logVelError(velError);
-                m_jsonLogger.logCte(current_cte);
-                m_jsonLogger.logEtheta(current_etheta);
-                m_jsonLogger.logCost(cost);
-
-                m_performance.cteData.push_back(current_cte);
-                m_performance.ethetaData.push_back(current_etheta);
-                m_performance.velErrData.push_back(velError);
-
-                m_performance.translationalEL.push_back(pow(speed, 2) - pow(prevSpeed, 2));
-                m_performance.rotationalEL.push_back(pow(omega, 2) - pow(prevOmega, 2));
-
-                prevSpeed = speed;
-                prevOmega = omega;
-            }
+                record(_step(params));
         }
-
         catch (std::exception &e)
         {
             DEBUG_LOG("Error in NMPC control loop: " << e.what());
@@ -216,5 +148,5 @@ namespace model
         }
 
         return true;
-    } // namespace model
+    }
 } // namespace model
@@ -1,4 +1,5 @@
 #include "model/differential_drive.h"
+#include "utils/trace.hpp"
 #include <cmath>
 
 namespace model
@@ -13,6 +14,9 @@ namespace model
         rotationalEL.clear();
 
         costs.clear();
+
+        solveIterations.clear();
+        solveSeconds.clear();
     }
     
     DifferentialDrive::DifferentialDrive()
@@ -26,6 +30,8 @@ namespace model
 
     void DifferentialDrive::step(double speed, double omega)
     {
+        TRACE_SCOPE("DifferentialDrive::step");
+
         m_state.x += m_state.linVel * cos(m_state.theta) * m_sampleTime;
         m_state.y += m_state.linVel * sin(m_state.theta) * m_sampleTime;
 
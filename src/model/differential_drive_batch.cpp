@@ -0,0 +1,86 @@
+#include "model/differential_drive_batch.h"
+#include "utils/trace.hpp"
+#include <cmath>
+
+namespace model
+{
+    DifferentialDriveBatch::DifferentialDriveBatch(size_t size) : m_sampleTime(0.1)
+    {
+        resize(size);
+    }
+
+    void DifferentialDriveBatch::resize(size_t size)
+    {
+        m_x.resize(size, 0.0);
+        m_y.resize(size, 0.0);
+        m_theta.resize(size, 0.0);
+        m_linVel.resize(size, 0.0);
+        m_angVel.resize(size, 0.0);
+        m_throttle.resize(size, 0.0);
+        m_sinTheta.resize(size, 0.0);
+        m_cosTheta.resize(size, 1.0);
+    }
+
+    size_t DifferentialDriveBatch::size() const
+    {
+        return m_x.size();
+    }
+
+    void DifferentialDriveBatch::setSampleTime(double sampletime)
+    {
+        m_sampleTime = sampletime;
+    }
+
+    void DifferentialDriveBatch::setState(size_t i, const State &state)
+    {
+        m_x[i] = state.x;
+        m_y[i] = state.y;
+        m_theta[i] = state.theta;
+        m_linVel[i] = state.linVel;
+        m_angVel[i] = state.angVel;
+        m_throttle[i] = state.throttle;
+
+        m_sinTheta[i] = sin(state.theta);
+        m_cosTheta[i] = cos(state.theta);
+    }
+
+    State DifferentialDriveBatch::getState(size_t i) const
+    {
+        return {m_x[i], m_y[i], m_theta[i], m_linVel[i], m_angVel[i], m_throttle[i]};
+    }
+
+    void DifferentialDriveBatch::step(const double *speed, const double *omega)
+    {
+        TRACE_SCOPE("DifferentialDriveBatch::step");
+
+        const size_t n = size();
+        const double dt = m_sampleTime;
+
+        double *__restrict x = m_x.data();
+        double *__restrict y = m_y.data();
+        double *__restrict theta = m_theta.data();
+        double *__restrict linVel = m_linVel.data();
+        double *__restrict angVel = m_angVel.data();
+        double *__restrict throttle = m_throttle.data();
+        const double *__restrict sinTheta = m_sinTheta.data();
+        const double *__restrict cosTheta = m_cosTheta.data();
+
+        for (size_t i = 0; i < n; i++)
+        {
+            x[i] += linVel[i] * cosTheta[i] * dt;
+            y[i] += linVel[i] * sinTheta[i] * dt;
+
+            theta[i] += omega[i] * dt;
+            throttle[i] = (speed[i] - linVel[i]) / dt;
+            linVel[i] = speed[i];
+            angVel[i] = omega[i];
+        }
+
+        // Kept apart from the loop above, which then only has plain arithmetic to vectorise
+        for (size_t i = 0; i < n; i++)
+        {
+            m_sinTheta[i] = sin(theta[i]);
+            m_cosTheta[i] = cos(theta[i]);
+        }
+    }
+} // namespace model
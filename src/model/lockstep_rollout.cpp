@@ -0,0 +1,191 @@
+#include "model/lockstep_rollout.h"
+#include "utils/alloc_tracker.hpp"
+#include "utils/trace.hpp"
+#include <algorithm>
+#include <array>
+
+namespace model
+{
+    LockstepRollout::LockstepRollout(mpc::SolverPool *pool) : m_pool(pool)
+    {
+    }
+
+    void LockstepRollout::setEventTrigger(const mpc::EventTrigger &trigger)
+    {
+        m_trigger = trigger;
+    }
+
+    void LockstepRollout::setHorizonScheduler(const mpc::HorizonScheduler &scheduler)
+    {
+        m_horizon = scheduler;
+    }
+
+    void LockstepRollout::setWarmStartCache(const std::shared_ptr<mpc::WarmStartCache> &cache)
+    {
+        m_warmStart = cache;
+    }
+
+    std::vector<bool> LockstepRollout::run(const ReferencePath &path, const std::vector<mpc::Params> &params, const std::vector<State> &initStates,
+                                           size_t iterations, const Recorder &record)
+    {
+        TRACE_SCOPE("LockstepRollout::run");
+
+        const size_t n = params.size();
+        std::vector<bool> active(n, true);
+
+        if (n == 0)
+            return active;
+
+        const double dt = params[0].forward.dt;
+
+        m_batch.resize(n);
+        m_batch.setSampleTime(dt);
+
+        m_trackers.assign(n, ReferencePath::Tracker(&path));
+        m_triggers.assign(n, m_trigger);
+        m_horizons.assign(n, m_horizon);
+
+        for (size_t i = 0; i < n; i++)
+            m_batch.setState(i, initStates[i]);
+
+        m_coeffs.resize(4 * n);
+
+        std::vector<double> cte(n), etheta(n), currentV(n);
+        std::vector<double> speed(n), omega(n), cost(n);
+        std::vector<double> px(n), py(n);
+        std::vector<mpc::SolveStats> solve(n), stats;
+
+        std::vector<mpc::Problem> problems;
+        std::vector<size_t> owners;
+        problems.reserve(n);
+        owners.reserve(n);
+
+        for (size_t count = 0; count < iterations; count++)
+        {
+            // Counted over every thread, the solves may run on the solveBatch workers
+            const alloc::Counts stepStart = alloc::total();
+
+            const double *x = m_batch.x();
+            const double *y = m_batch.y();
+            const double *theta = m_batch.theta();
+            const double *linVel = m_batch.linVel();
+            const double *angVel = m_batch.angVel();
+            const double *throttle = m_batch.throttle();
+
+            // Spline piece ahead of each robot, scattered into the coefficient-major layout
+            for (size_t i = 0; i < n; i++)
+            {
+                const std::array<double, 4> cubic = m_trackers[i].localCubic(x[i], y[i], theta[i], ReferencePath::LOOKAHEAD);
+
+                for (size_t j = 0; j < 4; j++)
+                    m_coeffs[j * n + i] = cubic[j];
+            }
+
+            for (size_t i = 0; i < n; i++)
+            {
+                const double c0 = m_coeffs[i];
+                const double c1 = m_coeffs[n + i];
+                const double e = -atan(c1);
+                const double current_theta = angVel[i] * dt;
+
+                currentV[i] = linVel[i] + throttle[i] * dt;
+                cte[i] = c0 + linVel[i] * sin(e) * dt;
+                etheta[i] = e - current_theta;
+
+                // Robots that dropped out keep their last controls
+                speed[i] = linVel[i];
+                omega[i] = angVel[i];
+                cost[i] = 0.0;
+                solve[i] = mpc::SolveStats();
+            }
+
+            problems.clear();
+            owners.clear();
+
+            for (size_t i = 0; i < n; i++)
+            {
+                if (!active[i])
+                    continue;
+
+                if (abs(m_coeffs[i]) > 10)
+                    DEBUG_LOG("CTE out of bounds!! Got: " << m_coeffs[i]);
+
+                // Follow the last plan while the robot stays on it
+                double acc = 0.0;
+                if (m_triggers[i].follow(x[i] + linVel[i] * dt * cos(theta[i]), y[i] + linVel[i] * dt * sin(theta[i]),
+                                         theta[i] + angVel[i] * dt, currentV[i], omega[i], acc))
+                {
+                    speed[i] = currentV[i] + acc * dt;
+                    cost[i] = m_triggers[i].plan().cost;
+                    solve[i].skipped = true;
+                    m_horizons[i].update(cte[i], etheta[i], currentV[i] - params[i].desired.vel, solve[i]);
+                    continue;
+                }
+
+                mpc::Problem problem{params[i], Eigen::VectorXd(4), Eigen::VectorXd(6)};
+                m_horizons[i].schedule(problem.params);
+
+                for (size_t j = 0; j < 4; j++)
+                    problem.coeffs[j] = m_coeffs[j * n + i];
+
+                problem.state << linVel[i] * dt, 0.0, angVel[i] * dt, currentV[i], cte[i], etheta[i];
+                problem.plan = m_triggers[i].enabled() ? &m_triggers[i].plan() : nullptr;
+                problem.warmStart = m_warmStart.get();
+
+                problems.push_back(problem);
+                owners.push_back(i);
+            }
+
+            if (std::find(active.begin(), active.end(), true) == active.end())
+                break;
+
+            // time to solve !
+            const std::vector<std::vector<double>> solutions = mpc::solveBatch(problems, m_pool, &stats);
+
+            for (size_t p = 0; p < owners.size(); p++)
+            {
+                const size_t i = owners[p];
+
+                if (solutions[p].size() < 3)
+                {
+                    DEBUG_LOG("Control loop fail!");
+                    active[i] = false;
+                    continue;
+                }
+
+                omega[i] = solutions[p][0];
+                speed[i] = currentV[i] + solutions[p][1] * dt;
+                cost[i] = solutions[p][2];
+                solve[i] = stats[p];
+
+                m_triggers[i].accept(stats[p], x[i], y[i], theta[i]);
+                m_horizons[i].update(cte[i], etheta[i], currentV[i] - params[i].desired.vel, stats[p]);
+            }
+
+            // Positions before the step, for the records
+            std::copy(m_batch.x(), m_batch.x() + n, px.begin());
+            std::copy(m_batch.y(), m_batch.y() + n, py.begin());
+
+            m_batch.step(speed.data(), omega.data());
+
+            // Each organism owns the allocations of its solve and an equal share of the rest of the step
+            uint64_t solveAllocations = 0;
+            for (const size_t i : owners)
+                solveAllocations += solve[i].allocations;
+
+            const size_t stepping = std::count(active.begin(), active.end(), true);
+            const uint64_t stepAllocations = (alloc::total() - stepStart).allocations;
+            const uint64_t shared = stepAllocations > solveAllocations && stepping > 0 ? (stepAllocations - solveAllocations) / stepping : 0;
+
+            // Solved and plan following robots alike
+            for (size_t i = 0; i < n; i++)
+            {
+                if (active[i])
+                    record(i, {px[i], py[i], currentV[i] - params[i].desired.vel, cte[i], etheta[i], cost[i], speed[i], omega[i], solve[i],
+                               solve[i].allocations + shared});
+            }
+        }
+
+        return active;
+    }
+} // namespace model
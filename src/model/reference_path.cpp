@@ -0,0 +1,441 @@
+#include "model/reference_path.h"
+#include "mpc_lib/polyfit.hpp"
+#include "utils/trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace model
+{
+    ReferencePath::Tracker::Tracker(const ReferencePath *path)
+        : m_path(path),
+          m_projection({0, 0.0, 0.0}),
+          m_started(false),
+          m_nextPiece(0)
+    {
+        for (auto &piece : m_pieces)
+            piece.segment = SIZE_MAX;
+    }
+
+    void ReferencePath::Tracker::reset()
+    {
+        m_started = false;
+    }
+
+    const ReferencePath::Projection &ReferencePath::Tracker::update(double px, double py)
+    {
+        if (!m_started)
+        {
+            m_projection = m_path->nearest(px, py);
+            m_started = true;
+
+            return m_projection;
+        }
+
+        const size_t last = m_path->segments() - 1;
+        const size_t start = m_projection.segment;
+
+        Projection best = m_path->project(start, px, py);
+
+        // Robots mostly move forward, check that direction first
+        while (best.segment < last)
+        {
+            const Projection next = m_path->project(best.segment + 1, px, py);
+
+            if (next.distance > best.distance)
+                break;
+
+            best = next;
+        }
+
+        while (best.segment == start && best.segment > 0)
+        {
+            const Projection prev = m_path->project(best.segment - 1, px, py);
+
+            if (prev.distance >= best.distance)
+                break;
+
+            best = prev;
+        }
+
+        // Far from the tracked segment, the robot may be closer to another part of the path
+        if (best.distance > m_path->m_cellSize)
+        {
+            const Projection global = m_path->nearest(px, py);
+
+            if (global.distance < best.distance)
+                best = global;
+        }
+
+        m_projection = best;
+
+        return m_projection;
+    }
+
+    const ReferencePath::Projection &ReferencePath::Tracker::projection() const
+    {
+        return m_projection;
+    }
+
+    std::array<double, 4> ReferencePath::Tracker::localCubic(double px, double py, double theta, double lookahead)
+    {
+        TRACE_SCOPE("Tracker::localCubic");
+
+        const double s0 = update(px, py).s;
+
+        double x[2], y[2], heading[2];
+        _splineAt(s0, x[0], y[0], heading[0]);
+        _splineAt(s0 + lookahead, x[1], y[1], heading[1]);
+
+        // Into the frame of the robot, rotation by -theta
+        const double c = cos(theta), sn = sin(theta);
+        double lx[2], ly[2], slope[2];
+
+        for (size_t i = 0; i < 2; i++)
+        {
+            lx[i] = (x[i] - px) * c + (y[i] - py) * sn;
+            ly[i] = -(x[i] - px) * sn + (y[i] - py) * c;
+            slope[i] = tan(heading[i] - theta);
+        }
+
+        const double d = lx[1] - lx[0];
+
+        // Path perpendicular to the robot, no cubic in x through both points
+        if (std::abs(d) < 1e-9)
+            return {ly[0] - slope[0] * lx[0], slope[0], 0.0, 0.0};
+
+        // Hermite cubic in t = x - x0 ...
+        const double chord = (ly[1] - ly[0]) / d;
+        const double a0 = ly[0];
+        const double a1 = slope[0];
+        const double a2 = (3.0 * chord - 2.0 * slope[0] - slope[1]) / d;
+        const double a3 = (slope[0] + slope[1] - 2.0 * chord) / (d * d);
+
+        // ... expanded around x = 0
+        const double x0 = lx[0];
+
+        return {a0 - a1 * x0 + a2 * x0 * x0 - a3 * x0 * x0 * x0,
+                a1 - 2.0 * a2 * x0 + 3.0 * a3 * x0 * x0,
+                a2 - 3.0 * a3 * x0,
+                a3};
+    }
+
+    void ReferencePath::Tracker::_splineAt(double s, double &x, double &y, double &heading)
+    {
+        const ReferencePath &path = *m_path;
+        const size_t last = path.m_count - 1;
+
+        // Straight beyond the ends, along the end headings
+        if (s <= 0.0 || s >= path.m_s[last])
+        {
+            const size_t i = s <= 0.0 ? 0 : last;
+            const double ds = s - path.m_s[i];
+
+            heading = path.m_heading[i];
+            x = path.m_x[i] + ds * cos(heading);
+            y = path.m_y[i] + ds * sin(heading);
+            return;
+        }
+
+        size_t k = std::min(m_projection.segment, path.segments() - 1);
+
+        while (k + 1 < path.segments() && s > path.m_s[k + 1])
+            k++;
+        while (k > 0 && s < path.m_s[k])
+            k--;
+
+        const Piece &p = _piece(k);
+        const double u = s - p.s0;
+
+        x = mpc::utils::horner(p.cx, u);
+        y = mpc::utils::horner(p.cy, u);
+        heading = atan2(mpc::utils::hornerDerivative(p.cy, u), mpc::utils::hornerDerivative(p.cx, u));
+    }
+
+    const ReferencePath::Piece &ReferencePath::Tracker::_piece(size_t segment)
+    {
+        for (const auto &piece : m_pieces)
+            if (piece.segment == segment)
+                return piece;
+
+        Piece &slot = m_pieces[m_nextPiece];
+        m_nextPiece = (m_nextPiece + 1) % m_pieces.size();
+
+        slot = m_path->piece(segment);
+
+        return slot;
+    }
+
+    ReferencePath::ReferencePath(const std::vector<double> &xs, const std::vector<double> &ys, double cellSize)
+    {
+        const size_t count = std::min(xs.size(), ys.size());
+
+        m_ownX.reserve(count);
+        m_ownY.reserve(count);
+        m_ownS.reserve(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!m_ownX.empty())
+            {
+                const double length = hypot(xs[i] - m_ownX.back(), ys[i] - m_ownY.back());
+
+                if (length <= 0.0)
+                    continue;
+
+                m_ownS.push_back(m_ownS.back() + length);
+            }
+            else
+                m_ownS.push_back(0.0);
+
+            m_ownX.push_back(xs[i]);
+            m_ownY.push_back(ys[i]);
+        }
+
+        if (m_ownX.size() < 2)
+            throw std::invalid_argument("Reference path needs at least two distinct waypoints");
+
+        m_x = m_ownX.data();
+        m_y = m_ownY.data();
+        m_s = m_ownS.data();
+        m_count = m_ownX.size();
+
+        _computeHeadings();
+
+        const auto xBounds = std::minmax_element(m_ownX.begin(), m_ownX.end());
+        const auto yBounds = std::minmax_element(m_ownY.begin(), m_ownY.end());
+
+        _buildIndex(cellSize, *xBounds.first, *yBounds.first, *xBounds.second, *yBounds.second);
+    }
+
+    ReferencePath::ReferencePath(const std::shared_ptr<const RouteFile> &route, double cellSize) : m_route(route)
+    {
+        if (!m_route || m_route->size() < 2)
+            throw std::invalid_argument("Reference path needs an open route file with at least two waypoints");
+
+        m_x = m_route->x();
+        m_y = m_route->y();
+        m_heading = m_route->heading();
+        m_count = m_route->size();
+
+        if (m_route->arcLength() != nullptr)
+            m_s = m_route->arcLength();
+        else
+        {
+            m_ownS.resize(m_count, 0.0);
+
+            for (size_t i = 1; i < m_count; i++)
+                m_ownS[i] = m_ownS[i - 1] + hypot(m_x[i] - m_x[i - 1], m_y[i] - m_y[i - 1]);
+
+            m_s = m_ownS.data();
+        }
+
+        const RouteFile::Header &h = m_route->header();
+
+        _buildIndex(cellSize, h.minX, h.minY, h.maxX, h.maxY);
+    }
+
+    std::shared_ptr<const ReferencePath> ReferencePath::load(const std::string &routeFile)
+    {
+        if (routeFile.empty())
+            return xAxis();
+
+        const auto route = std::make_shared<const RouteFile>(routeFile);
+
+        if (!route->isOpen())
+            throw std::runtime_error("Could not load route " + routeFile);
+
+        return std::make_shared<const ReferencePath>(route);
+    }
+
+    std::shared_ptr<const ReferencePath> ReferencePath::xAxis()
+    {
+        static const std::shared_ptr<const ReferencePath> path =
+            std::make_shared<const ReferencePath>(std::vector<double>{0.0, 1.0}, std::vector<double>{0.0, 0.0});
+
+        return path;
+    }
+
+    size_t ReferencePath::segments() const
+    {
+        return m_count - 1;
+    }
+
+    double ReferencePath::length() const
+    {
+        return m_s[m_count - 1];
+    }
+
+    ReferencePath::Projection ReferencePath::project(size_t segment, double px, double py) const
+    {
+        const double ax = m_x[segment], ay = m_y[segment];
+        const double dx = m_x[segment + 1] - ax, dy = m_y[segment + 1] - ay;
+        const double length = m_s[segment + 1] - m_s[segment];
+
+        double t = ((px - ax) * dx + (py - ay) * dy) / (length * length);
+
+        // Only the end segments extend beyond their waypoints
+        if (segment > 0)
+            t = std::max(t, 0.0);
+        if (segment + 1 < segments())
+            t = std::min(t, 1.0);
+
+        return {segment, m_s[segment] + t * length, hypot(ax + t * dx - px, ay + t * dy - py)};
+    }
+
+    ReferencePath::Projection ReferencePath::nearest(double px, double py) const
+    {
+        const int64_t cx = static_cast<int64_t>(floor((px - m_minX) / m_cellSize));
+        const int64_t cy = static_cast<int64_t>(floor((py - m_minY) / m_cellSize));
+
+        // Rings closer than the grid are empty, rings beyond its far side do not exist
+        const int64_t first = std::max({int64_t(0), -cx, cx - (m_cellsX - 1), -cy, cy - (m_cellsY - 1)});
+        const int64_t last = std::max({cx, m_cellsX - 1 - cx, cy, m_cellsY - 1 - cy, first});
+
+        Projection best = project(0, px, py);
+
+        for (int64_t r = first; r <= last; r++)
+        {
+            for (int64_t dx = -r; dx <= r; dx++)
+            {
+                _searchCell(cx + dx, cy - r, px, py, best);
+
+                if (r > 0)
+                    _searchCell(cx + dx, cy + r, px, py, best);
+            }
+
+            for (int64_t dy = -r + 1; dy <= r - 1; dy++)
+            {
+                _searchCell(cx - r, cy + dy, px, py, best);
+                _searchCell(cx + r, cy + dy, px, py, best);
+            }
+
+            // Every point in the next ring is at least r cells away
+            if (best.distance <= r * m_cellSize)
+                break;
+        }
+
+        // The extended end segments reach outside the grid
+        const Projection end = project(segments() - 1, px, py);
+
+        if (end.distance < best.distance)
+            best = end;
+
+        return best;
+    }
+
+    ReferencePath::Piece ReferencePath::piece(size_t segment) const
+    {
+        Piece p;
+        p.segment = segment;
+        p.s0 = m_s[segment];
+        p.length = m_s[segment + 1] - m_s[segment];
+
+        const double L = p.length;
+
+        // Cubic Hermite with unit tangents along the waypoint headings
+        const auto hermite = [L](double v0, double v1, double t0, double t1, std::array<double, 4> &coeffs) {
+            const double chord = (v1 - v0) / L;
+
+            coeffs[0] = v0;
+            coeffs[1] = t0;
+            coeffs[2] = (3.0 * chord - 2.0 * t0 - t1) / L;
+            coeffs[3] = (t0 + t1 - 2.0 * chord) / (L * L);
+        };
+
+        hermite(m_x[segment], m_x[segment + 1], cos(m_heading[segment]), cos(m_heading[segment + 1]), p.cx);
+        hermite(m_y[segment], m_y[segment + 1], sin(m_heading[segment]), sin(m_heading[segment + 1]), p.cy);
+
+        return p;
+    }
+
+    void ReferencePath::_computeHeadings()
+    {
+        m_ownHeading.resize(m_count);
+
+        for (size_t i = 0; i < m_count; i++)
+        {
+            const size_t prev = i > 0 ? i - 1 : 0;
+            const size_t next = std::min(i + 1, m_count - 1);
+
+            m_ownHeading[i] = atan2(m_y[next] - m_y[prev], m_x[next] - m_x[prev]);
+        }
+
+        m_heading = m_ownHeading.data();
+    }
+
+    void ReferencePath::_buildIndex(double cellSize, double minX, double minY, double maxX, double maxY)
+    {
+        // Around one segment per cell for evenly spaced waypoints
+        m_cellSize = cellSize > 0.0 ? cellSize : 4.0 * length() / segments();
+
+        m_minX = minX;
+        m_minY = minY;
+        m_cellsX = static_cast<int64_t>((maxX - m_minX) / m_cellSize) + 1;
+        m_cellsY = static_cast<int64_t>((maxY - m_minY) / m_cellSize) + 1;
+
+        // Each segment goes into all cells its bounding box touches
+        std::vector<std::pair<uint64_t, uint32_t>> entries;
+        entries.reserve(2 * segments());
+
+        const auto cell = [this](double v, double min) {
+            return static_cast<int64_t>((v - min) / m_cellSize);
+        };
+
+        for (size_t k = 0; k < segments(); k++)
+        {
+            const int64_t x0 = cell(std::min(m_x[k], m_x[k + 1]), m_minX);
+            const int64_t x1 = cell(std::max(m_x[k], m_x[k + 1]), m_minX);
+            const int64_t y0 = cell(std::min(m_y[k], m_y[k + 1]), m_minY);
+            const int64_t y1 = cell(std::max(m_y[k], m_y[k + 1]), m_minY);
+
+            for (int64_t cy = y0; cy <= y1; cy++)
+                for (int64_t cx = x0; cx <= x1; cx++)
+                    entries.emplace_back(_cellKey(cx, cy), static_cast<uint32_t>(k));
+        }
+
+        std::sort(entries.begin(), entries.end());
+
+        m_cellSegments.reserve(entries.size());
+
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            if (i == 0 || entries[i].first != entries[i - 1].first)
+            {
+                m_cellKeys.push_back(entries[i].first);
+                m_cellStart.push_back(i);
+            }
+
+            m_cellSegments.push_back(entries[i].second);
+        }
+
+        m_cellStart.push_back(entries.size());
+    }
+
+    uint64_t ReferencePath::_cellKey(int64_t cx, int64_t cy) const
+    {
+        return static_cast<uint64_t>(cy) * static_cast<uint64_t>(m_cellsX) + static_cast<uint64_t>(cx);
+    }
+
+    void ReferencePath::_searchCell(int64_t cx, int64_t cy, double px, double py, Projection &best) const
+    {
+        if (cx < 0 || cy < 0 || cx >= m_cellsX || cy >= m_cellsY)
+            return;
+
+        const auto it = std::lower_bound(m_cellKeys.begin(), m_cellKeys.end(), _cellKey(cx, cy));
+
+        if (it == m_cellKeys.end() || *it != _cellKey(cx, cy))
+            return;
+
+        const size_t cell = it - m_cellKeys.begin();
+
+        for (size_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++)
+        {
+            const Projection candidate = project(m_cellSegments[i], px, py);
+
+            if (candidate.distance < best.distance)
+                best = candidate;
+        }
+    }
+} // namespace model
@@ -0,0 +1,307 @@
+#include "model/route_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t ROUTE_MAGIC = 0x54524E47; // "GNRT"
+static const uint32_t ROUTE_VERSION = 1;
+
+static_assert(sizeof(model::RouteFile::Header) == 64, "Route header layout changed, existing routes would be misread");
+
+/**
+ * Parse a CSV row of up to four numbers
+ * 
+ * @param line: The row
+ * @param values: Parsed values
+ * 
+ * @return Number of values parsed, 0 for rows that do not start with a number
+ */
+static size_t parseRow(const std::string &line, double values[4])
+{
+    const char *cursor = line.c_str();
+    size_t count = 0;
+
+    while (count < 4)
+    {
+        char *end = nullptr;
+        const double value = strtod(cursor, &end);
+
+        if (end == cursor)
+            break;
+
+        values[count++] = value;
+        cursor = end;
+
+        while (*cursor == ' ' || *cursor == '\t')
+            cursor++;
+
+        if (*cursor != ',')
+            break;
+
+        cursor++;
+    }
+
+    return count >= 2 ? count : 0;
+}
+
+namespace model
+{
+    RouteFile::RouteFile(const std::string &filepath) : m_mapping(nullptr), m_mappingSize(0)
+    {
+        const int fd = ::open(filepath.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not open route file " << filepath << std::endl);
+            return;
+        }
+
+        struct stat st;
+        ::fstat(fd, &st);
+
+        const size_t fileSize = static_cast<size_t>(st.st_size);
+
+        if (fileSize >= sizeof(Header))
+        {
+            void *mapping = ::mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+
+            if (mapping != MAP_FAILED)
+            {
+                m_mapping = mapping;
+                m_mappingSize = fileSize;
+            }
+        }
+
+        // The mapping stays valid without the descriptor
+        ::close(fd);
+
+        if (m_mapping == nullptr)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not map route file " << filepath << std::endl);
+            return;
+        }
+
+        const Header &h = header();
+        const size_t fields = (h.flags & HAS_ARC_LENGTH) ? 5 : 4;
+
+        // The count is bounded before it is multiplied, a huge count must not wrap around to the file size
+        if (h.magic != ROUTE_MAGIC || h.version != ROUTE_VERSION ||
+            h.count > (fileSize - sizeof(Header)) / (fields * sizeof(double)) ||
+            fileSize != sizeof(Header) + fields * h.count * sizeof(double))
+        {
+            CONSOLE_LOG("[ ERROR ]: " << filepath << " is not a valid route file" << std::endl);
+            _unmap();
+            return;
+        }
+
+        // Waypoints are mostly visited in order
+        ::madvise(m_mapping, m_mappingSize, MADV_SEQUENTIAL);
+
+        // A repeated waypoint is a segment of zero length, which no projection can handle
+        const double *px = x(), *py = y();
+
+        for (size_t i = 1; i < h.count; i++)
+        {
+            if (px[i] == px[i - 1] && py[i] == py[i - 1])
+            {
+                CONSOLE_LOG("[ ERROR ]: " << filepath << " repeats waypoint " << i - 1 << ", convert it again" << std::endl);
+                _unmap();
+                return;
+            }
+        }
+    }
+
+    RouteFile::~RouteFile()
+    {
+        if (m_mapping != nullptr)
+            ::munmap(m_mapping, m_mappingSize);
+    }
+
+    bool RouteFile::isOpen() const
+    {
+        return m_mapping != nullptr;
+    }
+
+    size_t RouteFile::size() const
+    {
+        return isOpen() ? header().count : 0;
+    }
+
+    const RouteFile::Header &RouteFile::header() const
+    {
+        return *static_cast<const Header *>(m_mapping);
+    }
+
+    const double *RouteFile::x() const
+    {
+        return _array(0);
+    }
+
+    const double *RouteFile::y() const
+    {
+        return _array(1);
+    }
+
+    const double *RouteFile::heading() const
+    {
+        return _array(2);
+    }
+
+    const double *RouteFile::speed() const
+    {
+        return _array(3);
+    }
+
+    const double *RouteFile::arcLength() const
+    {
+        return (isOpen() && (header().flags & HAS_ARC_LENGTH)) ? _array(4) : nullptr;
+    }
+
+    const double *RouteFile::_array(size_t field) const
+    {
+        if (!isOpen())
+            return nullptr;
+
+        const auto *data = reinterpret_cast<const double *>(static_cast<const char *>(m_mapping) + sizeof(Header));
+
+        return data + field * header().count;
+    }
+
+    void RouteFile::_unmap()
+    {
+        ::munmap(m_mapping, m_mappingSize);
+        m_mapping = nullptr;
+        m_mappingSize = 0;
+    }
+
+    size_t RouteFile::convertCsv(const std::string &csvPath, const std::string &routePath)
+    {
+        std::ifstream csv(csvPath);
+
+        if (!csv.is_open())
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not open " << csvPath << std::endl);
+            return 0;
+        }
+
+        Header h;
+        std::memset(&h, 0, sizeof(h));
+        h.magic = ROUTE_MAGIC;
+        h.version = ROUTE_VERSION;
+        h.flags = HAS_ARC_LENGTH;
+        h.minX = h.minY = INFINITY;
+        h.maxX = h.maxY = -INFINITY;
+
+        std::string line;
+        double values[4];
+        double prevX = NAN, prevY = NAN;
+
+        // First pass, count the waypoints and find the bounds
+        while (std::getline(csv, line))
+        {
+            if (parseRow(line, values) == 0 || (values[0] == prevX && values[1] == prevY))
+                continue;
+
+            prevX = values[0];
+            prevY = values[1];
+
+            h.count++;
+            h.minX = std::min(h.minX, values[0]);
+            h.minY = std::min(h.minY, values[1]);
+            h.maxX = std::max(h.maxX, values[0]);
+            h.maxY = std::max(h.maxY, values[1]);
+        }
+
+        if (h.count < 2)
+        {
+            CONSOLE_LOG("[ ERROR ]: " << csvPath << " has less than two distinct waypoints" << std::endl);
+            return 0;
+        }
+
+        const std::string tmpPath = routePath + ".tmp";
+        const size_t fileSize = sizeof(Header) + 5 * h.count * sizeof(double);
+
+        const int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (fd < 0 || ::ftruncate(fd, fileSize) != 0)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not create " << tmpPath << std::endl);
+
+            if (fd >= 0)
+                ::close(fd);
+
+            return 0;
+        }
+
+        void *mapping = ::mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (mapping == MAP_FAILED)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not map " << tmpPath << std::endl);
+            ::unlink(tmpPath.c_str());
+            return 0;
+        }
+
+        std::memcpy(mapping, &h, sizeof(h));
+
+        double *x = reinterpret_cast<double *>(static_cast<char *>(mapping) + sizeof(Header));
+        double *y = x + h.count;
+        double *heading = y + h.count;
+        double *speed = heading + h.count;
+        double *s = speed + h.count;
+
+        // Second pass, fill the arrays
+        csv.clear();
+        csv.seekg(0);
+
+        size_t i = 0;
+        bool headingMissing = false;
+
+        while (std::getline(csv, line) && i < h.count)
+        {
+            const size_t n = parseRow(line, values);
+
+            if (n == 0 || (i > 0 && values[0] == x[i - 1] && values[1] == y[i - 1]))
+                continue;
+
+            x[i] = values[0];
+            y[i] = values[1];
+            speed[i] = n > 3 ? values[3] : 0.0;
+            s[i] = i > 0 ? s[i - 1] + hypot(x[i] - x[i - 1], y[i] - y[i - 1]) : 0.0;
+
+            if (i > 0 && headingMissing)
+                heading[i - 1] = atan2(y[i] - y[i - 1], x[i] - x[i - 1]);
+
+            headingMissing = n < 3;
+
+            if (!headingMissing)
+                heading[i] = values[2];
+
+            i++;
+        }
+
+        if (headingMissing)
+            heading[h.count - 1] = atan2(y[h.count - 1] - y[h.count - 2], x[h.count - 1] - x[h.count - 2]);
+
+        const bool ok = ::msync(mapping, fileSize, MS_SYNC) == 0;
+        ::munmap(mapping, fileSize);
+
+        if (!ok || std::rename(tmpPath.c_str(), routePath.c_str()) != 0)
+        {
+            CONSOLE_LOG("[ ERROR ]: Could not write " << routePath << std::endl);
+            ::unlink(tmpPath.c_str());
+            return 0;
+        }
+
+        return h.count;
+    }
+} // namespace model
@@ -0,0 +1,90 @@
+#include "mpc_lib/event_trigger.h"
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+    std::atomic<uint64_t> s_skipped(0);
+} // namespace
+
+namespace mpc
+{
+    EventTrigger::EventTrigger()
+        : m_enabled(false), m_tolerance{0.0, 0.0, 0.0}, m_valid(false), m_step(0), m_px(0.0), m_py(0.0), m_theta(0.0)
+    {
+    }
+
+    EventTrigger::EventTrigger(const Tolerance &tolerance) : EventTrigger()
+    {
+        m_enabled = true;
+        m_tolerance = tolerance;
+    }
+
+    bool EventTrigger::enabled() const
+    {
+        return m_enabled;
+    }
+
+    void EventTrigger::reset()
+    {
+        m_valid = false;
+    }
+
+    Plan &EventTrigger::plan()
+    {
+        return m_plan;
+    }
+
+    void EventTrigger::accept(const SolveStats &stats, double px, double py, double theta)
+    {
+        m_valid = m_enabled && stats.success() && !m_plan.omega.empty();
+        m_step = 0;
+        m_px = px;
+        m_py = py;
+        m_theta = theta;
+    }
+
+    bool EventTrigger::follow(double x, double y, double theta, double v, double &omega, double &acc)
+    {
+        if (!m_valid)
+            return false;
+
+        const size_t k = ++m_step;
+
+        // Out of controls
+        if (k >= m_plan.omega.size())
+        {
+            m_valid = false;
+            return false;
+        }
+
+        // Into the frame of the plan
+        const double dx = x - m_px;
+        const double dy = y - m_py;
+        const double planX = dx * cos(-m_theta) - dy * sin(-m_theta);
+        const double planY = dx * sin(-m_theta) + dy * cos(-m_theta);
+
+        // Headings wrap around, a robot turning across +-pi is still on the plan
+        const bool onPlan = hypot(planX - m_plan.x[k], planY - m_plan.y[k]) <= m_tolerance.position &&
+                            fabs(remainder(theta - m_theta - m_plan.theta[k], 2 * M_PI)) <= m_tolerance.heading &&
+                            fabs(v - m_plan.v[k]) <= m_tolerance.velocity;
+
+        if (!onPlan)
+        {
+            m_valid = false;
+            return false;
+        }
+
+        omega = m_plan.omega[k];
+        acc = m_plan.acc[k];
+
+        s_skipped.fetch_add(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    uint64_t EventTrigger::skippedTotal()
+    {
+        return s_skipped.load(std::memory_order_relaxed);
+    }
+} // namespace mpc
@@ -0,0 +1,68 @@
+#include "mpc_lib/horizon_scheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace mpc
+{
+    HorizonScheduler::HorizonScheduler() : m_enabled(false), m_settings{0, 0, 0, 0.0, 0.0, 0.0, 1}, m_timesteps(0), m_effort(0.0)
+    {
+    }
+
+    HorizonScheduler::HorizonScheduler(const Settings &settings) : HorizonScheduler()
+    {
+        // The cost of the NLP differences consecutive controls, fewer than 3 timesteps leave none
+        if (settings.minTimesteps < 3 || settings.minTimesteps > settings.maxTimesteps)
+            throw std::invalid_argument("Adaptive horizon needs 3 <= min_timesteps <= max_timesteps");
+
+        if (settings.step == 0 || settings.blocking == 0)
+            throw std::invalid_argument("Adaptive horizon needs a step and move blocking of at least 1");
+
+        m_enabled = true;
+        m_settings = settings;
+
+        reset();
+    }
+
+    bool HorizonScheduler::enabled() const
+    {
+        return m_enabled;
+    }
+
+    void HorizonScheduler::reset()
+    {
+        // Rollouts start far off the path
+        m_timesteps = m_settings.maxTimesteps;
+        m_effort = 0.0;
+    }
+
+    void HorizonScheduler::schedule(Params &params) const
+    {
+        if (!m_enabled)
+            return;
+
+        params.forward.timesteps = m_timesteps;
+        params.forward.blocking = m_settings.blocking;
+    }
+
+    void HorizonScheduler::update(double cte, double etheta, double velError, const SolveStats &stats)
+    {
+        if (!m_enabled)
+            return;
+
+        if (!stats.skipped)
+            m_effort = m_effort > 0.0 ? m_effort + EFFORT_SMOOTHING * (stats.iterations - m_effort) : stats.iterations;
+
+        const double error = std::max({fabs(cte), fabs(etheta), fabs(velError)});
+
+        if (error < m_settings.shrinkError || m_effort > m_settings.maxIterations)
+            m_timesteps = m_timesteps >= m_settings.minTimesteps + m_settings.step ? m_timesteps - m_settings.step : m_settings.minTimesteps;
+        else if (error > m_settings.growError)
+            m_timesteps = std::min(m_timesteps + m_settings.step, m_settings.maxTimesteps);
+    }
+
+    size_t HorizonScheduler::timesteps() const
+    {
+        return m_timesteps;
+    }
+} // namespace mpc
@@ -1,17 +1,307 @@
 #include "mpc_lib/mpc.h"
+#include "mpc_lib/event_trigger.h"
+#include "mpc_lib/warm_start_cache.h"
+#include "utils/alloc_tracker.hpp"
+#include "utils/trace.hpp"
 #include <Eigen/QR>
+#include <atomic>
+#include <chrono>
+#include <coin/IpIpoptApplication.hpp>
+#include <coin/IpIpoptData.hpp>
 #include <cppad/ipopt/solve.hpp>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    /// Index of the calling thread for CppAD, 0 is the main thread
+    thread_local size_t t_threadNum = 0;
+
+    /// Set while solveBatch workers are running
+    std::atomic<bool> s_inParallel(false);
+
+    bool inParallel()
+    {
+        return s_inParallel;
+    }
+
+    size_t threadNum()
+    {
+        return t_threadNum;
+    }
+
+    /**
+     * Prepare CppAD for the given number of threads, must be called in sequential mode
+     * 
+     * @param threads: Number of threads that will record tapes at the same time
+     */
+    void setupParallel(size_t threads)
+    {
+        static size_t setupThreads = 1;
+
+        if (threads <= setupThreads)
+            return;
+
+        CppAD::thread_alloc::parallel_setup(threads, inParallel, threadNum);
+        CppAD::parallel_ad<double>();
+
+        setupThreads = threads;
+    }
+
+    /// Totals of every solve, see mpc::solverTotals()
+    std::atomic<uint64_t> s_solves(0);
+    std::atomic<uint64_t> s_failures(0);
+    std::atomic<uint64_t> s_iterations(0);
+    std::atomic<uint64_t> s_timesteps(0);
+    std::atomic<uint64_t> s_setups(0);
+    std::atomic<uint64_t> s_nanoseconds(0);
+
+    typedef CppAD::vector<double> Dvector;
+
+    /// Initial values and bounds of one NLP size, overwritten by every solve
+    struct Workspace
+    {
+        Dvector vars, varsLower, varsUpper;
+        Dvector constraintsLower, constraintsUpper;
+    };
+
+    /**
+     * Ipopt application and NLP buffers of the calling thread
+     * 
+     * Ipopt is initialized once per thread and the buffers are sized once per horizon and move blocking,
+     * so switching between horizons from one solve to the next sets nothing up again.
+     */
+    class SolverCache
+    {
+    public:
+        static SolverCache &local()
+        {
+            thread_local SolverCache cache;
+            return cache;
+        }
+
+        /**
+         * Get the Ipopt application, initialized on first use
+         * 
+         * @return The application, null if Ipopt failed to initialize
+         */
+        Ipopt::SmartPtr<Ipopt::IpoptApplication> app()
+        {
+            if (Ipopt::IsValid(m_app))
+                return m_app;
+
+            Ipopt::SmartPtr<Ipopt::IpoptApplication> app = new Ipopt::IpoptApplication();
+
+            app->Options()->SetIntegerValue("print_level", 0);
+            // Disables printing IPOPT creator banner
+            app->Options()->SetStringValue("sb", "yes");
+            // NOTE: Currently the solver has a maximum time limit of 0.5 seconds.
+            // Change this as you see fit.
+            app->Options()->SetNumericValue("max_cpu_time", 0.5);
+#if defined(IPOPT_VERSION_MAJOR) && (IPOPT_VERSION_MAJOR > 3 || IPOPT_VERSION_MINOR >= 14)
+            // Ipopt 3.14 only times the linear solver with this on, older versions always do and lack the option
+            app->Options()->SetStringValue("timing_statistics", "yes");
+#endif
+
+            if (app->Initialize() != Ipopt::Solve_Succeeded)
+                return Ipopt::SmartPtr<Ipopt::IpoptApplication>();
+
+            m_app = app;
+
+            return m_app;
+        }
+
+        /**
+         * Get the buffers of an NLP size
+         * 
+         * @param indices: Layout of the variables
+         * @param timesteps: Number of timesteps in the prediction horizon
+         * 
+         * @return Buffers sized for the NLP, holding the values of the last solve of that size
+         */
+        Workspace &workspace(const mpc::VarIndices &indices, size_t timesteps)
+        {
+            const auto found = m_workspaces.find({timesteps, indices.n_controls});
+
+            if (found != m_workspaces.end())
+                return found->second;
+
+            Workspace &workspace = m_workspaces[{timesteps, indices.n_controls}];
+            const size_t constraints = 6 * timesteps;
+
+            workspace.vars.resize(indices.n_vars);
+            workspace.varsLower.resize(indices.n_vars);
+            workspace.varsUpper.resize(indices.n_vars);
+            workspace.constraintsLower.resize(constraints);
+            workspace.constraintsUpper.resize(constraints);
+
+            s_setups++;
+
+            return workspace;
+        }
+
+        /// Release everything, the last NLP included, which the application holds on to
+        void clear()
+        {
+            m_app = Ipopt::SmartPtr<Ipopt::IpoptApplication>();
+            m_workspaces.clear();
+        }
+
+    private:
+        Ipopt::SmartPtr<Ipopt::IpoptApplication> m_app;
+        /// By timesteps and controls per actuator
+        std::map<std::pair<size_t, size_t>, Workspace> m_workspaces;
+    };
+
+    /// Adds the wall time of its lifetime to a total
+    class Stopwatch
+    {
+    public:
+        explicit Stopwatch(double &total) : m_total(total), m_start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~Stopwatch()
+        {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+            m_total += elapsed.count();
+        }
+
+    private:
+        double &m_total;
+        const std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * CppAD's Ipopt callback, timing the evaluation of the NLP functions and derivatives
+     */
+    template <typename Dvector, typename ADvector, typename FG_eval>
+    class TimedCallback : public CppAD::ipopt::solve_callback<Dvector, ADvector, FG_eval>
+    {
+        typedef CppAD::ipopt::solve_callback<Dvector, ADvector, FG_eval> Base;
+
+    public:
+        /**
+         * Constructor
+         * 
+         * @param evalSeconds: Total the evaluation time is added to
+         * @param args: Arguments of the solve_callback constructor
+         */
+        template <typename... Args>
+        TimedCallback(double &evalSeconds, Args &&...args) : Base(std::forward<Args>(args)...), m_evalSeconds(evalSeconds)
+        {
+        }
+
+        bool eval_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Number &obj_value) override
+        {
+            Stopwatch watch(m_evalSeconds);
+            return Base::eval_f(n, x, new_x, obj_value);
+        }
+
+        bool eval_grad_f(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Number *grad_f) override
+        {
+            Stopwatch watch(m_evalSeconds);
+            return Base::eval_grad_f(n, x, new_x, grad_f);
+        }
+
+        bool eval_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Index m, Ipopt::Number *g) override
+        {
+            Stopwatch watch(m_evalSeconds);
+            return Base::eval_g(n, x, new_x, m, g);
+        }
+
+        bool eval_jac_g(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Index m, Ipopt::Index nele_jac,
+                        Ipopt::Index *iRow, Ipopt::Index *jCol, Ipopt::Number *values) override
+        {
+            Stopwatch watch(m_evalSeconds);
+            return Base::eval_jac_g(n, x, new_x, m, nele_jac, iRow, jCol, values);
+        }
+
+        bool eval_h(Ipopt::Index n, const Ipopt::Number *x, bool new_x, Ipopt::Number obj_factor, Ipopt::Index m,
+                    const Ipopt::Number *lambda, bool new_lambda, Ipopt::Index nele_hess, Ipopt::Index *iRow,
+                    Ipopt::Index *jCol, Ipopt::Number *values) override
+        {
+            Stopwatch watch(m_evalSeconds);
+            return Base::eval_h(n, x, new_x, obj_factor, m, lambda, new_lambda, nele_hess, iRow, jCol, values);
+        }
+
+    private:
+        double &m_evalSeconds;
+    };
+
+    /**
+     * Solve an NLP with Ipopt, as CppAD::ipopt::solve does
+     * 
+     * CppAD::ipopt::solve drops the Ipopt application and with it the solve statistics. This sets
+     * up the same callback on the application of the thread's SolverCache instead.
+     * 
+     * @param xi: Initial value of the variables
+     * @param xl, xu: Bounds of the variables
+     * @param gl, gu: Bounds of the constraints
+     * @param fg_eval: Objective and constraints, as for CppAD::ipopt::solve
+     * @param solution: Receives the solution
+     * @param stats: Receives iterations, evaluation and linear solver time
+     */
+    template <typename Dvector, typename FG_eval>
+    void optimize(const Dvector &xi, const Dvector &xl, const Dvector &xu, const Dvector &gl, const Dvector &gu,
+                  FG_eval &fg_eval, CppAD::ipopt::solve_result<Dvector> &solution, mpc::SolveStats &stats)
+    {
+        TRACE_SCOPE("Ipopt");
+        ALLOC_SCOPE("Ipopt");
+
+        typedef typename FG_eval::ADvector ADvector;
+
+        Ipopt::SmartPtr<Ipopt::IpoptApplication> app = SolverCache::local().app();
+
+        if (!Ipopt::IsValid(app))
+        {
+            solution.status = CppAD::ipopt::solve_result<Dvector>::unknown;
+            return;
+        }
+
+        // NOTE: Sparse forward and reverse mode allow the solver to take advantage of sparse
+        // routines, this makes the computation MUCH FASTER. The tape is recorded once.
+        const bool retape = false;
+        const bool sparseForward = true;
+        const bool sparseReverse = true;
+
+        Ipopt::SmartPtr<Ipopt::TNLP> nlp = new TimedCallback<Dvector, ADvector, FG_eval>(
+            stats.evalSeconds, 1, xi.size(), gl.size(), xi, xl, xu, gl, gu, fg_eval, retape, sparseForward,
+            sparseReverse, solution);
+
+        app->OptimizeTNLP(nlp);
+
+        Ipopt::SmartPtr<Ipopt::SolveStatistics> statistics = app->Statistics();
+
+        if (Ipopt::IsValid(statistics))
+            stats.iterations = statistics->IterationCount();
+
+        // Real times on every Ipopt version, SolverCache::app() turns timing_statistics on from 3.14
+        Ipopt::SmartPtr<Ipopt::IpoptData> data = app->IpoptDataObject();
+
+        if (Ipopt::IsValid(data))
+        {
+            Ipopt::TimingStatistics &timing = data->TimingStats();
+
+            stats.linearSolverSeconds = timing.LinearSystemFactorization().TotalWallclockTime() +
+                                        timing.LinearSystemBackSolve().TotalWallclockTime();
+        }
+    }
+} // namespace
 
 namespace mpc::utils
 {
     double polyeval(const Eigen::VectorXd &coeffs, double x)
     {
-        double result = 0.0;
-
-        for (int i = 0; i < coeffs.size(); i++)
-            result += coeffs[i] * pow(x, i);
+        return horner(coeffs, x);
+    }
 
-        return result;
+    double polyderiv(const Eigen::VectorXd &coeffs, double x)
+    {
+        return hornerDerivative(coeffs, x);
     }
 
     Eigen::VectorXd polyfit(const Eigen::VectorXd &xvals, const Eigen::VectorXd &yvals, int order)
@@ -56,8 +346,11 @@ namespace mpc
     {
     }
 
-    VarIndices::VarIndices(size_t timesteps)
+    VarIndices::VarIndices(size_t timesteps, size_t blocking) : blocking(std::max<size_t>(blocking, 1))
     {
+          // One control per block of steps, the last block may be shorter
+          n_controls = (timesteps - 1 + this->blocking - 1) / this->blocking;
+
           x_start = 0;
           y_start = x_start + timesteps;
           theta_start = y_start + timesteps;
@@ -65,12 +358,13 @@ namespace mpc
           cte_start = v_start + timesteps;
           etheta_start = cte_start + timesteps;
           omega_start = etheta_start + timesteps;
-          acc_start = omega_start + timesteps - 1;
+          acc_start = omega_start + n_controls;
+          n_vars = acc_start + n_controls;
     }
 
     MPC::MPC(const Params &params, const Eigen::VectorXd &coeffs) : m_Params(params),
                                                                     m_Coeffs(coeffs),
-                                                                    m_VarIndices(params.forward.timesteps)
+                                                                    m_VarIndices(params.forward.timesteps, params.forward.blocking)
     {
     }
 
@@ -80,6 +374,9 @@ namespace mpc
 
     void MPC::operator()(ADvector &fg, const ADvector &vars) const
     {
+        TRACE_SCOPE("MPC::tape");
+        ALLOC_SCOPE("MPC::tape");
+
         // `fg` a vector of the cost constraints, `vars` is a vector of variable values (state & actuators)
 
         // The cost is stored is the first element of `fg`.
@@ -93,16 +390,17 @@ namespace mpc
             fg[0] += m_Params.weights.etheta * CppAD::pow(vars[m_VarIndices.etheta_start + t] - m_Params.desired.etheta, 2);
             fg[0] += m_Params.weights.vel * CppAD::pow(vars[m_VarIndices.v_start + t] - m_Params.desired.vel, 2);
         }
+        // Controls are costed per step, a control held over a block of steps counts once for every step
         for (size_t t = 0; t < m_Params.forward.timesteps - 1; t++)
         {
-            fg[0] += m_Params.weights.omega * CppAD::pow(vars[m_VarIndices.omega_start + t], 2);
-            fg[0] += m_Params.weights.acc * CppAD::pow(vars[m_VarIndices.acc_start + t], 2);
+            fg[0] += m_Params.weights.omega * CppAD::pow(vars[m_VarIndices.omega_start + m_VarIndices.control(t)], 2);
+            fg[0] += m_Params.weights.acc * CppAD::pow(vars[m_VarIndices.acc_start + m_VarIndices.control(t)], 2);
         }
-        // Smoother transitions (less jerks)
-        for (size_t t = 0; t < m_Params.forward.timesteps - 2; t++)
+        // Smoother transitions (less jerks), only changes between blocks remain with move blocking
+        for (size_t c = 0; c + 1 < m_VarIndices.n_controls; c++)
         {
-            fg[0] += m_Params.weights.acc_d * CppAD::pow(vars[m_VarIndices.acc_start + t + 1] - vars[m_VarIndices.acc_start + t], 2);
-            fg[0] += m_Params.weights.omega_d * CppAD::pow(vars[m_VarIndices.omega_start + t + 1] - vars[m_VarIndices.omega_start + t], 2);
+            fg[0] += m_Params.weights.acc_d * CppAD::pow(vars[m_VarIndices.acc_start + c + 1] - vars[m_VarIndices.acc_start + c], 2);
+            fg[0] += m_Params.weights.omega_d * CppAD::pow(vars[m_VarIndices.omega_start + c + 1] - vars[m_VarIndices.omega_start + c], 2);
         }
         //
         // Setup Constraints
@@ -140,19 +438,12 @@ namespace mpc
             CppAD::AD<double> cte0 = vars[m_VarIndices.cte_start + t];
             CppAD::AD<double> etheta0 = vars[m_VarIndices.etheta_start + t];
 
-            CppAD::AD<double> w0 = vars[m_VarIndices.omega_start + t];
-            CppAD::AD<double> a0 = vars[m_VarIndices.acc_start + t];
+            CppAD::AD<double> w0 = vars[m_VarIndices.omega_start + m_VarIndices.control(t)];
+            CppAD::AD<double> a0 = vars[m_VarIndices.acc_start + m_VarIndices.control(t)];
 
-            CppAD::AD<double> f0 = 0.0;
-            // CppAD::pow() takes second parameter as const int&, putting counter datatype as size_t throws error
-            for (int i = 0; i < m_Coeffs.size(); i++)
-                f0 += m_Coeffs[i] * CppAD::pow(x0, i);
-
-            CppAD::AD<double> traj_grad0 = 0.0;
-            for (int i = 1; i < m_Coeffs.size(); i++)
-                traj_grad0 += i * m_Coeffs[i] * CppAD::pow(x0, i - 1);
-
-            traj_grad0 = CppAD::atan(traj_grad0);
+            // Horner's scheme records a multiply and an add per coefficient instead of a pow
+            CppAD::AD<double> f0 = utils::horner(m_Coeffs, x0);
+            CppAD::AD<double> traj_grad0 = CppAD::atan(utils::hornerDerivative(m_Coeffs, x0));
 
             // The idea here is to constraint this value to be 0.
             //
@@ -170,10 +461,12 @@ namespace mpc
         }
     }
 
-    std::vector<double> MPC::solve(Eigen::VectorXd &state)
+    std::vector<double> MPC::solve(Eigen::VectorXd &state, Plan *plan)
     {
+        TRACE_SCOPE("MPC::solve");
+        ALLOC_SCOPE("MPC::solve");
+
         bool ok = true;
-        typedef CppAD::vector<double> Dvector;
 
         const double x = state[0];
         const double y = state[1];
@@ -182,24 +475,36 @@ namespace mpc
         const double cte = state[4];
         const double etheta = state[5];
 
-        const size_t n_vars = 6 * m_Params.forward.timesteps + 2 * (m_Params.forward.timesteps - 1);
+        const size_t n_vars = m_VarIndices.n_vars;
         const size_t n_constraints = 6 * m_Params.forward.timesteps;
 
+        // Buffers of this horizon, every value is overwritten below
+        Workspace &workspace = SolverCache::local().workspace(m_VarIndices, m_Params.forward.timesteps);
+
+        Dvector &vars = workspace.vars;
+
+        const auto setInitialState = [&]() {
+            vars[m_VarIndices.x_start] = x;
+            vars[m_VarIndices.y_start] = y;
+            vars[m_VarIndices.theta_start] = theta;
+            vars[m_VarIndices.v_start] = v;
+            vars[m_VarIndices.cte_start] = cte;
+            vars[m_VarIndices.etheta_start] = etheta;
+        };
+
         // Initial value of the independent variables.
         // SHOULD BE 0 besides initial state.
-        Dvector vars(n_vars);
-        for (size_t i = 0; i < n_vars; i++)
-            vars[i] = 0;
+        const auto coldStart = [&]() {
+            for (size_t i = 0; i < n_vars; i++)
+                vars[i] = 0;
 
-        vars[m_VarIndices.x_start] = x;
-        vars[m_VarIndices.y_start] = y;
-        vars[m_VarIndices.theta_start] = theta;
-        vars[m_VarIndices.v_start] = v;
-        vars[m_VarIndices.cte_start] = cte;
-        vars[m_VarIndices.etheta_start] = etheta;
+            setInitialState();
+        };
 
-        Dvector vars_lowerbound(n_vars);
-        Dvector vars_upperbound(n_vars);
+        coldStart();
+
+        Dvector &vars_lowerbound = workspace.varsLower;
+        Dvector &vars_upperbound = workspace.varsUpper;
 
         for (size_t i = 0; i < m_VarIndices.omega_start; i++)
         {
@@ -217,8 +522,8 @@ namespace mpc
             vars_upperbound[i] = m_Params.limits.throttle.max;
         }
 
-        Dvector constraints_lowerbound(n_constraints);
-        Dvector constraints_upperbound(n_constraints);
+        Dvector &constraints_lowerbound = workspace.constraintsLower;
+        Dvector &constraints_upperbound = workspace.constraintsUpper;
 
         for (size_t i = 0; i < n_constraints; i++)
         {
@@ -239,31 +544,74 @@ namespace mpc
         constraints_upperbound[m_VarIndices.cte_start] = cte;
         constraints_upperbound[m_VarIndices.etheta_start] = etheta;
 
-        std::string options;
-
-        // Uncomment this if you'd like more print information
-        options += "Integer print_level  0\n";
-        // NOTE: Setting sparse to true allows the solver to take advantage
-        // of sparse routines, this makes the computation MUCH FASTER. If you
-        // can uncomment 1 of these and see if it makes a difference or not but
-        // if you uncomment both the computation time should go up in orders of
-        // magnitude.
-        options += "String  sb          yes\n"; // Disables printing IPOPT creator banner
-        options += "Sparse  true        forward\n";
-        options += "Sparse  true        reverse\n";
-        // NOTE: Currently the solver has a maximum time limit of 0.5 seconds.
-        // Change this as you see fit.
-        options += "Numeric max_cpu_time          0.5\n";
-
         // place to return solution
         CppAD::ipopt::solve_result<Dvector> solution;
 
-        CppAD::ipopt::solve(
-            options, vars, vars_lowerbound, vars_upperbound, constraints_lowerbound,
-            constraints_upperbound, *this, solution);
+        m_stats = SolveStats();
+
+        const alloc::Counts allocStart = alloc::local();
+        const auto start = std::chrono::steady_clock::now();
+
+        WarmStartCache::Key key{};
+        bool fallback = false;
+
+        // Start from the solution of the nearest earlier NLP, inside the bounds and from this initial state
+        if (m_warmStart)
+        {
+            key = WarmStartCache::key(state, m_Coeffs, m_Params.weights);
+            m_stats.warmStarted = m_warmStart->lookup(key, m_Params.forward.timesteps, &vars[0], n_vars);
+
+            if (m_stats.warmStarted)
+            {
+                for (size_t i = 0; i < n_vars; i++)
+                    vars[i] = std::min(std::max(vars[i], vars_lowerbound[i]), vars_upperbound[i]);
+
+                setInitialState();
+            }
+        }
+
+        optimize(vars, vars_lowerbound, vars_upperbound, constraints_lowerbound, constraints_upperbound, *this,
+                 solution, m_stats);
+
+        // A warm start must never cost a solution, solve again as without the cache
+        if (m_stats.warmStarted && solution.status != CppAD::ipopt::solve_result<Dvector>::success)
+        {
+            const SolveStats warm = m_stats;
+            fallback = true;
+
+            coldStart();
+            solution = CppAD::ipopt::solve_result<Dvector>();
+
+            optimize(vars, vars_lowerbound, vars_upperbound, constraints_lowerbound, constraints_upperbound, *this,
+                     solution, m_stats);
+
+            m_stats.iterations += warm.iterations;
+            m_stats.linearSolverSeconds += warm.linearSolverSeconds;
+        }
+
+        const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
 
         ok &= solution.status == CppAD::ipopt::solve_result<Dvector>::success;
 
+        m_stats.status = static_cast<int>(solution.status);
+        m_stats.seconds = elapsed.count() * 1e-9;
+        m_stats.allocations = (alloc::local() - allocStart).allocations;
+        m_stats.timesteps = m_Params.forward.timesteps;
+
+        s_solves++;
+        s_failures += !ok;
+        s_iterations += m_stats.iterations;
+        s_timesteps += m_stats.timesteps;
+        s_nanoseconds += elapsed.count();
+
+        if (m_warmStart)
+        {
+            m_warmStart->record(m_stats, fallback);
+
+            if (ok)
+                m_warmStart->insert(key, m_Params.forward.timesteps, &solution.x[0], n_vars);
+        }
+
         if (!ok)
             DEBUG_LOG("IPOPT returned unsuccessful solve. Code: " << static_cast<size_t>(solution.status));
 
@@ -279,6 +627,26 @@ namespace mpc
         result.push_back(solution.x[m_VarIndices.acc_start]);
         result.push_back(solution.obj_value);
 
+        if (plan)
+        {
+            const size_t N = m_Params.forward.timesteps;
+
+            plan->x.assign(&solution.x[m_VarIndices.x_start], &solution.x[m_VarIndices.x_start] + N);
+            plan->y.assign(&solution.x[m_VarIndices.y_start], &solution.x[m_VarIndices.y_start] + N);
+            plan->theta.assign(&solution.x[m_VarIndices.theta_start], &solution.x[m_VarIndices.theta_start] + N);
+            plan->v.assign(&solution.x[m_VarIndices.v_start], &solution.x[m_VarIndices.v_start] + N);
+            plan->omega.resize(N - 1);
+            plan->acc.resize(N - 1);
+
+            for (size_t t = 0; t + 1 < N; t++)
+            {
+                plan->omega[t] = solution.x[m_VarIndices.omega_start + m_VarIndices.control(t)];
+                plan->acc[t] = solution.x[m_VarIndices.acc_start + m_VarIndices.control(t)];
+            }
+
+            plan->cost = solution.obj_value;
+        }
+
         // // Add "future" solutions (where MPC is going)
         // for (int i = 0; i < m_Params.forward.timesteps - 1; ++i)
         // {
@@ -288,4 +656,198 @@ namespace mpc
 
         return result;
     }
-} // namespace mpc
\ No newline at end of file
+
+    void MPC::setWarmStart(WarmStartCache *cache)
+    {
+        m_warmStart = cache;
+    }
+
+    const SolveStats &MPC::stats() const
+    {
+        return m_stats;
+    }
+
+    SolverTotals solverTotals()
+    {
+        SolverTotals totals;
+        totals.solves = s_solves;
+        totals.failures = s_failures;
+        totals.iterations = s_iterations;
+        totals.skipped = EventTrigger::skippedTotal();
+        totals.timesteps = s_timesteps;
+        totals.setups = s_setups;
+        totals.seconds = s_nanoseconds * 1e-9;
+
+        return totals;
+    }
+
+    std::string linearSolver()
+    {
+        Ipopt::SmartPtr<Ipopt::IpoptApplication> app = SolverCache::local().app();
+        std::string name;
+
+        if (Ipopt::IsValid(app))
+            app->Options()->GetStringValue("linear_solver", name, "");
+
+        return name;
+    }
+
+    bool threadSafeLinearSolver()
+    {
+        static const std::set<std::string> safe = {"ma27", "ma57", "ma77", "ma86", "ma97", "spral", "pardisomkl"};
+
+        return safe.count(linearSolver()) > 0;
+    }
+
+    SolverPool::SolverPool(size_t threads) : m_threads(std::max<size_t>(threads, 1))
+    {
+        if (m_threads == 1)
+            return;
+
+        if (!threadSafeLinearSolver())
+            throw std::invalid_argument("Solving on " + std::to_string(m_threads) + " threads needs a thread-safe linear solver, Ipopt uses " +
+                                        linearSolver() + ". Set linear_solver in ipopt.opt or use 1 thread");
+
+        static std::mutex setupMutex;
+        {
+            std::lock_guard<std::mutex> lock(setupMutex);
+            setupParallel(m_threads);
+        }
+
+        // The calling thread is worker 0
+        m_workers.reserve(m_threads - 1);
+        for (size_t id = 1; id < m_threads; id++)
+            m_workers.emplace_back(&SolverPool::_work, this, id);
+    }
+
+    SolverPool::~SolverPool()
+    {
+        if (m_workers.empty())
+            return;
+
+        // The workers free their CppAD memory on the way out, which needs parallel mode
+        s_inParallel = true;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_start.notify_all();
+
+        for (auto &worker : m_workers)
+            worker.join();
+
+        s_inParallel = false;
+    }
+
+    size_t SolverPool::threads() const
+    {
+        return m_threads;
+    }
+
+    void SolverPool::forEach(size_t count, const std::function<void(size_t)> &task)
+    {
+        if (m_workers.empty() || count <= 1)
+        {
+            for (size_t i = 0; i < count; i++)
+                task(i);
+
+            return;
+        }
+
+        s_inParallel = true;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &task;
+            m_count = count;
+            m_next = 0;
+            m_busy = m_workers.size();
+            m_batch++;
+        }
+
+        m_start.notify_all();
+
+        _drain();
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_done.wait(lock, [this]() { return m_busy == 0; });
+            m_task = nullptr;
+        }
+
+        s_inParallel = false;
+    }
+
+    void SolverPool::_work(size_t id)
+    {
+        t_threadNum = id;
+        uint64_t batch = 0;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_start.wait(lock, [this, batch]() { return m_stop || m_batch != batch; });
+
+                if (m_stop)
+                    break;
+
+                batch = m_batch;
+            }
+
+            _drain();
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                if (--m_busy == 0)
+                    m_done.notify_one();
+            }
+        }
+
+        SolverCache::local().clear();
+    }
+
+    void SolverPool::_drain()
+    {
+        for (size_t i = m_next++; i < m_count; i = m_next++)
+            (*m_task)(i);
+    }
+
+    std::vector<std::vector<double>> solveBatch(std::vector<Problem> &problems, SolverPool *pool, std::vector<SolveStats> *stats)
+    {
+        TRACE_SCOPE("solveBatch");
+
+        std::vector<std::vector<double>> results(problems.size());
+
+        if (stats)
+            stats->assign(problems.size(), SolveStats());
+
+        const auto solveOne = [&problems, &results, stats](size_t i) {
+            try
+            {
+                MPC _mpc(problems[i].params, problems[i].coeffs);
+                _mpc.setWarmStart(problems[i].warmStart);
+                results[i] = _mpc.solve(problems[i].state, problems[i].plan);
+
+                if (stats)
+                    (*stats)[i] = _mpc.stats();
+            }
+            catch (std::exception &e)
+            {
+                DEBUG_LOG("Error in batch solve: " << e.what());
+                results[i].clear();
+            }
+        };
+
+        if (pool)
+            pool->forEach(problems.size(), solveOne);
+        else
+            for (size_t i = 0; i < problems.size(); i++)
+                solveOne(i);
+
+        return results;
+    }
+} // namespace mpc
@@ -0,0 +1,116 @@
+#include "mpc_lib/solver_profile.h"
+
+namespace mpc
+{
+    SolverProfile::SolverProfile() : m_failures(0), m_skipped(0), m_timesteps(0), m_evalSeconds(0.0), m_linearSolverSeconds(0.0), m_allocations(0)
+    {
+    }
+
+    void SolverProfile::add(const SolveStats &stats)
+    {
+        if (stats.skipped)
+        {
+            m_skipped++;
+            return;
+        }
+
+        m_latency.record(static_cast<uint64_t>(stats.seconds * 1e9));
+        m_iterations.record(stats.iterations);
+        m_failures += !stats.success();
+        m_evalSeconds += stats.evalSeconds;
+        m_linearSolverSeconds += stats.linearSolverSeconds;
+        m_allocations += stats.allocations;
+        m_timesteps += stats.timesteps;
+    }
+
+    void SolverProfile::merge(const SolverProfile &other)
+    {
+        m_latency.merge(other.m_latency);
+        m_iterations.merge(other.m_iterations);
+        m_failures += other.m_failures;
+        m_skipped += other.m_skipped;
+        m_timesteps += other.m_timesteps;
+        m_evalSeconds += other.m_evalSeconds;
+        m_linearSolverSeconds += other.m_linearSolverSeconds;
+        m_allocations += other.m_allocations;
+    }
+
+    void SolverProfile::reset()
+    {
+        m_latency.reset();
+        m_iterations.reset();
+        m_failures = 0;
+        m_skipped = 0;
+        m_timesteps = 0;
+        m_evalSeconds = 0.0;
+        m_linearSolverSeconds = 0.0;
+        m_allocations = 0;
+    }
+
+    const HdrHistogram &SolverProfile::latency() const
+    {
+        return m_latency;
+    }
+
+    const HdrHistogram &SolverProfile::iterations() const
+    {
+        return m_iterations;
+    }
+
+    uint64_t SolverProfile::solves() const
+    {
+        return m_latency.count();
+    }
+
+    uint64_t SolverProfile::failures() const
+    {
+        return m_failures;
+    }
+
+    uint64_t SolverProfile::skipped() const
+    {
+        return m_skipped;
+    }
+
+    double SolverProfile::meanTimesteps() const
+    {
+        return solves() > 0 ? static_cast<double>(m_timesteps) / solves() : 0.0;
+    }
+
+    double SolverProfile::evalSeconds() const
+    {
+        return m_evalSeconds;
+    }
+
+    double SolverProfile::linearSolverSeconds() const
+    {
+        return m_linearSolverSeconds;
+    }
+
+    uint64_t SolverProfile::allocations() const
+    {
+        return m_allocations;
+    }
+
+    SolverSummary SolverProfile::summary() const
+    {
+        SolverSummary summary;
+
+        summary.solves = solves();
+        summary.failures = m_failures;
+
+        summary.latencyP50 = m_latency.percentile(50.0) * 1e-3;
+        summary.latencyP90 = m_latency.percentile(90.0) * 1e-3;
+        summary.latencyP99 = m_latency.percentile(99.0) * 1e-3;
+        summary.latencyMax = m_latency.max() * 1e-3;
+
+        summary.iterationsP50 = m_iterations.percentile(50.0);
+        summary.iterationsP99 = m_iterations.percentile(99.0);
+        summary.iterationsMax = m_iterations.max();
+
+        summary.evalSeconds = m_evalSeconds;
+        summary.linearSolverSeconds = m_linearSolverSeconds;
+
+        return summary;
+    }
+} // namespace mpc
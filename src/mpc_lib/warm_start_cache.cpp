@@ -0,0 +1,255 @@
+#include "mpc_lib/warm_start_cache.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /// Typical magnitudes of the state along a path: px, py, theta, v, cte and etheta
+    const double STATE_SCALE[] = {0.1, 0.1, 0.1, 0.1, 0.1, 0.1};
+    /// Typical magnitudes of the coefficients of the reference cubic, constant term first
+    const double COEFF_SCALE[] = {0.1, 0.1, 0.05, 0.01};
+
+    /// Entries searched one by one before the tree is built again, at least
+    const size_t MIN_PENDING = 32;
+} // namespace
+
+namespace mpc
+{
+    WarmStartCache::Stats WarmStartCache::Stats::operator-(const Stats &other) const
+    {
+        Stats diff;
+        diff.lookups = lookups - other.lookups;
+        diff.hits = hits - other.hits;
+        diff.fallbacks = fallbacks - other.fallbacks;
+        diff.coldSolves = coldSolves - other.coldSolves;
+        diff.coldIterations = coldIterations - other.coldIterations;
+        diff.warmSolves = warmSolves - other.warmSolves;
+        diff.warmIterations = warmIterations - other.warmIterations;
+
+        return diff;
+    }
+
+    double WarmStartCache::Stats::hitRate() const
+    {
+        return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+    }
+
+    double WarmStartCache::Stats::iterationsSaved() const
+    {
+        if (coldSolves == 0 || warmSolves == 0)
+            return 0.0;
+
+        const double coldMean = static_cast<double>(coldIterations) / coldSolves;
+
+        return coldMean * warmSolves - static_cast<double>(warmIterations);
+    }
+
+    WarmStartCache::WarmStartCache(size_t capacity, double radius) : m_capacity(std::max<size_t>(capacity, 1)), m_radius2(radius * radius)
+    {
+    }
+
+    WarmStartCache::Key WarmStartCache::key(const Eigen::VectorXd &state, const Eigen::VectorXd &coeffs, const Params::Weights &weights)
+    {
+        Key key;
+        size_t k = 0;
+
+        for (size_t i = 0; i < 6; i++)
+            key[k++] = state[i] / STATE_SCALE[i];
+
+        for (size_t i = 0; i < 4; i++)
+            key[k++] = i < static_cast<size_t>(coeffs.size()) ? coeffs[i] / COEFF_SCALE[i] : 0.0;
+
+        // A factor of 3 between two weights is a distance of 1
+        for (const double w : {weights.vel, weights.cte, weights.etheta, weights.omega, weights.acc, weights.omega_d, weights.acc_d})
+            key[k++] = log(std::max(w, 1e-9)) / log(3.0);
+
+        return key;
+    }
+
+    bool WarmStartCache::lookup(const Key &key, size_t timesteps, double *guess, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stats.lookups++;
+
+        const auto found = m_stores.find({timesteps, size});
+
+        if (found == m_stores.end())
+            return false;
+
+        const Store &store = found->second;
+
+        double best = m_radius2;
+        int64_t nearest = -1;
+
+        _search(store, key, 0, store.tree.size(), 0, best, nearest);
+
+        for (const uint32_t entry : store.pending)
+        {
+            const double d = _distance2(key, store.keys[entry]);
+
+            if (d < best)
+            {
+                best = d;
+                nearest = entry;
+            }
+        }
+
+        if (nearest < 0)
+            return false;
+
+        std::copy_n(&store.solutions[nearest * size], size, guess);
+        m_stats.hits++;
+
+        return true;
+    }
+
+    void WarmStartCache::insert(const Key &key, size_t timesteps, const double *solution, size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        Store &store = m_stores[{timesteps, size}];
+        uint32_t entry;
+
+        if (store.keys.size() < m_capacity)
+        {
+            entry = static_cast<uint32_t>(store.keys.size());
+
+            store.keys.push_back(key);
+            store.solutions.insert(store.solutions.end(), solution, solution + size);
+            store.stale.push_back(false);
+        }
+        else
+        {
+            // Replace the oldest
+            entry = static_cast<uint32_t>(store.next);
+            store.next = (store.next + 1) % m_capacity;
+
+            store.keys[entry] = key;
+            std::copy_n(solution, size, &store.solutions[entry * size]);
+        }
+
+        // Out of the tree until the next build
+        if (!store.stale[entry])
+        {
+            store.stale[entry] = true;
+            store.pending.push_back(entry);
+        }
+
+        if (store.pending.size() > std::max(MIN_PENDING, store.keys.size() / 8))
+            _build(store);
+    }
+
+    void WarmStartCache::record(const SolveStats &stats, bool fallback)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (stats.warmStarted)
+        {
+            m_stats.warmSolves++;
+            m_stats.warmIterations += stats.iterations;
+        }
+        else
+        {
+            m_stats.coldSolves++;
+            m_stats.coldIterations += stats.iterations;
+        }
+
+        m_stats.fallbacks += fallback;
+    }
+
+    WarmStartCache::Stats WarmStartCache::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    size_t WarmStartCache::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        size_t size = 0;
+        for (const auto &store : m_stores)
+            size += store.second.keys.size();
+
+        return size;
+    }
+
+    void WarmStartCache::_build(Store &store)
+    {
+        std::vector<uint32_t> entries(store.keys.size());
+        for (size_t i = 0; i < entries.size(); i++)
+            entries[i] = static_cast<uint32_t>(i);
+
+        store.tree.resize(entries.size());
+        _buildRange(store, entries, 0, entries.size(), 0);
+
+        store.pending.clear();
+        std::fill(store.stale.begin(), store.stale.end(), false);
+    }
+
+    void WarmStartCache::_buildRange(Store &store, std::vector<uint32_t> &entries, size_t lo, size_t hi, size_t depth)
+    {
+        if (lo >= hi)
+            return;
+
+        const size_t mid = lo + (hi - lo) / 2;
+        const size_t dim = depth % DIM;
+
+        std::nth_element(entries.begin() + lo, entries.begin() + mid, entries.begin() + hi,
+                         [&store, dim](uint32_t a, uint32_t b) { return store.keys[a][dim] < store.keys[b][dim]; });
+
+        store.tree[mid] = {entries[mid], store.keys[entries[mid]][dim]};
+
+        _buildRange(store, entries, lo, mid, depth + 1);
+        _buildRange(store, entries, mid + 1, hi, depth + 1);
+    }
+
+    void WarmStartCache::_search(const Store &store, const Key &key, size_t lo, size_t hi, size_t depth, double &best, int64_t &nearest) const
+    {
+        if (lo >= hi)
+            return;
+
+        const size_t mid = lo + (hi - lo) / 2;
+        const Node &node = store.tree[mid];
+
+        // Replaced entries are searched among the pending ones, their split still holds for the subtrees
+        if (!store.stale[node.entry])
+        {
+            const double d = _distance2(key, store.keys[node.entry]);
+
+            if (d < best)
+            {
+                best = d;
+                nearest = node.entry;
+            }
+        }
+
+        const double diff = key[depth % DIM] - node.split;
+
+        if (diff < 0.0)
+        {
+            _search(store, key, lo, mid, depth + 1, best, nearest);
+
+            if (diff * diff < best)
+                _search(store, key, mid + 1, hi, depth + 1, best, nearest);
+        }
+        else
+        {
+            _search(store, key, mid + 1, hi, depth + 1, best, nearest);
+
+            if (diff * diff < best)
+                _search(store, key, lo, mid, depth + 1, best, nearest);
+        }
+    }
+
+    double WarmStartCache::_distance2(const Key &a, const Key &b)
+    {
+        double d = 0.0;
+
+        for (size_t i = 0; i < DIM; i++)
+            d += (a[i] - b[i]) * (a[i] - b[i]);
+
+        return d;
+    }
+} // namespace mpc
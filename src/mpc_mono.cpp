@@ -1,4 +1,6 @@
 #include "model/base_organism.h"
+#include "utils/async_output.hpp"
+#include "utils/trace.hpp"
 
 static const auto mpcConfig = config::ConfigHandler<config::MONO>::getMpcConfig();
 
@@ -36,14 +38,30 @@ public:
         m_term.tolerance.vel = mpcConfig.teardown_tolerance.velocity;
         m_term.tolerance.cte = mpcConfig.teardown_tolerance.cross_track_error;
         m_term.tolerance.etheta = mpcConfig.teardown_tolerance.orientation_error;
+
+        if (mpcConfig.event_trigger.enabled)
+            setEventTrigger(mpc::EventTrigger({mpcConfig.event_trigger.position, mpcConfig.event_trigger.heading, mpcConfig.event_trigger.velocity}));
+
+        if (mpcConfig.adaptive_horizon.enabled)
+            setHorizonScheduler(mpc::HorizonScheduler({mpcConfig.adaptive_horizon.min_timesteps, mpcConfig.adaptive_horizon.max_timesteps,
+                                                       mpcConfig.adaptive_horizon.step, mpcConfig.adaptive_horizon.grow_error,
+                                                       mpcConfig.adaptive_horizon.shrink_error, mpcConfig.adaptive_horizon.max_iterations,
+                                                       mpcConfig.adaptive_horizon.move_blocking}));
+
+        if (mpcConfig.warm_start.enabled)
+            setWarmStartCache(std::make_shared<mpc::WarmStartCache>(mpcConfig.warm_start.capacity, mpcConfig.warm_start.radius));
     }
 
     void saveData()
     {
         std::string destn = "data/custom-weights.json";
 
-        m_jsonLogger.dump(destn);
-        CONSOLE_LOG(" -- Data saved to " << destn << "\n\n");
+        AsyncOutput::get().post([logger = m_jsonLogger, destn]() {
+            if (logger.dump(destn))
+                CONSOLE_LOG(" -- Data saved to " << destn << "\n\n");
+            else
+                CONSOLE_LOG("[ ERROR ]: Could not write " << destn << std::endl);
+        });
     }
 
     void run()
@@ -52,6 +70,34 @@ public:
 
         if (!ok)
             DEBUG_LOG("Control loop fail !");
+
+        const mpc::SolverProfile &profile = getSolverProfile();
+        const uint64_t steps = profile.solves() + profile.skipped();
+
+        // Time weighted cross track error, to compare runs with and without the event trigger
+        const model::Performance performance = getPerformance();
+        double itae = 0.0;
+        for (size_t i = 0; i < performance.cteData.size(); i++)
+            itae += (i + 1) * m_params.forward.dt * abs(performance.cteData[i]) * m_params.forward.dt;
+
+        CONSOLE_LOG(" -- Solves skipped by the event trigger: " << profile.skipped() << " of " << steps << " steps ("
+                                                                << (steps > 0 ? 100.0 * profile.skipped() / steps : 0.0) << " %)\n");
+        CONSOLE_LOG(" -- ITAE of the cross track error: " << itae << "\n");
+
+        // The NLP grows linearly with the horizon, so does the work per Ipopt iteration
+        const double fixed = static_cast<double>(m_params.forward.timesteps);
+        CONSOLE_LOG(" -- Mean horizon: " << profile.meanTimesteps() << " of " << fixed << " timesteps ("
+                                         << (profile.solves() > 0 ? 100.0 * (1.0 - profile.meanTimesteps() / fixed) : 0.0)
+                                         << " % smaller NLPs), solve time " << profile.latency().mean() * 1e-6 << " ms mean\n");
+
+        if (getWarmStartCache())
+        {
+            const mpc::WarmStartCache::Stats warm = getWarmStartCache()->stats();
+            CONSOLE_LOG(" -- Warm starts: " << 100.0 * warm.hitRate() << " % of " << warm.lookups << " solves, about "
+                                            << warm.iterationsSaved() << " Ipopt iterations saved, " << warm.fallbacks << " fallbacks\n");
+        }
+
+        CONSOLE_LOG("\n");
     }
 
 private:
@@ -74,8 +120,12 @@ int main(int argc, char **argv)
     Organism *organism = new Organism();
 
     organism->setModelInitState(s);
+    organism->setPath(model::ReferencePath::load(mpcConfig.reference.route_file));
     organism->run();
     organism->saveData();
 
     delete organism;
+
+    AsyncOutput::get().flush();
+    TRACE_DUMP("data/trace.json");
 }
\ No newline at end of file
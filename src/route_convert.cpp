@@ -0,0 +1,28 @@
+#include "model/reference_path.h"
+#include "model/route_file.h"
+
+int main(int argc, char **argv)
+{
+    // Usage: route_convert <waypoints.csv> <route.bin>
+    if (argc != 3)
+    {
+        CONSOLE_LOG("Usage: " << argv[0] << " <waypoints.csv> <route.bin>" << std::endl);
+        return 1;
+    }
+
+    const size_t count = model::RouteFile::convertCsv(argv[1], argv[2]);
+
+    if (count == 0)
+        return 1;
+
+    const auto route = std::make_shared<const model::RouteFile>(argv[2]);
+
+    if (!route->isOpen())
+        return 1;
+
+    const model::ReferencePath path(route);
+
+    CONSOLE_LOG(" -- " << count << " waypoints, " << path.length() << " m of route written to " << argv[2] << "\n");
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "utils/alloc_tracker.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Allocation functions feeding the counters of utils/alloc_tracker.hpp
+ *
+ * Not part of the library, link the gnt_alloc_hooks object library to count. With glibc malloc itself
+ * is interposed, since Eigen's aligned_malloc and the C parts of Ipopt never call operator new, which
+ * ends up in malloc there. Elsewhere the global operator new and delete are replaced.
+ */
+
+namespace
+{
+    const bool s_installed = (alloc::detail::s_hooked = true);
+} // namespace
+
+#ifdef __GLIBC__
+
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t n, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void *ptr);
+
+    void *malloc(size_t size)
+    {
+        alloc::onAllocation(size);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t n, size_t size)
+    {
+        alloc::onAllocation(n * size);
+        return __libc_calloc(n, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        if (ptr)
+            alloc::onFree();
+
+        if (size > 0 || !ptr)
+            alloc::onAllocation(size);
+
+        return __libc_realloc(ptr, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        alloc::onAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        alloc::onAllocation(size);
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void **ptr, size_t alignment, size_t size)
+    {
+        alloc::onAllocation(size);
+        *ptr = __libc_memalign(alignment, size);
+        return *ptr ? 0 : ENOMEM;
+    }
+
+    void free(void *ptr)
+    {
+        if (ptr)
+            alloc::onFree();
+
+        __libc_free(ptr);
+    }
+}
+
+#else
+
+// The array and nothrow forms forward to these
+void *operator new(std::size_t size)
+{
+    alloc::onAllocation(size);
+
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    alloc::onAllocation(size);
+
+    const size_t align = static_cast<size_t>(alignment);
+
+    // aligned_alloc wants a multiple of the alignment
+    if (void *ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr)
+        alloc::onFree();
+
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    if (ptr)
+        alloc::onFree();
+
+    std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include "primary.h"
+#include "genetic_algorithm/archive.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+
+static ga::core::Genome makeGenome(double w)
+{
+    ga::core::Genome genome;
+
+    for (size_t i = 0; i < 7; i++)
+        genome.addChoromosome(0.01, 100.0);
+
+    genome.encode({w, w, w, w, w, w, w});
+
+    return genome;
+}
+
+TEST(GaArchiveTestSuite, testPersistence)
+{
+    const std::string path = "test-archive.bin";
+    std::remove(path.c_str());
+
+    const ga::fitness::metrics_t metrics = {{1.0, 2.0, 3.0, 4.0, 5.0}};
+
+    {
+        ga::EvalArchive archive(path, 42);
+        ASSERT_TRUE(archive.isOpen());
+
+        archive.append(makeGenome(10.0), metrics, 100.0, 0.5);
+        archive.append(makeGenome(20.0), metrics, 200.0, 0.5);
+    }
+
+    // Simulate a crash in the middle of an append
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file << "partial";
+    }
+
+    {
+        ga::EvalArchive archive(path, 42);
+        EXPECT_EQ(archive.size(), 2u);
+
+        ga::fitness::metrics_t found;
+        EXPECT_TRUE(archive.lookup(makeGenome(10.0), found));
+        EXPECT_EQ(found, metrics);
+        EXPECT_FALSE(archive.lookup(makeGenome(30.0), found));
+
+        // Appends after the truncated tail must stay aligned
+        archive.append(makeGenome(30.0), metrics, 300.0, 0.5);
+        EXPECT_EQ(archive.hits(), 1u);
+        EXPECT_EQ(archive.lookups(), 2u);
+    }
+
+    {
+        ga::EvalArchive archive(path, 42);
+        EXPECT_EQ(archive.size(), 3u);
+
+        const auto seeds = archive.seeds(5, makeGenome(0.0));
+        EXPECT_EQ(seeds.size(), 3u);
+    }
+
+    // Evaluations of another configuration are not usable
+    {
+        ga::EvalArchive archive(path, 43);
+        EXPECT_EQ(archive.size(), 0u);
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST(GaArchiveTestSuite, testUnknownFormat)
+{
+    const std::string path = "test-archive-unknown.bin";
+    const std::string other = "ABCD" + std::string(100, '\0');
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << other;
+    }
+
+    // Records of another layout are neither read nor truncated
+    {
+        ga::EvalArchive archive(path, 42);
+        EXPECT_FALSE(archive.isOpen());
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(bytes, other);
+
+    std::remove(path.c_str());
+}
+
+TEST(GaArchiveTestSuite, testRouteInConfigHash)
+{
+    const std::string path = "test-archive-route.bin";
+
+    config::MPC_Controller_GA mpcConfig{};
+
+    const uint64_t xAxis = ga::EvalArchive::configHash(mpcConfig, 300, ga::fitness::SolverCost::NONE);
+
+    // Evaluations without the solver cost metrics are not usable once they are measured
+    EXPECT_NE(xAxis, ga::EvalArchive::configHash(mpcConfig, 300, ga::fitness::SolverCost::ITERATIONS));
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "route A";
+    }
+
+    mpcConfig.reference.route_file = path;
+    const uint64_t routeA = ga::EvalArchive::configHash(mpcConfig, 300, ga::fitness::SolverCost::NONE);
+
+    // Same path, edited in place
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "route B";
+    }
+
+    const uint64_t routeB = ga::EvalArchive::configHash(mpcConfig, 300, ga::fitness::SolverCost::NONE);
+
+    EXPECT_NE(xAxis, routeA);
+    EXPECT_NE(routeA, routeB);
+    EXPECT_EQ(routeB, ga::EvalArchive::configHash(mpcConfig, 300, ga::fitness::SolverCost::NONE));
+
+    std::remove(path.c_str());
+}
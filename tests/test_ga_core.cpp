@@ -1,7 +1,14 @@
 #include "genetic_algorithm/core.h"
+#include "genetic_algorithm/fitness.h"
+#include "genetic_algorithm/checkpoint.h"
+#include "genetic_algorithm/telemetry.h"
 #include "mpc_lib/mpc.h"
 
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <json/reader.h>
+#include <sstream>
 
 static ::testing::AssertionResult IsBetweenInclusive(double val, double a, double b)
 {
@@ -37,4 +44,217 @@ TEST(GaCoreTestSuite, testGenome)
     EXPECT_TRUE(IsBetweenInclusive(wDecoded.acc, 52.008, 52.01));
     EXPECT_TRUE(IsBetweenInclusive(wDecoded.omega_d, 99.999, 100.001));
     EXPECT_TRUE(IsBetweenInclusive(wDecoded.acc_d, 99.989, 99.991));
-}
\ No newline at end of file
+}
+
+TEST(GaCoreTestSuite, testRescoreFromMetrics)
+{
+    model::Performance performance;
+
+    for (size_t i = 0; i < 50; i++)
+    {
+        performance.cteData.push_back(1.0 / (i + 1));
+        performance.ethetaData.push_back(0.5 / (i + 1));
+        performance.velErrData.push_back(-0.5 + 0.01 * i);
+        performance.translationalEL.push_back(0.1 * (i % 7));
+        performance.rotationalEL.push_back(0.2 * (i % 3));
+    }
+
+    const ga::fitness::metrics_t metrics = ga::fitness::ObjFunction::getMetrics(performance);
+
+    EXPECT_DOUBLE_EQ(ga::fitness::ObjFunction::score(metrics), ga::fitness::ObjFunction::evaluate(performance));
+}
+
+TEST(GaCoreTestSuite, testSolverCostMetric)
+{
+    model::Performance performance;
+
+    for (size_t i = 0; i < 100; i++)
+    {
+        performance.cteData.push_back(1.0 / (i + 1));
+        performance.ethetaData.push_back(0.5 / (i + 1));
+        performance.velErrData.push_back(-0.5 + 0.01 * i);
+        performance.translationalEL.push_back(0.1 * (i % 7));
+        performance.rotationalEL.push_back(0.2 * (i % 3));
+        performance.solveIterations.push_back(100 - i);
+        performance.solveSeconds.push_back(1e-3);
+    }
+
+    // Left out of the objective by default
+    EXPECT_EQ(ga::fitness::ObjFunction::metricCount(), ga::fitness::N_TRACKING_METRICS);
+    EXPECT_EQ(ga::fitness::ObjFunction::getMetrics(performance)[6], 0.0);
+
+    ga::fitness::ObjFunction::setSolverCost(ga::fitness::ObjFunction::parseSolverCost("iterations"), 10.0);
+    EXPECT_EQ(ga::fitness::ObjFunction::metricCount(), ga::fitness::N_METRICS);
+
+    const ga::fitness::metrics_t metrics = ga::fitness::ObjFunction::getMetrics(performance);
+    EXPECT_DOUBLE_EQ(metrics[5], 50.0);
+    EXPECT_DOUBLE_EQ(metrics[6], 99.0);
+
+    // Same tracking, twice the solver cost
+    ga::fitness::metrics_t expensive = metrics;
+    expensive[5] *= 2;
+    expensive[6] *= 2;
+    EXPECT_LT(ga::fitness::ObjFunction::score(expensive), ga::fitness::ObjFunction::score(metrics));
+
+    ga::fitness::ObjFunction::setSolverCost(ga::fitness::SolverCost::LATENCY, 10.0);
+    EXPECT_DOUBLE_EQ(ga::fitness::ObjFunction::getMetrics(performance)[6], 1.0);
+
+    ga::fitness::ObjFunction::setSolverCost(ga::fitness::SolverCost::NONE, 0.0);
+}
+
+TEST(GaCoreTestSuite, testCheckpointRoundTrip)
+{
+    ga::core::Genome prototype;
+
+    for (size_t i = 0; i < 7; i++)
+        prototype.addChoromosome(0.01, 100.0);
+
+    ga::core::Genome genome = prototype;
+    genome.encode({1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0});
+
+    ga::Checkpoint cp;
+    cp.generation = 12;
+    cp.configHash = 0xabcdef;
+    cp.objective = {{{0.2, 1.0, 0.4, 0.2, 0.25}}, {{1.0, 2.0, 3.0, 4.0, 5.0}}, true, false};
+
+    std::mt19937_64 engine(7);
+    engine.discard(100);
+    std::ostringstream rngState;
+    rngState << engine;
+    cp.rngState = rngState.str();
+
+    cp.organisms.push_back({genome, {{1.0, 2.0, 3.0, 4.0, 5.0}}, 42.0, 12});
+    cp.historySize = 2;
+    cp.history.push_back({genome, {{1.0, 2.0, 3.0, 4.0, 5.0}}, 42.0, 11});
+    cp.history.push_back({prototype, {{5.0, 4.0, 3.0, 2.0, 1.0}}, 21.0, 12});
+
+    const std::string bytes = ga::checkpoint::serialize(cp);
+
+    ga::Checkpoint restored;
+    ASSERT_TRUE(ga::checkpoint::deserialize(bytes, prototype, restored));
+
+    EXPECT_EQ(restored.generation, cp.generation);
+    EXPECT_EQ(restored.configHash, cp.configHash);
+    EXPECT_EQ(restored.objective.weights, cp.objective.weights);
+    EXPECT_EQ(restored.objective.started, cp.objective.started);
+    EXPECT_EQ(restored.rngState, cp.rngState);
+    ASSERT_EQ(restored.organisms.size(), 1u);
+    EXPECT_TRUE(restored.organisms[0].genome == genome);
+    EXPECT_EQ(restored.historySize, 2u);
+    EXPECT_TRUE(restored.history.empty());
+
+    std::mt19937_64 restoredEngine;
+    std::istringstream(restored.rngState) >> restoredEngine;
+    EXPECT_EQ(restoredEngine(), engine());
+
+    // A corrupt or truncated checkpoint must be rejected
+    EXPECT_FALSE(ga::checkpoint::deserialize(bytes.substr(0, bytes.size() - 3), prototype, restored));
+}
+
+TEST(GaCoreTestSuite, testCheckpointHistory)
+{
+    const std::string path = "test-checkpoint.bin";
+
+    ga::core::Genome prototype;
+
+    for (size_t i = 0; i < 7; i++)
+        prototype.addChoromosome(0.01, 100.0);
+
+    std::vector<ga::Evaluation> history;
+    for (size_t i = 0; i < 5; i++)
+    {
+        ga::core::Genome genome = prototype;
+        genome.encode({1.0 + i, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0});
+        history.push_back({genome, {{1.0 * i, 2.0, 3.0, 4.0, 5.0}}, 10.0 * i, i / 2});
+    }
+
+    ga::Checkpoint cp;
+    cp.generation = 1;
+    cp.configHash = 7;
+    cp.objective = {{{0.2, 1.0, 0.4, 0.2, 0.25}}, {{1.0, 2.0, 3.0, 4.0, 5.0}}, false, false};
+    cp.organisms = {history[0]};
+    cp.historySize = 2;
+    cp.history.assign(history.begin(), history.begin() + 2);
+
+    {
+        ga::checkpoint::Writer writer;
+        writer.write(path, cp);
+
+        // Only the new evaluations are passed on
+        cp.generation = 2;
+        cp.historySize = 4;
+        cp.history.assign(history.begin() + 2, history.begin() + 4);
+        writer.write(path, cp);
+        ASSERT_TRUE(writer.wait());
+    }
+
+    ga::Checkpoint restored;
+    ASSERT_TRUE(ga::checkpoint::load(path, prototype, restored));
+    EXPECT_EQ(restored.generation, 2u);
+    ASSERT_EQ(restored.history.size(), 4u);
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(restored.history[i].genome == history[i].genome);
+        EXPECT_EQ(restored.history[i].metrics, history[i].metrics);
+    }
+
+    // Evaluations appended by a write killed before its checkpoint are ignored, then cut off
+    {
+        std::ofstream tail(ga::checkpoint::historyPath(path), std::ios::binary | std::ios::app);
+        tail << "partial evaluation";
+    }
+
+    ASSERT_TRUE(ga::checkpoint::load(path, prototype, restored));
+    ASSERT_EQ(restored.history.size(), 4u);
+
+    {
+        ga::checkpoint::Writer writer;
+        cp.generation = 3;
+        cp.historySize = 5;
+        cp.history.assign(history.begin() + 4, history.end());
+        writer.write(path, cp);
+        ASSERT_TRUE(writer.wait());
+    }
+
+    ASSERT_TRUE(ga::checkpoint::load(path, prototype, restored));
+    ASSERT_EQ(restored.history.size(), 5u);
+    EXPECT_EQ(restored.history[4].metrics, history[4].metrics);
+
+    std::remove(path.c_str());
+    std::remove(ga::checkpoint::historyPath(path).c_str());
+}
+
+TEST(GaCoreTestSuite, testTelemetry)
+{
+    ga::core::Genome a;
+    a.addChoromosome(0.0, 1.0);
+    a.addChoromosome(0.0, 1.0);
+
+    ga::core::Genome b = a;
+    b.chromosomes[0].genes.flip();
+
+    // Two of three pairs differ in half of the genes
+    EXPECT_DOUBLE_EQ(ga::telemetry::diversity({a, a}), 0.0);
+    EXPECT_DOUBLE_EQ(ga::telemetry::diversity({a, b, b}), 2.0 / 3.0 * 0.5);
+
+    ga::GenerationStats stats;
+    stats.generation = 3;
+    stats.lookups = 4;
+    stats.hits = 1;
+    stats.seconds.evaluation = 2.0;
+    stats.solver.seconds = 1.0;
+    stats.solver.iterations = 42;
+    stats.workerThreads = 2;
+
+    // One line per generation
+    const std::string line = ga::telemetry::format(stats);
+    EXPECT_EQ(line.find('\n'), std::string::npos);
+
+    Json::Value root;
+    ASSERT_TRUE(Json::Reader().parse(line, root));
+    EXPECT_EQ(root["generation"].asUInt64(), 3);
+    EXPECT_DOUBLE_EQ(root["archive"]["hit_rate"].asDouble(), 0.25);
+    EXPECT_EQ(root["ipopt"]["iterations"].asUInt64(), 42);
+    EXPECT_DOUBLE_EQ(root["workers"]["utilization"].asDouble(), 0.25);
+}
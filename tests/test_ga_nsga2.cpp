@@ -0,0 +1,86 @@
+#include "primary.h"
+#include "genetic_algorithm/nsga2.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+/**
+ * Naive O(MN^2) front assignment, used as the reference
+ */
+static std::vector<size_t> naiveSort(const std::vector<ga::fitness::metrics_t> &objectives)
+{
+    const size_t n = objectives.size();
+
+    std::vector<size_t> fronts(n, 0);
+    std::vector<bool> assigned(n, false);
+    size_t remaining = n, front = 0;
+
+    while (remaining > 0)
+    {
+        std::vector<size_t> current;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (assigned[i])
+                continue;
+
+            bool dominated = false;
+            for (size_t j = 0; j < n && !dominated; j++)
+                dominated = !assigned[j] && ga::nsga2::dominates(objectives[j], objectives[i]);
+
+            if (!dominated)
+                current.push_back(i);
+        }
+
+        for (const size_t i : current)
+        {
+            fronts[i] = front;
+            assigned[i] = true;
+        }
+
+        remaining -= current.size();
+        front++;
+    }
+
+    return fronts;
+}
+
+TEST(GaNsga2TestSuite, testNonDominatedSort)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> dist(0, 9);
+
+    // Small integer grid so there are plenty of ties and duplicates
+    std::vector<ga::fitness::metrics_t> objectives(500);
+    for (auto &point : objectives)
+        for (auto &value : point)
+            value = dist(generator);
+
+    EXPECT_EQ(ga::nsga2::nonDominatedSort(objectives), naiveSort(objectives));
+}
+
+TEST(GaNsga2TestSuite, testCrowdingDistance)
+{
+    std::vector<ga::fitness::metrics_t> objectives = {
+        {{0.0, 4.0, 0.0, 0.0, 0.0}},
+        {{1.0, 3.0, 0.0, 0.0, 0.0}},
+        {{3.0, 1.0, 0.0, 0.0, 0.0}},
+        {{4.0, 0.0, 0.0, 0.0, 0.0}},
+        {{4.0, 4.0, 0.0, 0.0, 0.0}}};
+
+    const std::vector<size_t> fronts = ga::nsga2::nonDominatedSort(objectives);
+
+    EXPECT_EQ(fronts, std::vector<size_t>({0, 0, 0, 0, 1}));
+
+    const std::vector<double> distance = ga::nsga2::crowdingDistance(objectives, fronts);
+
+    EXPECT_TRUE(std::isinf(distance[0]));
+    EXPECT_TRUE(std::isinf(distance[3]));
+    EXPECT_DOUBLE_EQ(distance[1], 1.5);
+    EXPECT_DOUBLE_EQ(distance[2], 1.5);
+
+    const std::vector<size_t> order = ga::nsga2::rank(objectives);
+
+    EXPECT_EQ(order.back(), 4u);
+}
@@ -0,0 +1,122 @@
+#include "primary.h"
+#include "genetic_algorithm/population.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+/**
+ * Console input answering after a delay, as an operator thinking about the decision tree prompt
+ */
+class DelayedInput : public std::streambuf
+{
+public:
+    explicit DelayedInput(const std::string &answer) : m_answer(answer), m_delayed(false)
+    {
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (!m_delayed)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            setg(&m_answer[0], &m_answer[0], &m_answer[0] + m_answer.size());
+            m_delayed = true;
+        }
+
+        return gptr() < egptr() ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+    }
+
+private:
+    std::string m_answer;
+    bool m_delayed;
+};
+
+/**
+ * Result of a short GA run with one decision tree answer
+ */
+struct IdtRun
+{
+    std::vector<ga::Evaluation> history;
+    std::string bestWeights;
+    size_t evaluations;
+};
+
+static IdtRun runWithIdt(bool speculation, const ga::fitness::ObjFunction::State &objective)
+{
+    ga::fitness::ObjFunction::setState(objective);
+    ga::random::engine().seed(2021);
+
+    IdtRun run{{}, "", 0};
+
+    // Each tracking metric falls with its own weight, bumping one of them changes the ranking
+    const auto evaluator = [&run](const mpc::Params::Weights &w) {
+        run.evaluations++;
+
+        ga::fitness::metrics_t metrics{};
+        metrics[0] = 1.0 + 100.0 / (1.0 + w.cte);
+        metrics[1] = 1.0 + 100.0 / (1.0 + w.etheta);
+        metrics[2] = 1.0 + 100.0 / (1.0 + w.vel);
+        metrics[3] = 1.0 + w.omega;
+        metrics[4] = 1.0 + w.acc;
+
+        return metrics;
+    };
+
+    ga::Population population(8, 4, evaluator);
+    population.setSpeculation(speculation);
+    population.randDistInit();
+
+    // The first prompt only starts the tree, the second bumps the translational energy loss. That
+    // answer selects another mating pool, the generation bred before it is discarded
+    DelayedInput input("1 3\n");
+    std::streambuf *const console = std::cin.rdbuf(&input);
+
+    for (size_t gen = 1; gen <= 3; gen++)
+    {
+        population.mainLoop();
+
+        if (gen < 3)
+        {
+            population.runIDT();
+            population.refresh(gen);
+        }
+    }
+
+    std::cin.rdbuf(console);
+
+    run.history = population.getHistory();
+    run.bestWeights = population.getBestWeights();
+
+    return run;
+}
+
+TEST(GaPopulationTestSuite, testIdtSpeculation)
+{
+    const ga::fitness::ObjFunction::State objective = ga::fitness::ObjFunction::getState();
+
+    const IdtRun plain = runWithIdt(false, objective);
+    const IdtRun speculative = runWithIdt(true, objective);
+
+    ga::fitness::ObjFunction::setState(objective);
+
+    // Discarded generations were evaluated, yet only one generation per loop is recorded
+    EXPECT_GT(plain.evaluations, 3 * 8u);
+    EXPECT_GT(speculative.evaluations, plain.evaluations);
+    ASSERT_EQ(plain.history.size(), 3 * 8u);
+    ASSERT_EQ(speculative.history.size(), plain.history.size());
+
+    // Speculation never changes the outcome of a run
+    for (size_t i = 0; i < plain.history.size(); i++)
+    {
+        EXPECT_TRUE(speculative.history[i].genome == plain.history[i].genome) << "evaluation " << i;
+        EXPECT_EQ(speculative.history[i].metrics, plain.history[i].metrics) << "evaluation " << i;
+        EXPECT_DOUBLE_EQ(speculative.history[i].fitness, plain.history[i].fitness) << "evaluation " << i;
+    }
+
+    EXPECT_EQ(speculative.bestWeights, plain.bestWeights);
+}
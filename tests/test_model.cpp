@@ -1,7 +1,19 @@
 #include "primary.h"
 #include "model/differential_drive.h"
+#include "model/differential_drive_batch.h"
+#include "model/base_organism.h"
+#include "model/lockstep_rollout.h"
+#include "model/reference_path.h"
+#include "model/route_file.h"
+#include "mpc_lib/mpc.h"
 
 #include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
 
 TEST(ModelTestSuite, testModel)
 {
@@ -40,4 +52,316 @@ TEST(ModelTestSuite, testModel)
     ASSERT_DOUBLE_EQ(secondState.linVel, 0.0);
     ASSERT_DOUBLE_EQ(secondState.angVel, 0.0);
     ASSERT_DOUBLE_EQ(secondState.throttle, 0.0);
-}
\ No newline at end of file
+}
+TEST(ModelTestSuite, testBatchMatchesModel)
+{
+    const std::vector<model::State> states = {{-8.0, 1.5, -0.6, 0.0, 0.0, 0.0},
+                                              {2.0, -0.5, 0.3, 0.4, -0.2, 0.1},
+                                              {0.0, 0.0, 3.0, 1.0, 1.5, -1.0}};
+    const size_t n = states.size();
+
+    model::DifferentialDriveBatch batch(n);
+    batch.setSampleTime(0.1);
+
+    std::vector<model::DifferentialDrive> models(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        batch.setState(i, states[i]);
+        models[i].setSampleTime(0.1);
+        models[i].setInitState(states[i]);
+    }
+
+    for (size_t count = 0; count < 20; count++)
+    {
+        std::vector<double> speed(n), omega(n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            speed[i] = 0.5 + 0.1 * i + 0.01 * count;
+            omega[i] = 0.2 * i - 0.05 * count;
+            models[i].step(speed[i], omega[i]);
+        }
+
+        batch.step(speed.data(), omega.data());
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        const model::State expected = models[i].getState();
+        const model::State actual = batch.getState(i);
+
+        ASSERT_DOUBLE_EQ(actual.x, expected.x);
+        ASSERT_DOUBLE_EQ(actual.y, expected.y);
+        ASSERT_DOUBLE_EQ(actual.theta, expected.theta);
+        ASSERT_DOUBLE_EQ(actual.linVel, expected.linVel);
+        ASSERT_DOUBLE_EQ(actual.angVel, expected.angVel);
+        ASSERT_DOUBLE_EQ(actual.throttle, expected.throttle);
+    }
+}
+
+/**
+ * Organism exposing its recorded trajectory
+ */
+class RecordingOrganism : public model::BaseOrganism<config::GA>
+{
+public:
+    const Trajectory &trajectory() const
+    {
+        return m_jsonLogger.getTrajectory();
+    }
+};
+
+static void expectSameSteps(const std::vector<double> &expected, const std::vector<double> &actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+
+    for (size_t i = 0; i < expected.size(); i++)
+        ASSERT_NEAR(expected[i], actual[i], 1e-9) << "step " << i;
+}
+
+TEST(ModelTestSuite, testLockstepMatchesOrganism)
+{
+    const model::State initState = {-8.0, 1.5, -0.6, 0.0, 0.0, 0.0};
+    const model::TerminateOn<config::GA> term = {60};
+
+    mpc::Params params;
+    params.forward.timesteps = 12;
+    params.forward.dt = 0.1;
+    params.desired.vel = 0.5;
+    params.desired.cte = 0.0;
+    params.desired.etheta = 0.0;
+    params.limits.omega = {-2.0, 2.0};
+    params.limits.throttle = {-1.0, 1.0};
+    params.weights.cte = 87.859183;
+    params.weights.etheta = 99.532785;
+    params.weights.vel = 54.116644;
+    params.weights.omega = 47.430096;
+    params.weights.acc = 2.185306;
+    params.weights.omega_d = 4.611500;
+    params.weights.acc_d = 66.870729;
+
+    // Different weights in one batch
+    std::vector<mpc::Params> batchParams(2, params);
+    batchParams[1].weights.cte *= 10.0;
+    batchParams[1].weights.acc_d /= 10.0;
+
+    std::vector<RecordingOrganism> lockstep(batchParams.size());
+    for (auto &organism : lockstep)
+        organism.setModelInitState(initState);
+
+    model::LockstepRollout rollout;
+    const std::vector<bool> ok = rollout.run(*model::ReferencePath::xAxis(), batchParams, {initState, initState}, term.iterations,
+                                             [&lockstep](size_t i, const model::StepRecord &step) { lockstep[i].record(step); });
+
+    for (size_t i = 0; i < batchParams.size(); i++)
+    {
+        RecordingOrganism organism;
+        organism.setModelInitState(initState);
+        organism.refresh();
+
+        ASSERT_EQ(organism.followSetpoints(batchParams[i], term), ok[i]);
+
+        const model::Performance expected = organism.getPerformance();
+        const model::Performance actual = lockstep[i].getPerformance();
+
+        expectSameSteps(expected.cteData, actual.cteData);
+        expectSameSteps(expected.ethetaData, actual.ethetaData);
+        expectSameSteps(expected.velErrData, actual.velErrData);
+        expectSameSteps(expected.translationalEL, actual.translationalEL);
+        expectSameSteps(expected.rotationalEL, actual.rotationalEL);
+        expectSameSteps(expected.solveIterations, actual.solveIterations);
+
+        const Trajectory &expectedPath = organism.trajectory();
+        const Trajectory &actualPath = lockstep[i].trajectory();
+
+        expectSameSteps(expectedPath.x, actualPath.x);
+        expectSameSteps(expectedPath.y, actualPath.y);
+        expectSameSteps(expectedPath.costs, actualPath.costs);
+    }
+}
+
+TEST(ModelTestSuite, testPathNearestSegment)
+{
+    std::vector<double> xs, ys;
+
+    // Spiral, segments of many lengths and directions
+    for (size_t i = 0; i < 2000; i++)
+    {
+        const double angle = i * 0.01;
+        xs.push_back((1.0 + angle) * cos(angle));
+        ys.push_back((1.0 + angle) * sin(angle));
+    }
+
+    const model::ReferencePath path(xs, ys);
+
+    std::mt19937_64 engine(7);
+    std::uniform_real_distribution<double> coord(-30.0, 30.0);
+
+    for (size_t n = 0; n < 500; n++)
+    {
+        const double px = coord(engine), py = coord(engine);
+
+        double expected = path.project(0, px, py).distance;
+        for (size_t k = 1; k < path.segments(); k++)
+            expected = std::min(expected, path.project(k, px, py).distance);
+
+        ASSERT_NEAR(path.nearest(px, py).distance, expected, 1e-12);
+    }
+
+    // Tracking along the spiral, slightly off it, stays on the current turn
+    model::ReferencePath::Tracker tracker(&path);
+
+    for (size_t i = 0; i + 1 < 2000; i += 3)
+    {
+        const double angle = (i + 0.5) * 0.01;
+        const double px = (1.1 + angle) * cos(angle);
+        const double py = (1.1 + angle) * sin(angle);
+
+        const model::ReferencePath::Projection &projection = tracker.update(px, py);
+
+        double expected = path.project(i, px, py).distance;
+        for (size_t k = (i > 20 ? i - 20 : 0); k < std::min(i + 20, path.segments()); k++)
+            expected = std::min(expected, path.project(k, px, py).distance);
+
+        ASSERT_NEAR(projection.distance, expected, 1e-12);
+    }
+}
+
+TEST(ModelTestSuite, testRouteFile)
+{
+    const std::string csvPath = "test_route.csv", routePath = "test_route.bin";
+
+    std::vector<double> xs, ys;
+    {
+        std::ofstream csv(csvPath);
+        csv << std::setprecision(17) << "x,y,heading,speed\n";
+
+        for (size_t i = 0; i < 500; i++)
+        {
+            xs.push_back(i * 0.1);
+            ys.push_back(2.0 * sin(i * 0.01));
+            csv << xs.back() << "," << ys.back() << "," << 0.1 * i << "," << 0.5 << "\n";
+
+            // Repeated waypoints are dropped
+            if (i == 10)
+                csv << xs.back() << "," << ys.back() << "," << 0.1 * i << "," << 0.5 << "\n";
+        }
+    }
+
+    ASSERT_EQ(model::RouteFile::convertCsv(csvPath, routePath), 500);
+
+    const auto route = std::make_shared<const model::RouteFile>(routePath);
+    ASSERT_TRUE(route->isOpen());
+    ASSERT_EQ(route->size(), 500);
+    ASSERT_NE(route->arcLength(), nullptr);
+    ASSERT_DOUBLE_EQ(route->heading()[20], 2.0);
+    ASSERT_DOUBLE_EQ(route->speed()[499], 0.5);
+
+    const model::ReferencePath mapped(route);
+    const model::ReferencePath owned(xs, ys);
+
+    ASSERT_EQ(mapped.segments(), owned.segments());
+    ASSERT_NEAR(mapped.length(), owned.length(), 1e-9);
+
+    for (const double px : {-3.0, 0.0, 12.3, 49.9, 60.0})
+    {
+        const model::ReferencePath::Projection a = mapped.nearest(px, 1.0);
+        const model::ReferencePath::Projection b = owned.nearest(px, 1.0);
+
+        ASSERT_EQ(a.segment, b.segment);
+        ASSERT_NEAR(a.s, b.s, 1e-9);
+        ASSERT_NEAR(a.distance, b.distance, 1e-9);
+    }
+
+    // Anything else is rejected
+    ASSERT_FALSE(model::RouteFile(csvPath).isOpen());
+
+    std::ifstream in(routePath, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const size_t header = sizeof(model::RouteFile::Header);
+
+    // So is a repeated waypoint, the segment to it would have no length
+    {
+        std::string repeated = bytes;
+        std::memcpy(&repeated[header + 11 * sizeof(double)], &bytes[header + 10 * sizeof(double)], sizeof(double));
+        std::memcpy(&repeated[header + (500 + 11) * sizeof(double)], &bytes[header + (500 + 10) * sizeof(double)], sizeof(double));
+
+        std::ofstream(routePath, std::ios::binary) << repeated;
+        ASSERT_FALSE(model::RouteFile(routePath).isOpen());
+    }
+
+    // And a count that only matches the file size after wrapping around
+    {
+        std::string wrapped = bytes.substr(0, header);
+        const uint64_t count = uint64_t(1) << 61;
+        std::memcpy(&wrapped[offsetof(model::RouteFile::Header, count)], &count, sizeof(count));
+
+        std::ofstream(routePath, std::ios::binary) << wrapped;
+        ASSERT_FALSE(model::RouteFile(routePath).isOpen());
+    }
+
+    std::remove(csvPath.c_str());
+    std::remove(routePath.c_str());
+}
+
+TEST(ModelTestSuite, testPathLocalCubic)
+{
+    // On the x axis the cubic is the line the old window fit gave
+    model::ReferencePath::Tracker axis(model::ReferencePath::xAxis().get());
+
+    for (const model::State &state : {model::State{-8.0, 0.5, -0.6, 0.0, 0.0, 0.0}, model::State{3.0, -1.0, 0.4, 0.0, 0.0, 0.0}})
+    {
+        const std::array<double, 4> cubic = axis.localCubic(state.x, state.y, state.theta, model::ReferencePath::LOOKAHEAD);
+
+        Eigen::VectorXd xs(6), ys(6);
+        for (size_t k = 0; k < 6; k++)
+        {
+            const double shift_x = k * 0.1;
+            const double shift_y = -state.y;
+            xs[k] = shift_x * cos(-state.theta) - shift_y * sin(-state.theta);
+            ys[k] = shift_x * sin(-state.theta) + shift_y * cos(-state.theta);
+        }
+
+        const Eigen::VectorXd expected = mpc::utils::polyfit(xs, ys, 3);
+
+        for (size_t j = 0; j < 4; j++)
+            ASSERT_NEAR(cubic[j], expected[j], 1e-9);
+    }
+
+    // A tight circle, the cubic passes through the spline and matches its heading where it starts
+    std::vector<double> xs, ys;
+    const double radius = 0.5;
+
+    for (size_t i = 0; i <= 60; i++)
+    {
+        xs.push_back(radius * cos(i * 0.1));
+        ys.push_back(radius * sin(i * 0.1));
+    }
+
+    const model::ReferencePath circle(xs, ys);
+    model::ReferencePath::Tracker tracker(&circle);
+
+    const double px = 0.45 * cos(1.0), py = 0.45 * sin(1.0), theta = 1.0 + M_PI / 2 + 0.2;
+    const std::array<double, 4> cubic = tracker.localCubic(px, py, theta, model::ReferencePath::LOOKAHEAD);
+
+    const model::ReferencePath::Projection &projection = tracker.projection();
+    const model::ReferencePath::Piece piece = circle.piece(projection.segment);
+    const double u = projection.s - piece.s0;
+
+    const double sx = mpc::utils::horner(piece.cx, u), sy = mpc::utils::horner(piece.cy, u);
+    const double heading = atan2(mpc::utils::hornerDerivative(piece.cy, u), mpc::utils::hornerDerivative(piece.cx, u));
+
+    const double lx = (sx - px) * cos(theta) + (sy - py) * sin(theta);
+    const double ly = -(sx - px) * sin(theta) + (sy - py) * cos(theta);
+
+    ASSERT_NEAR(mpc::utils::horner(cubic, lx), ly, 1e-9);
+    ASSERT_NEAR(atan(mpc::utils::hornerDerivative(cubic, lx)), heading - theta, 1e-9);
+
+    // The spline runs through the waypoints with their headings
+    const model::ReferencePath::Piece first = circle.piece(10);
+
+    ASSERT_NEAR(mpc::utils::horner(first.cx, 0.0), xs[10], 1e-12);
+    ASSERT_NEAR(mpc::utils::horner(first.cy, first.length), ys[11], 1e-12);
+    ASSERT_NEAR(atan2(first.cy[1], first.cx[1]), atan2(ys[11] - ys[9], xs[11] - xs[9]), 1e-12);
+}
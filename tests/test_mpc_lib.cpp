@@ -0,0 +1,263 @@
+#include "primary.h"
+#include "mpc_lib/event_trigger.h"
+#include "mpc_lib/horizon_scheduler.h"
+#include "mpc_lib/mpc.h"
+#include "mpc_lib/solver_profile.h"
+#include "mpc_lib/warm_start_cache.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+TEST(MpcLibTestSuite, testSolverProfile)
+{
+    mpc::SolverProfile profile;
+
+    for (size_t i = 1; i <= 100; i++)
+    {
+        mpc::SolveStats stats;
+        stats.status = (i % 10 == 0) ? 2 : 1;
+        stats.iterations = i;
+        stats.seconds = i * 1e-4;
+        stats.evalSeconds = 1e-5;
+        stats.allocations = 3;
+        profile.add(stats);
+    }
+
+    mpc::SolverProfile other;
+    other.merge(profile);
+
+    const SolverSummary summary = other.summary();
+    ASSERT_EQ(summary.solves, 100);
+    ASSERT_EQ(summary.failures, 10);
+    ASSERT_NEAR(summary.latencyP50, 5000.0, 5000.0 / HdrHistogram::SUB_BUCKETS);
+    ASSERT_NEAR(summary.latencyMax, 10000.0, 1e-6);
+    ASSERT_NEAR(summary.iterationsP99, 99.0, 99.0 / HdrHistogram::SUB_BUCKETS);
+    ASSERT_DOUBLE_EQ(summary.iterationsMax, 100.0);
+    ASSERT_NEAR(summary.evalSeconds, 1e-3, 1e-12);
+    ASSERT_EQ(other.allocations(), 300);
+
+    other.reset();
+    ASSERT_EQ(other.solves(), 0);
+}
+
+TEST(MpcLibTestSuite, testEventTrigger)
+{
+    mpc::SolveStats solved;
+    solved.status = 1;
+
+    // Plan driving along the y axis of the world, posed at (1, 2) facing +y
+    auto fill = [](mpc::Plan &plan) {
+        plan.x = {0.0, 0.1, 0.2, 0.3};
+        plan.y = {0.0, 0.0, 0.0, 0.0};
+        plan.theta = {0.0, 0.0, 0.0, 0.0};
+        plan.v = {1.0, 1.0, 1.0, 1.0};
+        plan.omega = {0.1, 0.2, 0.3};
+        plan.acc = {0.01, 0.02, 0.03};
+        plan.cost = 5.0;
+    };
+
+    double omega = 0.0, acc = 0.0;
+
+    // Disabled, every step solves
+    mpc::EventTrigger disabled;
+    fill(disabled.plan());
+    disabled.accept(solved, 1.0, 2.0, M_PI_2);
+    ASSERT_FALSE(disabled.follow(1.0, 2.1, M_PI_2, 1.0, omega, acc));
+
+    mpc::EventTrigger trigger({0.05, 0.05, 0.05});
+    ASSERT_FALSE(trigger.follow(1.0, 2.1, M_PI_2, 1.0, omega, acc));
+
+    // A failed solve leaves nothing to follow
+    fill(trigger.plan());
+    trigger.accept(mpc::SolveStats(), 1.0, 2.0, M_PI_2);
+    ASSERT_FALSE(trigger.follow(1.0, 2.1, M_PI_2, 1.0, omega, acc));
+
+    const uint64_t skipped = mpc::EventTrigger::skippedTotal();
+
+    trigger.accept(solved, 1.0, 2.0, M_PI_2);
+    ASSERT_TRUE(trigger.follow(1.02, 2.1, M_PI_2, 1.01, omega, acc));
+    ASSERT_DOUBLE_EQ(omega, 0.2);
+    ASSERT_DOUBLE_EQ(acc, 0.02);
+    ASSERT_EQ(mpc::EventTrigger::skippedTotal(), skipped + 1);
+
+    // A deviation drops the plan, even if the robot gets back on it
+    ASSERT_FALSE(trigger.follow(1.2, 2.2, M_PI_2, 1.0, omega, acc));
+    ASSERT_FALSE(trigger.follow(1.0, 2.3, M_PI_2, 1.0, omega, acc));
+
+    // So does running out of controls
+    trigger.accept(solved, 1.0, 2.0, M_PI_2);
+    ASSERT_TRUE(trigger.follow(1.0, 2.1, M_PI_2, 1.0, omega, acc));
+    ASSERT_TRUE(trigger.follow(1.0, 2.2, M_PI_2, 1.0, omega, acc));
+    ASSERT_FALSE(trigger.follow(1.0, 2.3, M_PI_2, 1.0, omega, acc));
+
+    // Heading deviations wrap, solved facing just below pi and followed just above -pi
+    const double heading = M_PI - 0.01;
+    trigger.accept(solved, 1.0, 2.0, heading);
+    ASSERT_TRUE(trigger.follow(1.0 + 0.1 * cos(heading), 2.0 + 0.1 * sin(heading), -M_PI + 0.01, 1.0, omega, acc));
+    ASSERT_FALSE(trigger.follow(1.0 + 0.2 * cos(heading), 2.0 + 0.2 * sin(heading), -M_PI + 0.1, 1.0, omega, acc));
+
+    trigger.accept(solved, 1.0, 2.0, M_PI_2);
+    trigger.reset();
+    ASSERT_FALSE(trigger.follow(1.0, 2.1, M_PI_2, 1.0, omega, acc));
+
+    // Skipped steps are no solves
+    mpc::SolveStats stats;
+    stats.skipped = true;
+
+    mpc::SolverProfile profile;
+    profile.add(stats);
+    ASSERT_EQ(profile.skipped(), 1);
+    ASSERT_EQ(profile.solves(), 0);
+}
+
+TEST(MpcLibTestSuite, testHorizonScheduler)
+{
+    // One control per block, the last block shorter
+    const mpc::VarIndices blocked(12, 4);
+    ASSERT_EQ(blocked.n_controls, 3);
+    ASSERT_EQ(blocked.acc_start, blocked.omega_start + 3);
+    ASSERT_EQ(blocked.n_vars, 6 * 12 + 2 * 3);
+    ASSERT_EQ(blocked.control(3), 0);
+    ASSERT_EQ(blocked.control(4), 1);
+    ASSERT_EQ(blocked.control(10), 2);
+
+    const mpc::VarIndices full(12);
+    ASSERT_EQ(full.n_vars, 6 * 12 + 2 * 11);
+
+    ASSERT_THROW(mpc::HorizonScheduler({2, 12, 2, 0.1, 0.02, 50.0, 1}), std::invalid_argument);
+    ASSERT_THROW(mpc::HorizonScheduler({8, 6, 2, 0.1, 0.02, 50.0, 1}), std::invalid_argument);
+
+    mpc::Params params;
+    params.forward.timesteps = 12;
+
+    // Disabled, the parameters are left alone
+    mpc::HorizonScheduler disabled;
+    disabled.update(0.0, 0.0, 0.0, mpc::SolveStats());
+    disabled.schedule(params);
+    ASSERT_EQ(params.forward.timesteps, 12);
+    ASSERT_EQ(params.forward.blocking, 1);
+
+    mpc::HorizonScheduler horizon({6, 12, 4, 0.1, 0.02, 50.0, 2});
+    horizon.schedule(params);
+    ASSERT_EQ(params.forward.timesteps, 12);
+    ASSERT_EQ(params.forward.blocking, 2);
+
+    mpc::SolveStats cheap;
+    cheap.iterations = 10;
+
+    // Small errors shrink down to the bound, in between the horizon holds
+    horizon.update(0.01, 0.0, 0.0, cheap);
+    ASSERT_EQ(horizon.timesteps(), 8);
+    horizon.update(0.0, 0.01, 0.0, cheap);
+    ASSERT_EQ(horizon.timesteps(), 6);
+    horizon.update(0.05, 0.0, 0.0, cheap);
+    ASSERT_EQ(horizon.timesteps(), 6);
+
+    // Large errors grow up to the bound
+    horizon.update(0.0, 0.0, 0.5, cheap);
+    horizon.update(0.0, 0.0, 0.5, cheap);
+    ASSERT_EQ(horizon.timesteps(), 12);
+    horizon.update(0.0, 0.0, 0.5, cheap);
+    ASSERT_EQ(horizon.timesteps(), 12);
+
+    // Expensive solves shrink it despite the errors, once the smoothed effort is above the limit
+    mpc::SolveStats expensive;
+    expensive.iterations = 500;
+
+    horizon.update(0.5, 0.0, 0.0, expensive);
+    ASSERT_EQ(horizon.timesteps(), 8);
+
+    horizon.reset();
+    ASSERT_EQ(horizon.timesteps(), 12);
+}
+
+TEST(MpcLibTestSuite, testWarmStartCache)
+{
+    const size_t size = 8;
+
+    const auto keyAt = [](double offset) {
+        mpc::WarmStartCache::Key key{};
+        key[0] = offset;
+        return key;
+    };
+
+    const auto solutionOf = [size](double value) { return std::vector<double>(size, value); };
+
+    mpc::WarmStartCache cache(64, 0.5);
+    std::vector<double> guess(size, 0.0);
+
+    ASSERT_FALSE(cache.lookup(keyAt(0.0), 10, guess.data(), size));
+
+    // Enough entries to build the tree, the rest stays pending
+    for (int i = 0; i < 40; i++)
+        cache.insert(keyAt(i), 10, solutionOf(i).data(), size);
+
+    ASSERT_EQ(cache.size(), 40);
+
+    // Nearest within the radius, from the tree and from the pending entries
+    ASSERT_TRUE(cache.lookup(keyAt(3.2), 10, guess.data(), size));
+    ASSERT_DOUBLE_EQ(guess[0], 3.0);
+    ASSERT_TRUE(cache.lookup(keyAt(38.9), 10, guess.data(), size));
+    ASSERT_DOUBLE_EQ(guess[size - 1], 39.0);
+
+    // Beyond the radius, or of another horizon or number of variables
+    ASSERT_FALSE(cache.lookup(keyAt(45.0), 10, guess.data(), size));
+    ASSERT_FALSE(cache.lookup(keyAt(3.0), 8, guess.data(), size));
+    ASSERT_FALSE(cache.lookup(keyAt(3.0), 10, guess.data(), size - 1));
+
+    // Once full the oldest are replaced
+    for (int i = 100; i < 164; i++)
+        cache.insert(keyAt(i), 10, solutionOf(i).data(), size);
+
+    ASSERT_EQ(cache.size(), 64);
+    ASSERT_FALSE(cache.lookup(keyAt(3.0), 10, guess.data(), size));
+    ASSERT_TRUE(cache.lookup(keyAt(150.1), 10, guess.data(), size));
+    ASSERT_DOUBLE_EQ(guess[0], 150.0);
+
+    mpc::SolveStats cold, warm;
+    cold.iterations = 20;
+    warm.iterations = 5;
+    warm.warmStarted = true;
+
+    const mpc::WarmStartCache::Stats before = cache.stats();
+    cache.record(cold, false);
+    cache.record(warm, false);
+    cache.record(warm, true);
+
+    const mpc::WarmStartCache::Stats stats = cache.stats() - before;
+    ASSERT_EQ(stats.lookups, 0);
+    ASSERT_EQ(stats.fallbacks, 1);
+    ASSERT_DOUBLE_EQ(stats.iterationsSaved(), 2 * 20.0 - 2 * 5.0);
+
+    const mpc::WarmStartCache::Stats total = cache.stats();
+    ASSERT_EQ(total.lookups, 8);
+    ASSERT_DOUBLE_EQ(total.hitRate(), 3.0 / 8.0);
+
+    // Concurrent rollouts share the cache
+    mpc::WarmStartCache shared(128, 0.5);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&shared, &keyAt, &solutionOf, size, t]() {
+            std::vector<double> local(size);
+
+            for (int i = 0; i < 100; i++)
+            {
+                const double offset = t * 1000.0 + i;
+                shared.insert(keyAt(offset), 10, solutionOf(offset).data(), size);
+
+                if (shared.lookup(keyAt(offset), 10, local.data(), size))
+                {
+                    ASSERT_DOUBLE_EQ(local[0], offset);
+                }
+            }
+        });
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    ASSERT_EQ(shared.size(), 128);
+    ASSERT_EQ(shared.stats().lookups, 400);
+}
@@ -0,0 +1,299 @@
+#include "genetic_algorithm/fitness.h"
+#include "genetic_algorithm/population.h"
+#include "model/base_organism.h"
+#include "model/reference_path.h"
+#include "mpc_lib/mpc.h"
+#include "mpc_lib/solver_profile.h"
+
+#include <gtest/gtest.h>
+#include <json/reader.h>
+#include <json/writer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+/**
+ * Performance regression gate
+ *
+ * Replays a fixed set of states and weights through MPC::solve, a closed-loop rollout and a short GA run,
+ * and compares Ipopt iterations and the closed-loop results against the checked-in baseline. Run from
+ * the repository root, ctest does so.
+ *
+ * Solve latencies depend on the machine, they are only compared with GNT_PERF_LATENCY=1 on the machine
+ * the baseline was recorded on. A test without its section in the baseline is skipped. Record the
+ * sections, or accept a deliberate change, with
+ *     GNT_PERF_UPDATE=1 ctest -R perf_regression
+ * The tolerance band is kept when the baseline is rewritten, edit it in the file.
+ */
+
+static const char *BASELINE_FILE = "tests/perf_baseline.json";
+
+namespace
+{
+    /// Baseline read at startup, measurements collected for an update
+    Json::Value s_baseline, s_measured;
+
+    bool enabled(const char *variable)
+    {
+        const char *value = std::getenv(variable);
+        return value && value[0] != '\0' && value[0] != '0';
+    }
+
+    bool updating()
+    {
+        return enabled("GNT_PERF_UPDATE");
+    }
+
+    class BaselineEnvironment : public ::testing::Environment
+    {
+    public:
+        void SetUp() override
+        {
+            std::ifstream file(BASELINE_FILE);
+
+            if (file.is_open() && !Json::Reader().parse(file, s_baseline))
+                s_baseline = Json::Value();
+
+            // Sections of tests filtered out of an update keep their baseline
+            s_measured = s_baseline;
+
+            if (!s_measured.isMember("tolerance"))
+                s_measured["tolerance"] = defaultTolerance();
+        }
+
+        void TearDown() override
+        {
+            if (!updating())
+                return;
+
+            Json::StreamWriterBuilder builder;
+            builder["indentation"] = "    ";
+
+            std::ofstream file(BASELINE_FILE);
+            file << Json::writeString(builder, s_measured) << "\n";
+
+            std::cout << "[ PERF-INFO ]: Baseline written to " << BASELINE_FILE << "\n";
+        }
+
+    private:
+        static Json::Value defaultTolerance()
+        {
+            Json::Value tolerance;
+
+            // Latency may grow by half, iterations change by a tenth, results by rounding only
+            tolerance["latency"] = 0.5;
+            tolerance["iterations"] = 0.1;
+            tolerance["numerical"] = 1e-6;
+
+            return tolerance;
+        }
+    };
+
+    const auto *const s_environment = ::testing::AddGlobalTestEnvironment(new BaselineEnvironment);
+
+    mpc::Params makeParams(const mpc::Params::Weights &weights)
+    {
+        mpc::Params params;
+
+        params.forward.timesteps = 12;
+        params.forward.dt = 0.1;
+
+        params.desired.vel = 0.5;
+        params.desired.cte = 0.0;
+        params.desired.etheta = 0.0;
+
+        params.limits.omega = {-2.0, 2.0};
+        params.limits.throttle = {-1.0, 1.0};
+
+        params.weights = weights;
+
+        return params;
+    }
+
+    /// Converged, error dominated and control dominated weights
+    const mpc::Params::Weights WEIGHTS[] = {
+        {54.116644, 87.859183, 99.532785, 47.430096, 2.185306, 4.611500, 66.870729},
+        {10.0, 100.0, 100.0, 0.01, 0.01, 0.01, 0.01},
+        {10.0, 1.0, 1.0, 100.0, 100.0, 100.0, 100.0}};
+
+    const model::State INITIAL_STATE = {-8.0, 1.5, -0.6, 0.0, 0.0, 0.0};
+
+    Json::Value summarize(const mpc::SolverProfile &profile)
+    {
+        Json::Value section;
+
+        section["solves"] = Json::UInt64(profile.solves());
+        section["failures"] = Json::UInt64(profile.failures());
+        section["latency_p50_us"] = profile.latency().percentile(50.0) * 1e-3;
+        section["latency_p90_us"] = profile.latency().percentile(90.0) * 1e-3;
+        section["latency_p99_us"] = profile.latency().percentile(99.0) * 1e-3;
+        section["iterations_mean"] = profile.iterations().mean();
+        section["iterations_p50"] = Json::UInt64(profile.iterations().percentile(50.0));
+        section["iterations_p99"] = Json::UInt64(profile.iterations().percentile(99.0));
+
+        return section;
+    }
+
+    /**
+     * Compare a section of measurements against the baseline, or keep it for the update
+     *
+     * Latencies only fail when slower than the band allows and only with GNT_PERF_LATENCY set, iterations
+     * when they leave it in either direction and every other number when it moves by more than the
+     * numerical tolerance.
+     */
+    void check(const std::string &name, const Json::Value &measured)
+    {
+        s_measured[name] = measured;
+
+        if (updating())
+            return;
+
+        if (!s_baseline.isMember(name))
+            GTEST_SKIP() << "No " << name << " section in " << BASELINE_FILE << ", record it with GNT_PERF_UPDATE=1";
+
+        const Json::Value &baseline = s_baseline[name];
+        const Json::Value &tolerance = s_measured["tolerance"];
+        const bool latency = enabled("GNT_PERF_LATENCY");
+
+        for (const std::string &key : measured.getMemberNames())
+        {
+            if (key.compare(0, 8, "latency_") == 0 && !latency)
+                continue;
+
+            ASSERT_TRUE(baseline.isMember(key)) << name << "." << key << " is missing from the baseline";
+
+            const Json::Value &m = measured[key], &b = baseline[key];
+            ASSERT_EQ(m.size(), b.size()) << name << "." << key;
+
+            for (Json::ArrayIndex i = 0; i < std::max(1u, m.size()); i++)
+            {
+                const double value = m.isArray() ? m[i].asDouble() : m.asDouble();
+                const double expected = b.isArray() ? b[i].asDouble() : b.asDouble();
+
+                if (key.compare(0, 8, "latency_") == 0)
+                {
+                    EXPECT_LE(value, expected * (1.0 + tolerance["latency"].asDouble()))
+                        << name << "." << key << " regressed, baseline " << expected;
+                }
+                else if (key.compare(0, 11, "iterations_") == 0)
+                {
+                    EXPECT_LE(fabs(value - expected), tolerance["iterations"].asDouble() * expected + 1.0)
+                        << name << "." << key << " changed, baseline " << expected;
+                }
+                else
+                {
+                    EXPECT_LE(fabs(value - expected), tolerance["numerical"].asDouble() * (1.0 + fabs(expected)))
+                        << name << "." << key << "[" << i << "] differs from the golden output";
+                }
+            }
+        }
+    }
+} // namespace
+
+class PerfRegressionTestSuite : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // A missing or unreadable baseline must not pass the gate silently
+        if (!updating() && s_baseline.isNull())
+            FAIL() << "No baseline at " << BASELINE_FILE << ", run from the repository root or write it with GNT_PERF_UPDATE=1";
+    }
+};
+
+TEST_F(PerfRegressionTestSuite, testSolveReplay)
+{
+    const auto path = model::ReferencePath::xAxis();
+    mpc::SolverProfile profile;
+
+    // Three passes over poses around the start of the route, at rest and at the desired speed
+    for (int pass = 0; pass < 3; pass++)
+        for (const double x : {-8.0, -4.0, 0.0})
+            for (const double y : {-1.0, 0.5, 1.5})
+                for (const double theta : {-0.6, 0.0, 0.6})
+                    for (const double v : {0.0, 0.5})
+                        for (const auto &weights : WEIGHTS)
+                        {
+                            model::ReferencePath::Tracker tracker(path.get());
+                            const std::array<double, 4> cubic = tracker.localCubic(x, y, theta, model::ReferencePath::LOOKAHEAD);
+                            const Eigen::VectorXd coeffs = Eigen::Map<const Eigen::Vector4d>(cubic.data());
+
+                            Eigen::VectorXd state(6);
+                            state << 0.0, 0.0, 0.0, v, mpc::utils::polyeval(coeffs, 0), -atan(coeffs[1]);
+
+                            mpc::MPC _mpc(makeParams(weights), coeffs);
+                            _mpc.solve(state);
+
+                            profile.add(_mpc.stats());
+                        }
+
+    EXPECT_EQ(profile.failures(), 0u);
+    check("replay", summarize(profile));
+}
+
+TEST_F(PerfRegressionTestSuite, testClosedLoop)
+{
+    const model::TerminateOn<config::GA> term = {300};
+
+    model::BaseOrganism<config::GA> organism;
+    organism.setModelInitState(INITIAL_STATE);
+    organism.setRecording(false);
+
+    ASSERT_TRUE(organism.followSetpoints(makeParams(WEIGHTS[0]), term));
+
+    const model::State s = organism.getModelState();
+    const ga::fitness::metrics_t metrics = ga::fitness::ObjFunction::getMetrics(organism.getPerformance());
+
+    Json::Value measured = summarize(organism.getSolverProfile());
+
+    for (const double value : {s.x, s.y, s.theta, s.linVel, s.angVel, s.throttle})
+        measured["final_state"].append(value);
+
+    for (size_t m = 0; m < ga::fitness::N_TRACKING_METRICS; m++)
+        measured["metrics"].append(metrics[m]);
+
+    check("closed_loop", measured);
+}
+
+TEST_F(PerfRegressionTestSuite, testShortGaRun)
+{
+    const model::TerminateOn<config::GA> term = {100};
+
+    model::BaseOrganism<config::GA> organism;
+    organism.setModelInitState(INITIAL_STATE);
+    organism.setRecording(false);
+
+    mpc::SolverProfile profile;
+
+    // Real rollouts, but neither archived nor written to the run outputs
+    const auto evaluator = [&](const mpc::Params::Weights &weights) {
+        organism.refresh();
+
+        if (!organism.followSetpoints(makeParams(weights), term))
+            DEBUG_LOG("Rollout failed");
+
+        profile.merge(organism.getSolverProfile());
+
+        return ga::fitness::ObjFunction::getMetrics(organism.getPerformance());
+    };
+
+    ga::random::engine().seed(2021);
+
+    ga::Population population(6, 2, evaluator);
+    population.randDistInit();
+
+    for (size_t gen = 1; gen <= 3; gen++)
+    {
+        population.mainLoop();
+
+        if (gen < 3)
+            population.refresh(gen);
+    }
+
+    Json::Value measured = summarize(profile);
+    measured["evaluations"] = Json::UInt64(population.getHistory().size());
+    measured["best_fitness"] = population.getBestFitness();
+
+    check("ga", measured);
+}
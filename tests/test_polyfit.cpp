@@ -0,0 +1,67 @@
+#include "primary.h"
+#include "mpc_lib/mpc.h"
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+/**
+ * Power series evaluation, as polyeval used to compute it
+ */
+static double powEval(const Eigen::VectorXd &coeffs, double x)
+{
+    double result = 0.0;
+
+    for (int i = 0; i < coeffs.size(); i++)
+        result += coeffs[i] * pow(x, i);
+
+    return result;
+}
+
+TEST(PolyfitTestSuite, testHorner)
+{
+    std::mt19937_64 engine(3);
+    std::uniform_real_distribution<double> dist(-2.0, 2.0);
+
+    for (size_t n = 0; n < 100; n++)
+    {
+        Eigen::VectorXd coeffs(4);
+        coeffs << dist(engine), dist(engine), dist(engine), dist(engine);
+
+        const double x = dist(engine);
+        const double derivative = coeffs[1] + 2 * coeffs[2] * x + 3 * coeffs[3] * x * x;
+
+        ASSERT_NEAR(mpc::utils::polyeval(coeffs, x), powEval(coeffs, x), 1e-12);
+        ASSERT_NEAR(mpc::utils::polyderiv(coeffs, x), derivative, 1e-12);
+    }
+
+    ASSERT_DOUBLE_EQ(mpc::utils::polyeval(Eigen::VectorXd(), 1.0), 0.0);
+}
+
+TEST(PolyfitTestSuite, testFixedFit)
+{
+    std::mt19937_64 engine(5);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    for (size_t n = 0; n < 100; n++)
+    {
+        // Rotated reference windows, as the control loop fits them
+        const double theta = dist(engine);
+        Eigen::Matrix<double, 6, 1> xs, ys;
+
+        for (int k = 0; k < 6; k++)
+        {
+            const double shift_x = 0.1 * k + dist(engine) * 0.01;
+            const double shift_y = dist(engine);
+
+            xs[k] = shift_x * cos(theta) + shift_y * sin(theta);
+            ys[k] = -shift_x * sin(theta) + shift_y * cos(theta);
+        }
+
+        const Eigen::VectorXd expected = mpc::utils::polyfit(Eigen::VectorXd(xs), Eigen::VectorXd(ys), 3);
+        const Eigen::Vector4d actual = mpc::utils::polyfit<3, 6>(xs, ys);
+
+        for (int j = 0; j < 4; j++)
+            ASSERT_NEAR(actual[j], expected[j], 1e-9 * std::max(1.0, std::abs(expected[j])));
+    }
+}
@@ -0,0 +1,233 @@
+#include "primary.h"
+#include "model/differential_drive.h"
+#include "utils/json_logger.hpp"
+#include "utils/run_writer.hpp"
+#include "utils/async_output.hpp"
+#include "utils/hdr_histogram.hpp"
+#include "utils/alloc_tracker.hpp"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <json/reader.h>
+#include <thread>
+
+TEST(UtilsTestSuite, testTrajectoryRecording)
+{
+    JsonLogger logger;
+    logger.reserve(10);
+
+    for (size_t i = 0; i < 10; i++)
+        logger.logStep(i, 2.0 * i, 0.1, 0.2, 0.3, 1.0 * i);
+
+    logger.setRecording(false);
+    logger.logStep(100.0, 100.0, 0.0, 0.0, 0.0, 0.0);
+
+    ASSERT_EQ(logger.getTrajectory().size(), 10);
+    ASSERT_DOUBLE_EQ(logger.getTrajectory().y[4], 8.0);
+
+    logger.logWeights(1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0);
+    ASSERT_TRUE(logger.dump("test_trajectory.json"));
+
+    // Same layout plot.py reads
+    Json::Value root;
+    std::ifstream file("test_trajectory.json");
+    ASSERT_TRUE(Json::Reader().parse(file, root));
+
+    ASSERT_EQ(root["x"].size(), 10);
+    ASSERT_DOUBLE_EQ(root["costs"][9].asDouble(), 9.0);
+    ASSERT_DOUBLE_EQ(root["weights"]["acc_d"].asDouble(), 7.0);
+
+    logger.clear();
+    ASSERT_EQ(logger.getTrajectory().size(), 0);
+    ASSERT_FALSE(logger.isRecording());
+
+    std::remove("test_trajectory.json");
+}
+
+TEST(UtilsTestSuite, testRunWriter)
+{
+    Trajectory trajectory;
+    for (size_t i = 0; i < 5; i++)
+    {
+        trajectory.x.push_back(i);
+        trajectory.y.push_back(-1.0 * i);
+        trajectory.vel.push_back(0.1);
+        trajectory.cte.push_back(0.2);
+        trajectory.etheta.push_back(0.3);
+        trajectory.costs.push_back(10.0 * i);
+    }
+
+    {
+        RunWriter writer;
+        ASSERT_TRUE(writer.open("test_run.gnr", false));
+        ASSERT_TRUE(writer.append(1, {1, 2, 3, 4, 5, 6, 7}, trajectory, SolverSummary()));
+    }
+
+    // Resuming keeps the header and the generations already written
+    {
+        RunWriter writer;
+        ASSERT_TRUE(writer.open("test_run.gnr", true));
+        trajectory.costs.back() = -1.0;
+        SolverSummary solver;
+        solver.solves = 5;
+        solver.latencyP99 = 250.0;
+        ASSERT_TRUE(writer.append(2, {7, 6, 5, 4, 3, 2, 1}, trajectory, solver));
+    }
+
+    std::ifstream file("test_run.gnr", std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const size_t chunkSize = sizeof(RunWriter::ChunkHeader) + 6 * 5 * sizeof(double);
+    ASSERT_EQ(bytes.size(), sizeof(RunWriter::FileHeader) + 2 * chunkSize);
+
+    RunWriter::FileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    ASSERT_EQ(header.columns, 6);
+    ASSERT_STREQ(header.names[5], "costs");
+
+    RunWriter::ChunkHeader chunk;
+    const char *second = bytes.data() + sizeof(header) + chunkSize;
+    std::memcpy(&chunk, second, sizeof(chunk));
+    ASSERT_EQ(chunk.generation, 2);
+    ASSERT_EQ(chunk.steps, 5);
+    ASSERT_DOUBLE_EQ(chunk.weights[0], 7.0);
+    ASSERT_EQ(chunk.solver.solves, 5);
+    ASSERT_DOUBLE_EQ(chunk.solver.latencyP99, 250.0);
+
+    // Columns follow each other, the last value of the last column is the last cost
+    double cost;
+    std::memcpy(&cost, second + chunkSize - sizeof(double), sizeof(cost));
+    ASSERT_DOUBLE_EQ(cost, -1.0);
+    file.close();
+
+    // A run killed in the middle of a chunk, the chunks appended on resume must follow the last complete one
+    {
+        std::ofstream partial("test_run.gnr", std::ios::binary | std::ios::app);
+        partial.write(second, sizeof(RunWriter::ChunkHeader) + 10);
+    }
+
+    {
+        RunWriter writer;
+        ASSERT_TRUE(writer.open("test_run.gnr", true));
+        ASSERT_EQ(writer.lastGeneration(), 2);
+
+        // Saved again after resuming, already in the file
+        ASSERT_TRUE(writer.append(2, {1, 1, 1, 1, 1, 1, 1}, trajectory, SolverSummary()));
+        ASSERT_TRUE(writer.append(3, {1, 1, 1, 1, 1, 1, 1}, trajectory, SolverSummary()));
+    }
+
+    std::ifstream resumed("test_run.gnr", std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(resumed), std::istreambuf_iterator<char>());
+
+    ASSERT_EQ(bytes.size(), sizeof(RunWriter::FileHeader) + 3 * chunkSize);
+    std::memcpy(&chunk, bytes.data() + sizeof(header) + 2 * chunkSize, sizeof(chunk));
+    ASSERT_EQ(chunk.generation, 3);
+
+    std::remove("test_run.gnr");
+}
+
+TEST(UtilsTestSuite, testAsyncOutput)
+{
+    SpscQueue<int, 4> queue;
+    for (int i = 0; i < 4; i++)
+        ASSERT_TRUE(queue.push(i));
+
+    int value = 4;
+    ASSERT_FALSE(queue.push(value));
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, 0);
+
+    // More tasks than slots, the producer waits instead of dropping any
+    size_t written = 0;
+    for (size_t i = 0; i < 1000; i++)
+        AsyncOutput::get().post([&written]() { written++; });
+
+    AsyncOutput::get().flush();
+    ASSERT_EQ(written, 1000);
+}
+
+TEST(UtilsTestSuite, testHdrHistogram)
+{
+    HdrHistogram histogram;
+    ASSERT_EQ(histogram.percentile(50.0), 0);
+
+    for (uint64_t value = 1; value <= 10000; value++)
+        histogram.record(value * 1000);
+
+    ASSERT_EQ(histogram.count(), 10000);
+    ASSERT_EQ(histogram.min(), 1000);
+    ASSERT_EQ(histogram.max(), 10000000);
+    ASSERT_DOUBLE_EQ(histogram.mean(), 5000500.0);
+
+    // Within the relative error of the sub-buckets
+    const double error = 1.0 / HdrHistogram::SUB_BUCKETS;
+    ASSERT_NEAR(histogram.percentile(50.0), 5000000.0, 5000000.0 * error);
+    ASSERT_NEAR(histogram.percentile(99.0), 9900000.0, 9900000.0 * error);
+    ASSERT_EQ(histogram.percentile(100.0), 10000000);
+
+    // Small values are exact
+    HdrHistogram small;
+    for (uint64_t value = 0; value < HdrHistogram::SUB_BUCKETS; value++)
+        small.record(value);
+    ASSERT_EQ(small.percentile(50.0), HdrHistogram::SUB_BUCKETS / 2 - 1);
+
+    histogram.merge(small);
+    ASSERT_EQ(histogram.count(), 10000 + HdrHistogram::SUB_BUCKETS);
+    ASSERT_EQ(histogram.min(), 0);
+}
+
+TEST(UtilsTestSuite, testAllocTracker)
+{
+    // Tests link the allocation hooks
+    ASSERT_TRUE(alloc::tracking());
+
+    const alloc::Counts start = alloc::local();
+    {
+        ALLOC_SCOPE("testAllocTracker");
+
+        std::vector<double> v(100);
+        v.push_back(1.0);
+    }
+    const alloc::Counts diff = alloc::local() - start;
+
+    ASSERT_EQ(diff.allocations, 2);
+    ASSERT_EQ(diff.frees, 2);
+    ASSERT_GE(diff.bytes, 100 * sizeof(double));
+
+    bool found = false;
+    for (const auto &site : alloc::sites())
+    {
+        if (std::string(site.name) == "testAllocTracker")
+        {
+            ASSERT_EQ(site.counts.allocations, 2);
+            found = true;
+        }
+    }
+    ASSERT_TRUE(found);
+
+    // Another thread counts into its own slot, the process total includes it after the thread is gone
+    const alloc::Counts total = alloc::total();
+    uint64_t worker = 0;
+
+    std::thread([&worker]() {
+        const alloc::Counts workerStart = alloc::local();
+        std::vector<int> w(10);
+        worker = (alloc::local() - workerStart).allocations;
+    }).join();
+
+    ASSERT_EQ(worker, 1);
+    ASSERT_GE((alloc::total() - total).allocations, 1);
+
+    // The model step of the control loop does not allocate
+    model::DifferentialDrive dModel;
+    dModel.setSampleTime(0.1);
+    dModel.setInitState({-8.0, 1.5, -0.6, 0.0, 0.0, 0.0});
+
+    const alloc::Counts stepStart = alloc::local();
+    for (size_t i = 0; i < 100; i++)
+        dModel.step(0.5, 0.1);
+
+    ASSERT_EQ((alloc::local() - stepStart).allocations, 0);
+}